@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+
+'''Measure the speed (in MIPS) of the Z80 and R800 emulation of one or more
+openMSX executables, e.g. to compare the switch-based and the threaded
+(computed goto) CPU interpreter.
+
+See README.txt for details.
+'''
+
+from argparse import ArgumentParser
+from os import environ, listdir, makedirs, symlink
+from os.path import abspath, dirname, isdir, join
+from tempfile import TemporaryDirectory
+import subprocess
+import sys
+
+scriptDir = dirname(abspath(__file__))
+tclScript = join(scriptDir, 'cpubench.tcl')
+allWorkloads = ('alu', 'memory', 'block', 'calls')
+
+def stageSourceTree(sourceTree, stageDir):
+	'''Create a system data directory for running openMSX from the build
+	tree: 'share' from the source tree, with the C-BIOS machines added (like
+	'make install' does).
+	'''
+	share = join(stageDir, 'share')
+	machines = join(share, 'machines')
+	srcShare = join(sourceTree, 'share')
+	makedirs(machines)
+	for name in listdir(srcShare):
+		if name != 'machines':
+			symlink(abspath(join(srcShare, name)), join(share, name))
+	for srcDir in (join(srcShare, 'machines'), join(sourceTree, 'Contrib', 'cbios')):
+		for name in listdir(srcDir):
+			symlink(abspath(join(srcDir, name)), join(machines, name))
+	return share
+
+def parseExecutable(arg):
+	'''Split 'LABEL=PATH' (or just 'PATH').'''
+	label, sep, path = arg.partition('=')
+	return (label, path) if sep else (arg, arg)
+
+def runOne(options, executable, cpu, machine, env):
+	commands = [
+		'set renderer none',
+		'set ::cpubench_cpu %s' % cpu,
+		'set ::cpubench_time %s' % options.time,
+		'set ::cpubench_workloads {%s}' % ' '.join(options.workloads),
+		]
+	cmd = [executable, '-machine', machine,
+	       '-command', '; '.join(commands), '-script', tclScript]
+	proc = subprocess.run(
+		cmd, stdin=subprocess.DEVNULL, capture_output=True, text=True,
+		env=env, timeout=options.timeout
+		)
+	results = {}
+	for line in proc.stdout.splitlines():
+		words = line.split()
+		if len(words) == 4 and words[0] == 'cpubench':
+			results[words[2]] = float(words[3])
+	if proc.returncode != 0 or len(results) != len(options.workloads):
+		sys.stderr.write('Running %s on %s failed:\n%s%s' % (
+			executable, machine, proc.stdout, proc.stderr))
+		return None
+	return results
+
+def main():
+	parser = ArgumentParser(
+		description='Measure the CPU emulation speed of openMSX.')
+	parser.add_argument('--openmsx', action='append', default=[],
+		metavar='[LABEL=]PATH',
+		help='openMSX executable, can be repeated to compare builds '
+		     '(default: openmsx)')
+	parser.add_argument('--z80-machine', default='C-BIOS_MSX2+',
+		help='machine for the Z80 measurements (default: %(default)s)')
+	parser.add_argument('--r800-machine',
+		help='MSX turbo R machine for the R800 measurements, e.g. '
+		     'Panasonic_FS-A1GT (default: no R800 measurements)')
+	parser.add_argument('--time', type=float, default=3.0,
+		help='host time in seconds per workload (default: %(default)s)')
+	parser.add_argument('--timeout', type=float, default=300.0,
+		help='maximum host time in seconds per run (default: %(default)s)')
+	parser.add_argument('--workloads', nargs='+', default=list(allWorkloads),
+		choices=allWorkloads, metavar='NAME',
+		help='workloads to run (default: all of %s)' % ', '.join(allWorkloads))
+	parser.add_argument('--source-tree', metavar='DIR',
+		help='run executables from the build tree, using the data files '
+		     'of the given source tree')
+	parser.add_argument('--training', action='store_true',
+		help='only run the workloads (e.g. to collect a profile for '
+		     'profile-guided optimization), with a shorter default time')
+	options = parser.parse_args()
+	if options.training and '--time' not in sys.argv:
+		options.time = 1.0
+
+	executables = [parseExecutable(arg) for arg in (options.openmsx or ['openmsx'])]
+	runs = [('z80', options.z80_machine)]
+	if options.r800_machine:
+		runs.append(('r800', options.r800_machine))
+
+	env = dict(environ)
+	env.setdefault('SDL_AUDIODRIVER', 'dummy')
+	env.setdefault('SDL_VIDEODRIVER', 'dummy')
+	with TemporaryDirectory() as stageDir:
+		if options.source_tree:
+			if not isdir(join(options.source_tree, 'share')):
+				parser.error('not a source tree: %s' % options.source_tree)
+			env['OPENMSX_SYSTEM_DATA'] = stageSourceTree(
+				options.source_tree, stageDir)
+
+		# results[(cpu, workload)][label]
+		results = {}
+		failed = False
+		for label, path in executables:
+			for cpu, machine in runs:
+				mips = runOne(options, path, cpu, machine, env)
+				if mips is None:
+					failed = True
+					continue
+				for workload, value in mips.items():
+					results.setdefault((cpu, workload), {})[label] = value
+
+	if not options.training:
+		labels = [label for label, _ in executables]
+		print('%-5s %-8s' % ('cpu', 'workload')
+		      + ''.join(' %12s' % label for label in labels) + '   (MIPS)')
+		for cpu, _ in runs:
+			for workload in options.workloads:
+				values = results.get((cpu, workload), {})
+				print('%-5s %-8s' % (cpu, workload) + ''.join(
+					' %12.2f' % values[label] if label in values else ' %12s' % '-'
+					for label in labels))
+	return 1 if failed else 0
+
+if __name__ == '__main__':
+	sys.exit(main())
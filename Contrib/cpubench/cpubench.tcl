@@ -0,0 +1,129 @@
+# cpubench.tcl -- helper script for cpubench.py
+#
+# This script is passed to the openMSX process started by cpubench.py (via
+# '-script cpubench.tcl'). It should NOT be installed in the
+# ~/.openmsx/share/scripts directory.
+#
+# cpubench.py sets these variables (via '-command') before this script runs:
+#   ::cpubench_cpu        z80 or r800 (the latter requires an MSX turbo R)
+#   ::cpubench_time       host time (in seconds) to measure each workload
+#   ::cpubench_workloads  names of the workloads to run (see below)
+#
+# After booting the machine, each workload is copied to RAM (page 3) and the
+# CPU is pointed to it. Each workload is an endless loop that increments a
+# 32-bit counter at 0xE000 once per iteration. Comparing that counter before
+# and after the measurement interval gives the number of executed
+# instructions, for each result a line like this is printed:
+#   cpubench <cpu> <workload> <MIPS>
+# After the last workload openMSX exits with exit code 0.
+
+namespace eval cpubench {
+
+# name {<instructions per iteration> <hex code>}
+#  The instruction counts don't include the loop overhead (3 instructions).
+#  Repeated block instructions (e.g. LDIR) count once per repetition.
+variable workloads {
+	alu {20 {
+		78 81 AA 47 0C 15 07 5F 93 E63F B0 CE11 19 EB 13 FE80 2800 3800
+		ED44 2F
+	}}
+	memory {22 {
+		DD2100E1 DD7E01 DD7702 2110E1 5E 23 56 ED5320E1 ED4B20E1 71
+		3A30E1 3C 3230E1 FD2140E1 FD3403 FD8604 E5 C5 D1 E1 2A10E1
+		2250E1
+	}}
+	block {49 {
+		2100E1 1100E2 011000 EDB0
+		2100E1 011000 3E55 EDB1
+		210FE2 111FE2 010800 EDB8
+	}}
+	calls {38 {
+		CD00C8 F5 D9 CD00C8 D9 F1 08 CD00C8 08 ED4A ED42 DDE5 DDE1
+		CD00C8
+	}}
+}
+
+# Called by the 'calls' workload: 6 instructions, including RET.
+variable subroutine {CB27 CB5F CBC8 CB88 CB19 C9}
+
+proc hex_to_binary {hex} {
+	binary format H* [string map {" " "" "\n" "" "\t" ""} $hex]
+}
+
+proc read_counter {} {
+	binary scan [debug read_block memory 0xE000 4] iu count
+	return $count
+}
+
+proc load_workload {code} {
+	variable subroutine
+	# clear the counter and the data area
+	debug write_block memory 0xE000 [string repeat "\0" 0x400]
+	debug write_block memory 0xC800 [hex_to_binary $subroutine]
+	set prologue "F3 3100F0"                 ;# di ; ld sp,0xF000
+	set epilogue "2100E0 34 C204C0 23 34 C204C0 23 34 C204C0 23 34 C304C0"
+	                                          ;# 32-bit increment of (0xE000)
+	debug write_block memory 0xC000 [hex_to_binary "$prologue $code $epilogue"]
+	reg pc 0xC000
+}
+
+proc select_cpu {} {
+	if {$::cpubench_cpu eq "r800"} {
+		if {"r800.pendingIRQ" ni [debug probe list]} {
+			puts stderr "This machine has no R800."
+			exit 1
+		}
+		# S1990 register 6: R800 in DRAM mode
+		debug write ioports 0xE4 6
+		debug write ioports 0xE5 0x00
+	}
+}
+
+proc start {} {
+	variable queue $::cpubench_workloads
+	select_cpu
+	next_workload
+}
+
+proc next_workload {} {
+	variable workloads
+	variable queue
+	if {![llength $queue]} {
+		exit 0
+	}
+	set queue [lassign $queue name]
+	if {![dict exists $workloads $name]} {
+		puts stderr "Unknown workload: $name"
+		exit 1
+	}
+	lassign [dict get $workloads $name] count code
+	load_workload $code
+	# skip the first (partial) frame, e.g. when the CPU was halted
+	after realtime 0.2 [namespace code [list measure_start $name $count]]
+}
+
+proc measure_start {name count} {
+	set t0 [clock microseconds]
+	set c0 [read_counter]
+	after realtime $::cpubench_time [namespace code [list measure_stop $name $count $t0 $c0]]
+}
+
+proc measure_stop {name count t0 c0} {
+	set c1 [read_counter]
+	set t1 [clock microseconds]
+	set iterations [expr {($c1 - $c0) & 0xFFFFFFFF}]
+	set mips [expr {double($iterations) * ($count + 3) / ($t1 - $t0)}]
+	puts stdout [format "cpubench %s %s %.2f" $::cpubench_cpu $name $mips]
+	flush stdout
+	next_workload
+}
+
+# Run headless and as fast as possible.
+set ::save_settings_on_exit false
+set ::throttle off
+set ::mute on
+
+# give the BIOS some time to initialize the machine (e.g. select RAM in page 3)
+after time 3 cpubench::start
+
+} ;# namespace cpubench
@@ -7,7 +7,7 @@
 
 # All actions we want to expose to the user.
 USER_ACTIONS:=\
-	3rdparty all app bindist clean createsubs dist install probe run \
+	3rdparty all app bindist clean createsubs dist install pgo probe run \
 	staticbindist
 
 # Mark all actions as logical targets.
@@ -0,0 +1,31 @@
+# Profile guided optimisation flavour.
+# Don't select this flavour directly, use 'make pgo' instead. That target
+# builds this flavour twice: first an instrumented executable, which runs the
+# CPU benchmark workloads from Contrib/cpubench to collect a profile, and then
+# the final executable, optimised using that profile.
+# Only supported with gcc.
+
+# Start with generic optimisation flags.
+include build/flavour-opt.mk
+
+# Also use the threaded CPU interpreter, see build/flavour-threaded.mk.
+PGO_COMPUTED_GOTO?=true
+$(call BOOLCHECK,PGO_COMPUTED_GOTO)
+ifeq ($(PGO_COMPUTED_GOTO),true)
+CXXFLAGS+=-DUSE_COMPUTED_GOTO
+endif
+
+# Either 'generate' (instrumented build) or 'use' (optimised build).
+PGO_PHASE?=use
+ifeq ($(PGO_PHASE),generate)
+COMPILE_FLAGS+=-fprofile-generate -fprofile-update=prefer-atomic
+LINK_FLAGS+=-fprofile-generate
+# The instrumented executable is only used for training.
+OPENMSX_STRIP:=false
+else ifeq ($(PGO_PHASE),use)
+# Code that didn't run during training (most of the emulator) is optimised as
+# usual instead of for size.
+COMPILE_FLAGS+=-fprofile-use -fprofile-partial-training -Wno-missing-profile
+else
+$(error Value of PGO_PHASE must be either "generate" or "use": $(PGO_PHASE))
+endif
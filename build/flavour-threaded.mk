@@ -0,0 +1,10 @@
+# Generic optimisation flavour, with the threaded (computed goto) CPU
+# interpreter instead of the switch based one.
+
+# Start with generic optimisation flags.
+include build/flavour-opt.mk
+
+# Use computed goto's to dispatch the Z80/R800 instructions, see the comments
+# in build/flavour-super-opt.mk and src/cpu/CPUCore.cc. This requires gcc or
+# clang. Use Contrib/cpubench to check whether it's faster on your host CPU.
+CXXFLAGS+=-DUSE_COMPUTED_GOTO
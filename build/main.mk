@@ -602,6 +602,31 @@ dist:
 	$(CMD)$(PYTHON) build/gitdist.py
 
 
+# Profile Guided Optimisation
+# ===========================
+
+# Build the "pgo" flavour in two phases, with a training run in between.
+# The result is $(PGO_BUILD_PATH)/bin/$(BINARY_FILE).
+PGO_BUILD_PATH:=derived/$(PLATFORM)-pgo
+PGO_MAKE:=$(MAKE) -f build/main.mk all \
+	OPENMSX_TARGET_CPU=$(OPENMSX_TARGET_CPU) \
+	OPENMSX_TARGET_OS=$(OPENMSX_TARGET_OS) \
+	OPENMSX_FLAVOUR=pgo \
+	PYTHON=$(PYTHON)
+
+pgo:
+	$(SUM) "Building instrumented executable..."
+	$(CMD)find $(PGO_BUILD_PATH) -name '*.gcda' -delete 2>/dev/null || true
+	$(PGO_MAKE) PGO_PHASE=generate
+	$(SUM) "Collecting profile..."
+	$(CMD)$(PYTHON) Contrib/cpubench/cpubench.py --training --source-tree . \
+		--openmsx $(PGO_BUILD_PATH)/bin/$(BINARY_FILE)
+	$(SUM) "Building optimised executable..."
+	$(CMD)find $(PGO_BUILD_PATH)/obj -name '*.o' -delete
+	$(CMD)rm -f $(PGO_BUILD_PATH)/bin/$(BINARY_FILE)
+	$(PGO_MAKE) PGO_PHASE=use
+
+
 # Binary Packaging Using 3rd Party Libraries
 # ==========================================
 
@@ -27,7 +27,11 @@ GlobalSettings::GlobalSettings(GlobalCommandController& commandController_)
 		ResampledSoundDevice::ResampleType::HQ,
 		EnumSetting<ResampledSoundDevice::ResampleType>::Map{
 			{"hq",   ResampledSoundDevice::ResampleType::HQ},
+			{"mq",   ResampledSoundDevice::ResampleType::MQ},
 			{"blip", ResampledSoundDevice::ResampleType::BLIP}})
+	, reverseMemoryLimitSetting(commandController, "reverse_memory_limit",
+		"maximum amount of memory (in MB) used by the reverse history of "
+		"one machine, 0 means no limit", 0, 0, 1024 * 1024)
 	, speedManager(commandController)
 	, throttleManager(commandController)
 {
@@ -49,6 +49,9 @@ public:
 	[[nodiscard]] EnumSetting<ResampledSoundDevice::ResampleType>& getResampleSetting() {
 		return resampleSetting;
 	}
+	[[nodiscard]] IntegerSetting& getReverseMemoryLimitSetting() {
+		return reverseMemoryLimitSetting;
+	}
 	[[nodiscard]] SpeedManager& getSpeedManager() {
 		return speedManager;
 	}
@@ -70,6 +73,7 @@ private:
 	StringSetting  invalidPsgDirectionsSetting;
 	StringSetting  invalidPpiModeSetting;
 	EnumSetting<ResampledSoundDevice::ResampleType> resampleSetting;
+	IntegerSetting reverseMemoryLimitSetting;
 	SpeedManager speedManager;
 	ThrottleManager throttleManager;
 };
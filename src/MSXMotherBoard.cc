@@ -39,7 +39,12 @@
 #include "Scheduler.hh"
 #include "SimpleDebuggable.hh"
 #include "StateChangeDistributor.hh"
+#include "TclArgParser.hh"
 #include "TclObject.hh"
+#include "Timer.hh"
+#include "VDP.hh"
+#include "VDPCmdEngine.hh"
+#include "VGMRecorder.hh"
 #include "XMLElement.hh"
 #include "serialize.hh"
 #include "serialize_stl.hh"
@@ -126,6 +131,17 @@ private:
 	MSXMotherBoard& motherBoard;
 };
 
+class BenchmarkCmd final : public Command
+{
+public:
+	explicit BenchmarkCmd(MSXMotherBoard& motherBoard);
+	void execute(std::span<const TclObject> tokens, TclObject& result) override;
+	[[nodiscard]] std::string help(std::span<const TclObject> tokens) const override;
+	void tabCompletion(std::vector<std::string>& tokens) const override;
+private:
+	MSXMotherBoard& motherBoard;
+};
+
 class MachineNameInfo final : public InfoTopic
 {
 public:
@@ -240,12 +256,14 @@ MSXMotherBoard::MSXMotherBoard(Reactor& reactor_)
 {
 	slotManager = std::make_unique<CartridgeSlotManager>(*this);
 	reverseManager = std::make_unique<ReverseManager>(*this);
+	vgmRecorder = std::make_unique<VGMRecorder>(*this);
 	resetCommand = std::make_unique<ResetCmd>(*this);
 	loadMachineCommand = std::make_unique<LoadMachineCmd>(*this);
 	listExtCommand = std::make_unique<ListExtCmd>(*this);
 	extCommand = std::make_unique<ExtCmd>(*this, "ext");
 	removeExtCommand = std::make_unique<RemoveExtCmd>(*this);
 	storeSetupCommand = std::make_unique<StoreSetupCmd>(*this);
+	benchmarkCommand = std::make_unique<BenchmarkCmd>(*this);
 	machineNameInfo = std::make_unique<MachineNameInfo>(*this);
 	machineTypeInfo = std::make_unique<MachineTypeInfo>(*this);
 	machineExtensionInfo = std::make_unique<MachineExtensionInfo>(*this);
@@ -622,6 +640,7 @@ bool MSXMotherBoard::execute()
 	}
 	assert(getMachineConfig()); // otherwise powered cannot be true
 
+	ScopedAssign sa(emulating, true);
 	getCPU().execute(false);
 	return true;
 }
@@ -633,7 +652,8 @@ void MSXMotherBoard::fastForward(EmuTime time, bool fast)
 
 	if (time <= getCurrentTime()) return;
 
-	ScopedAssign sa(fastForwarding, fast);
+	ScopedAssign sa1(emulating, true);
+	ScopedAssign sa2(fastForwarding, fast);
 	realTime->disable();
 	msxMixer->mute();
 	fastForwardHelper->setTarget(time);
@@ -1089,6 +1109,132 @@ void StoreSetupCmd::tabCompletion(std::vector<std::string>& tokens) const
 }
 
 
+// BenchmarkCmd
+
+BenchmarkCmd::BenchmarkCmd(MSXMotherBoard& motherBoard_)
+	: Command(motherBoard_.getCommandController(), "benchmark")
+	, motherBoard(motherBoard_)
+{
+}
+
+void BenchmarkCmd::execute(std::span<const TclObject> tokens, TclObject& result)
+{
+	bool noRender = false;
+	bool noSound = false;
+	std::array info = {
+		flagArg("-norender", noRender),
+		flagArg("-nosound", noSound),
+	};
+	auto& interp = getInterpreter();
+	auto arguments = parseTclArgs(interp, tokens.subspan(1), info);
+	if (arguments.size() != 1) throw SyntaxError();
+	double duration = arguments[0].getDouble(interp);
+	if (!(duration > 0.0)) {
+		throw CommandException("Duration must be positive.");
+	}
+	if (!motherBoard.isPowered()) {
+		throw CommandException("The MSX machine is not powered on.");
+	}
+	if (motherBoard.isEmulating()) {
+		// e.g. executed from an 'after time' callback, we can't run
+		// the emulation loop recursively
+		throw CommandException(
+			"Can't run a benchmark while the emulation is running.");
+	}
+
+	auto& cpu = motherBoard.getCPU();
+	auto& scheduler = motherBoard.getScheduler();
+	auto& mixer = motherBoard.getMSXMixer();
+	auto* vdp = dynamic_cast<VDP*>(motherBoard.findDevice("VDP"));
+	auto getNumVdpCommands = [&] {
+		return vdp ? vdp->getCmdEngine().getNumCommands() : uint64_t(0);
+	};
+
+	EmuTime startTime = motherBoard.getCurrentTime();
+	auto startM1Cycles = cpu.getRefreshCount();
+	auto startVdpCommands = getNumVdpCommands();
+	auto startSched = scheduler.getStats();
+	auto startSound = mixer.getStats();
+	unsigned cpuFreq = cpu.getActiveFreq();
+
+	scheduler.setMeasureHostTime(true);
+	mixer.setMeasureStats(true);
+	// Like during 'reverse goto', this skips the sound generation of all
+	// devices whose emulation doesn't depend on it (see
+	// SoundDevice::needsGenerateWhileSeeking()), so the emulated machine
+	// behaves exactly as in a run with sound.
+	if (noSound) mixer.setSeeking(true);
+	auto startHostTime = Timer::getTime();
+
+	// Like 'reverse goto', this runs unthrottled and without rendering
+	// (when requested) but keeps on emulating all the devices.
+	motherBoard.fastForward(startTime + EmuDuration::sec(duration), noRender);
+
+	auto hostTime = Timer::getTime() - startHostTime;
+	if (noSound) mixer.setSeeking(false);
+	mixer.setMeasureStats(false);
+	scheduler.setMeasureHostTime(false);
+
+	double emuSec = (motherBoard.getCurrentTime() - startTime).toDouble();
+	double hostSec = std::max(double(hostTime), 1.0) * 1e-6;
+	auto m1Cycles = cpu.getRefreshCount() - startM1Cycles;
+	auto vdpCommands = getNumVdpCommands() - startVdpCommands;
+	const auto& sched = scheduler.getStats();
+	const auto& sound = mixer.getStats();
+	auto syncPoints = sched.numSyncPoints - startSched.numSyncPoints;
+	auto samples = sound.samples - startSound.samples;
+	auto syncTime = sched.hostTime - startSched.hostTime;
+	auto soundTime = sound.hostTime - startSound.hostTime;
+
+	// Per subsystem host time (approximately, e.g. sound that's generated
+	// as a result of an I/O write from the CPU is counted twice). Device
+	// sync points include rendering and most of the sound generation.
+	TclObject subsystems;
+	subsystems.addDictKeyValue("cpu",
+		double(hostTime - std::min(hostTime, syncTime)) * 1e-6);
+	subsystems.addDictKeyValue("devices",
+		double(syncTime - std::min(syncTime, soundTime)) * 1e-6);
+	subsystems.addDictKeyValue("sound", double(soundTime) * 1e-6);
+
+	result.addDictKeyValue("emu_time", emuSec);
+	result.addDictKeyValue("host_time", hostSec);
+	result.addDictKeyValue("speed", emuSec / hostSec);
+	result.addDictKeyValue("emulated_mhz", emuSec * cpuFreq / hostSec * 1e-6);
+	result.addDictKeyValue("m1_cycles", m1Cycles);
+	result.addDictKeyValue("m1_cycles_per_sec", double(m1Cycles) / hostSec);
+	result.addDictKeyValue("sync_points", syncPoints);
+	result.addDictKeyValue("sync_points_per_sec", double(syncPoints) / hostSec);
+	result.addDictKeyValue("vdp_commands", vdpCommands);
+	result.addDictKeyValue("vdp_commands_per_sec", double(vdpCommands) / hostSec);
+	result.addDictKeyValue("sound_samples", samples);
+	result.addDictKeyValue("sound_samples_per_sec", double(samples) / hostSec);
+	result.addDictKeyValue("subsystem_time", subsystems);
+}
+
+std::string BenchmarkCmd::help(std::span<const TclObject> /*tokens*/) const
+{
+	return
+		"benchmark <seconds> [-norender] [-nosound]\n"
+		"Emulates the given amount of (emulated) time as fast as possible "
+		"and returns a dictionary with statistics about the emulation "
+		"speed: emulated and host time, emulated MHz, the number of "
+		"CPU M1 (opcode fetch) cycles, sync points, VDP commands and sound "
+		"samples (both total and per host second), and the host time "
+		"spent per subsystem. This can't be used while the emulation is "
+		"running (e.g. from an 'after time' callback).\n"
+		"  -norender  don't render the video output\n"
+		"  -nosound   don't generate sound (except for devices whose "
+		"emulation depends on it)\n";
+}
+
+void BenchmarkCmd::tabCompletion(std::vector<std::string>& tokens) const
+{
+	using namespace std::literals;
+	static constexpr std::array options = {"-norender"sv, "-nosound"sv};
+	completeString(tokens, options);
+}
+
+
 // MachineNameInfo
 
 MachineNameInfo::MachineNameInfo(MSXMotherBoard& motherBoard_)
@@ -19,6 +19,7 @@
 namespace openmsx {
 
 class AddRemoveUpdate;
+class BenchmarkCmd;
 class CartridgeSlotManager;
 class CassettePortInterface;
 class CommandController;
@@ -60,6 +61,7 @@ class ReverseManager;
 class SettingObserver;
 class Scheduler;
 class StateChangeDistributor;
+class VGMRecorder;
 
 class MediaProvider
 {
@@ -136,6 +138,10 @@ public:
 	void activate(bool active);
 	[[nodiscard]] bool isActive() const { return active; }
 	[[nodiscard]] bool isFastForwarding() const { return fastForwarding; }
+	/** Is execute() or fastForward() in progress? E.g. a command executed
+	  * from an 'after time' callback runs inside the emulation loop.
+	  */
+	[[nodiscard]] bool isEmulating() const { return emulating; }
 
 	[[nodiscard]] uint8_t readIRQVector() const;
 
@@ -178,6 +184,7 @@ public:
 	[[nodiscard]] RenShaTurbo& getRenShaTurbo();
 	[[nodiscard]] LedStatus& getLedStatus();
 	[[nodiscard]] ReverseManager& getReverseManager() { return *reverseManager; }
+	[[nodiscard]] VGMRecorder& getVGMRecorder() { return *vgmRecorder; }
 	[[nodiscard]] Reactor& getReactor() { return reactor; }
 	[[nodiscard]] VideoSourceSetting& getVideoSource() { return videoSourceSetting; }
 	[[nodiscard]] BooleanSetting& suppressMessages() { return suppressMessagesSetting; }
@@ -327,12 +334,14 @@ private:
 
 	std::unique_ptr<CartridgeSlotManager> slotManager;
 	std::unique_ptr<ReverseManager> reverseManager;
+	std::unique_ptr<VGMRecorder> vgmRecorder;
 	std::unique_ptr<ResetCmd>     resetCommand;
 	std::unique_ptr<LoadMachineCmd> loadMachineCommand;
 	std::unique_ptr<ListExtCmd>   listExtCommand;
 	std::unique_ptr<ExtCmd>       extCommand;
 	std::unique_ptr<RemoveExtCmd> removeExtCommand;
 	std::unique_ptr<StoreSetupCmd> storeSetupCommand;
+	std::unique_ptr<BenchmarkCmd> benchmarkCommand;
 	std::unique_ptr<MachineNameInfo> machineNameInfo;
 	std::unique_ptr<MachineTypeInfo> machineTypeInfo;
 	std::unique_ptr<MachineExtensionInfo> machineExtensionInfo;
@@ -350,6 +359,7 @@ private:
 	bool powered = false;
 	bool active = false;
 	bool fastForwarding = false;
+	bool emulating = false;
 };
 SERIALIZE_CLASS_VERSION(MSXMotherBoard, 5);
 
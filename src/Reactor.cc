@@ -20,6 +20,7 @@
 #include "GlobalCommandController.hh"
 #include "GlobalSettings.hh"
 #include "HardwareConfig.hh"
+#include "HostProfilerCommand.hh"
 #include "ImGuiManager.hh"
 #include "InfoTopic.hh"
 #include "InputEventGenerator.hh"
@@ -35,6 +36,7 @@
 #include "SymbolManager.hh"
 #include "TclCallbackMessages.hh"
 #include "TclObject.hh"
+#include "ThreadPool.hh"
 #include "UserSettings.hh"
 #include "VideoSystem.hh"
 #include "XMLElement.hh"
@@ -284,6 +286,7 @@ void Reactor::init()
 	setClipboardCommand = std::make_unique<SetClipboardCommand>(
 		*globalCommandController, *this);
 	aviRecordCommand = std::make_unique<AviRecorder>(*this);
+	hostProfilerCommand = std::make_unique<HostProfilerCommand>(*globalCommandController);
 	extensionInfo = std::make_unique<ConfigInfo>(
 		getOpenMSXInfoCommand(), "extensions");
 	machineInfo   = std::make_unique<ConfigInfo>(
@@ -343,6 +346,15 @@ Mixer& Reactor::getMixer()
 	return *mixer;
 }
 
+ThreadPool& Reactor::getWorkerPool()
+{
+	if (!workerPool) {
+		workerPool = std::make_unique<ThreadPool>(
+			ThreadPool::getDefaultNumThreads());
+	}
+	return *workerPool;
+}
+
 RomDatabase& Reactor::getSoftwareDatabase()
 {
 	if (!softwareDatabase) {
@@ -37,6 +37,7 @@ class GetClipboardCommand;
 class GlobalCliComm;
 class GlobalCommandController;
 class GlobalSettings;
+class HostProfilerCommand;
 class HotKey;
 class ImGuiManager;
 class InfoCommand;
@@ -61,6 +62,7 @@ class StoreMachineCommand;
 class SymbolManager;
 class TclCallbackMessages;
 class TestMachineCommand;
+class ThreadPool;
 class UserSettings;
 
 extern int exitCode;
@@ -100,6 +102,7 @@ public:
 	[[nodiscard]] InputEventGenerator& getInputEventGenerator() { return *inputEventGenerator; }
 	[[nodiscard]] Display& getDisplay() { assert(display); return *display; }
 	[[nodiscard]] Mixer& getMixer();
+	[[nodiscard]] ThreadPool& getWorkerPool();
 	[[nodiscard]] DiskFactory& getDiskFactory() { return *diskFactory; }
 	[[nodiscard]] DiskManipulator& getDiskManipulator() { return *diskManipulator; }
 	[[nodiscard]] EnumSetting<int>& getDefaultMachineSetting() { return *defaultMachineSetting; }
@@ -179,6 +182,7 @@ private:
 	std::unique_ptr<DiskManipulator> diskManipulator;
 	std::unique_ptr<DiskChanger> virtualDrive;
 	std::unique_ptr<FilePool> filePool;
+	std::unique_ptr<ThreadPool> workerPool; // lazy initialized, before boards
 
 	std::unique_ptr<EnumSetting<int>> defaultMachineSetting;
 	std::unique_ptr<StringSetting> defaultSetupSetting;
@@ -202,6 +206,7 @@ private:
 	std::unique_ptr<GetClipboardCommand> getClipboardCommand;
 	std::unique_ptr<SetClipboardCommand> setClipboardCommand;
 	std::unique_ptr<AviRecorder> aviRecordCommand;
+	std::unique_ptr<HostProfilerCommand> hostProfilerCommand;
 	std::unique_ptr<ConfigInfo> extensionInfo;
 	std::unique_ptr<ConfigInfo> machineInfo;
 	std::unique_ptr<RealTimeInfo> realTimeInfo;
@@ -8,6 +8,7 @@
 #include "EventDistributor.hh"
 #include "FileContext.hh"
 #include "FileOperations.hh"
+#include "GlobalSettings.hh"
 #include "Keyboard.hh"
 #include "MSXCliComm.hh"
 #include "MSXCommandController.hh"
@@ -18,6 +19,7 @@
 #include "StateChangeDistributor.hh"
 #include "TclArgParser.hh"
 #include "TclObject.hh"
+#include "ThreadPool.hh"
 #include "Timer.hh"
 #include "XMLException.hh"
 #include "serialize.hh"
@@ -26,7 +28,9 @@
 #include "format.hh"
 #include "narrow.hh"
 #include "one_of.hh"
+#include "stl.hh"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cmath>
@@ -39,6 +43,10 @@ using namespace std::literals;
 // Time between two snapshots (in seconds)
 static constexpr double SNAPSHOT_PERIOD = 1.0;
 
+// Snapshots older than this get recompressed with a slower algorithm that
+// gives a better compression ratio (going back that far is rare).
+static constexpr auto RECOMPRESS_AGE = EmuDuration::sec(60.0);
+
 // Max number of snapshots in a replay file
 static constexpr unsigned MAX_NOF_SNAPSHOTS = 10;
 
@@ -102,19 +110,57 @@ SERIALIZE_CLASS_VERSION(Replay, 4);
 
 // struct ReverseHistory
 
-void ReverseManager::ReverseHistory::swap(ReverseHistory& other) noexcept
+void ReverseManager::ReverseHistory::swap(ReverseHistory& other)
 {
+	// the pending work (and 'memory') belongs to the current chunks
+	waitForPendingWork();
+	other.waitForPendingWork();
 	std::swap(chunks, other.chunks);
 	std::swap(events, other.events);
+	std::swap(memory, other.memory);
 }
 
 void ReverseManager::ReverseHistory::clear()
 {
+	waitForPendingWork();
 	// clear() and free storage capacity
 	Chunks().swap(chunks);
 	Events().swap(events);
+	memory = MemoryStats{};
+}
+
+void ReverseManager::ReverseHistory::waitForPendingWork()
+{
+	if (!pendingWorkerTime) return;
+	for (auto& f : pendingWork) f.get();
+	pendingWork.clear();
+	stats.lastWorkerTime = *pendingWorkerTime;
+	stats.totalWorkerTime += stats.lastWorkerTime;
+	pendingWorkerTime.reset();
 }
 
+void ReverseManager::ReverseHistory::calcMemoryUsage()
+{
+	assert(pendingWork.empty());
+	memory.used = 0;
+	memory.raw = 0;
+	// Blocks can be shared between chunks, only count them once.
+	std::vector<const DeltaBlock*> blocks;
+	for (const auto& [idx, chunk] : chunks) {
+		memory.used += chunk.savestate.size();
+		memory.raw  += chunk.savestate.size();
+		for (const auto& block : chunk.deltaBlocks) {
+			blocks.push_back(block.get());
+			blocks.push_back(&block->getReference());
+			memory.raw += block->getRawSize();
+		}
+	}
+	std::ranges::sort(blocks);
+	blocks.erase(std::ranges::unique(blocks).begin(), blocks.end());
+	for (const auto* block : blocks) {
+		memory.used += block->getMemorySize();
+	}
+}
 
 class EndLogEvent final : public StateChange
 {
@@ -248,6 +294,19 @@ void ReverseManager::status(TclObject& result) const
 	}
 	EmuTime le(isCollecting() && (lastEvent != rend(history.events)) ? (*lastEvent)->getTime() : EmuTime::zero());
 	result.addDictKeyValue("last_event", le.toDouble());
+
+	// Note: these are updated when a snapshot is taken (so they don't yet
+	// include the most recent snapshot).
+	const auto& memory = history.memory;
+	result.addDictKeyValue("memory_usage", uint64_t(memory.used));
+	result.addDictKeyValue("compression_ratio",
+		memory.used ? double(memory.raw) / double(memory.used) : 0.0);
+	result.addDictKeyValue("evicted_snapshots", memory.evicted);
+	result.addDictKeyValue("recompressed_blocks", memory.recompressed);
+
+	// Speed of the fast-forward part of the last 'reverse goto' (as a
+	// factor of real-time speed).
+	result.addDictKeyValue("seek_speed", lastSeek.getSpeed());
 }
 
 void ReverseManager::debugInfo(TclObject& result) const
@@ -265,6 +324,17 @@ void ReverseManager::debugInfo(TclObject& result) const
 		totalSize += chunk.savestate.size();
 	}
 	strAppend(res, "total size: ", totalSize, '\n');
+	// Note: worker time of the most recent snapshot is only included once
+	// that work has finished.
+	const auto& stats = history.stats;
+	auto avg = [&](uint64_t total) { return stats.count ? total / stats.count : 0; };
+	strAppend(res, "snapshots taken: ", stats.count, '\n',
+	          "main thread time per snapshot: last ", stats.lastMainTime,
+	          "us, average ", avg(stats.totalMainTime), "us\n",
+	          "worker time per snapshot: last ", stats.lastWorkerTime,
+	          "us, average ", avg(stats.totalWorkerTime), "us\n",
+	          "last seek: ", lastSeek.emuTime, "s emulated in ",
+	          lastSeek.hostTime, "us (", lastSeek.getSpeed(), "x)\n");
 	result = res;
 }
 
@@ -334,6 +404,7 @@ void ReverseManager::goTo(
 	bool sameTimeLine)
 {
 	auto& mixer = motherBoard.getMSXMixer();
+	hist.waitForPendingWork();
 	try {
 		// The call to MSXMotherBoard::fastForward() below may take
 		// some time to execute. The DirectX sound driver has a problem
@@ -447,10 +518,15 @@ void ReverseManager::goTo(
 		// time divide the remaining time in half and make a snapshot
 		// there.
 		auto lastProgress = Timer::getTime();
+		auto seekStartTime = lastProgress;
 		auto startMSXTime = newBoard->getCurrentTime();
 		auto lastSnapshotTarget = startMSXTime;
 		bool everShowedProgress = false;
 		syncNewSnapshot.removeSyncPoint(); // don't schedule new snapshot takings during fast forward
+		// Nothing is rendered during this fast-forward (see
+		// MSXMotherBoard::isFastForwarding()), also skip sound generation.
+		auto& newMixer = newBoard->getMSXMixer();
+		newMixer.setSeeking(true);
 		while (true) {
 			auto currentTimeNewBoard = newBoard->getCurrentTime();
 			auto nextSnapshotTarget = std::min(
@@ -482,6 +558,11 @@ void ReverseManager::goTo(
 				lastSnapshotTarget = nextSnapshotTarget;
 			}
 		}
+		newMixer.setSeeking(false);
+		auto& seek = newBoard->getReverseManager().lastSeek;
+		seek.emuTime = (newBoard->getCurrentTime() - startMSXTime).toDouble();
+		seek.hostTime = Timer::getTime() - seekStartTime;
+
 		// re-enable messages
 		newBoard->getMSXCliComm().setSuppressMessages(false);
 		// re-enable automatic snapshots
@@ -510,6 +591,7 @@ void ReverseManager::goTo(
 		assert(newBoard->getReverseManager().isCollecting());
 	} catch (MSXException&) {
 		// Make sure mixer doesn't stay muted in case of error.
+		mixer.setSeeking(false);
 		mixer.unmute();
 		throw;
 	}
@@ -544,6 +626,7 @@ void ReverseManager::transferState(MSXMotherBoard& newBoard)
 void ReverseManager::saveReplay(
 	Interpreter& interp, std::span<const TclObject> tokens, TclObject& result)
 {
+	history.waitForPendingWork();
 	const auto& chunks = history.chunks;
 	if (chunks.empty()) {
 		throw CommandException("No recording...");
@@ -767,6 +850,7 @@ void ReverseManager::transferHistory(ReverseHistory& oldHistory,
 	assert(history.chunks.empty());
 
 	// 'ids' for old and new serialize blobs don't match, so cleanup old cache
+	oldHistory.waitForPendingWork();
 	oldHistory.lastDeltaBlocks.clear();
 
 	// actual history transfer
@@ -874,14 +958,45 @@ void ReverseManager::takeSnapshot(EmuTime time)
 	// exact same EmuTime (because we don't (re)start taking snapshots at
 	// the same moment in time).
 
+	// The deltas of the previous snapshot are the base for the ones we're
+	// about to create, so that work must be finished first. Normally it
+	// finished long ago (snapshots are taken once per second).
+	history.waitForPendingWork();
+	auto startTime = Timer::getTime();
+	enforceMemoryLimit();
+	auto jobs = recompressOldChunks(time);
+
 	// actually create new snapshot
+	// Serializing must happen on the main thread, but the resulting blocks
+	// only depend on their own data. So calculating the deltas and
+	// compressing the blocks is offloaded to worker threads.
 	ReverseChunk& newChunk = history.chunks[seqNum];
 	newChunk.deltaBlocks.clear();
+	history.lastDeltaBlocks.setDeferWork(true);
 	MemOutputArchive out(history.lastDeltaBlocks, newChunk.deltaBlocks, true);
 	out.serialize("machine", motherBoard);
+	history.lastDeltaBlocks.setDeferWork(false);
 	newChunk.time = time;
 	newChunk.savestate = std::move(out).releaseBuffer();
 	newChunk.eventCount = replayIndex;
+
+	auto& pool = motherBoard.getReactor().getWorkerPool();
+	auto workerTime = std::make_shared<std::atomic<uint64_t>>(0);
+	append(jobs, history.lastDeltaBlocks.takeDeferredWork());
+	for (auto& job : jobs) {
+		history.pendingWork.push_back(pool.enqueue(
+			[job = std::move(job), workerTime] {
+				auto t0 = Timer::getTime();
+				job();
+				*workerTime += Timer::getTime() - t0;
+			}));
+	}
+	history.pendingWorkerTime = std::move(workerTime);
+
+	auto& stats = history.stats;
+	++stats.count;
+	stats.lastMainTime = Timer::getTime() - startTime;
+	stats.totalMainTime += stats.lastMainTime;
 }
 
 void ReverseManager::replayNextEvent()
@@ -944,6 +1059,66 @@ void ReverseManager::dropOldSnapshots(unsigned count)
 	}
 }
 
+void ReverseManager::enforceMemoryLimit()
+{
+	history.calcMemoryUsage();
+	auto limitMB = motherBoard.getReactor().getGlobalSettings().getReverseMemoryLimitSetting().getInt();
+	if (limitMB == 0) return; // no limit
+	auto limit = size_t(limitMB) * 1024 * 1024;
+
+	// The oldest snapshot is never dropped (see dropOldSnapshots()), and
+	// neither is the most recent one. From the others, drop the one that
+	// leaves the smallest gap between its neighbours. So the remaining
+	// snapshots stay spread over the whole history.
+	// Note: the snapshot that's about to be taken isn't included yet, so
+	// the limit can temporarily be exceeded by (less than) one snapshot.
+	auto& chunks = history.chunks;
+	while ((history.memory.used > limit) && (chunks.size() > 2)) {
+		auto best = end(chunks);
+		auto bestGap = EmuDuration::zero();
+		for (auto it = std::next(begin(chunks)); std::next(it) != end(chunks); ++it) {
+			auto gap = std::next(it)->second.time - std::prev(it)->second.time;
+			if ((best == end(chunks)) || (gap < bestGap)) {
+				best = it;
+				bestGap = gap;
+			}
+		}
+		chunks.erase(best);
+		++history.memory.evicted;
+		history.calcMemoryUsage();
+	}
+}
+
+std::vector<std::function<void()>> ReverseManager::recompressOldChunks(EmuTime time)
+{
+	// Only reference blocks that are no longer used to create new deltas
+	// can be recompressed (see DeltaBlockCopy::canRecompress()). Those
+	// are only used again when going back in time, and then we first wait
+	// for all pending work. Shared blocks must only be handled once.
+	std::vector<std::pair<const DeltaBlockCopy*, std::shared_ptr<DeltaBlock>>> blocks;
+	for (auto& [idx, chunk] : history.chunks) {
+		if ((chunk.time + RECOMPRESS_AGE) > time) break;
+		if (chunk.recompressed) continue;
+		chunk.recompressed = true;
+		for (const auto& block : chunk.deltaBlocks) {
+			const auto& ref = block->getReference();
+			if (ref.canRecompress()) blocks.emplace_back(&ref, block);
+		}
+	}
+	std::ranges::sort(blocks, {}, [](const auto& p) { return p.first; });
+	blocks.erase(std::ranges::unique(blocks, {}, [](const auto& p) { return p.first; }).begin(),
+	             blocks.end());
+	history.memory.recompressed += narrow<unsigned>(blocks.size());
+
+	// The shared_ptr keeps the reference block alive, even if the chunk
+	// gets dropped in the meantime.
+	return to_vector(std::views::transform(blocks, [](auto& p) {
+		return std::function<void()>([block = std::move(p.second)] {
+			block->getReference().recompress();
+		});
+	}));
+}
+
 void ReverseManager::schedule(EmuTime time)
 {
 	syncNewSnapshot.setSyncPoint(time + EmuDuration::sec(SNAPSHOT_PERIOD));
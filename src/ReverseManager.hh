@@ -10,8 +10,10 @@
 #include "MemBuffer.hh"
 #include "outer.hh"
 
+#include <atomic>
 #include <cstdint>
 #include <deque>
+#include <future>
 #include <map>
 #include <memory>
 #include <ranges>
@@ -77,6 +79,8 @@ public:
 private:
 	struct ReverseChunk {
 		EmuTime time = EmuTime::zero();
+		// For the most recent chunk these blocks may still be
+		// incomplete, see ReverseHistory::waitForPendingWork().
 		std::vector<std::shared_ptr<DeltaBlock>> deltaBlocks;
 		MemBuffer<uint8_t> savestate;
 
@@ -84,18 +88,62 @@ private:
 		// snapshot was created. So when going back replay should
 		// start at this index.
 		unsigned eventCount;
+
+		// Old chunks get their blocks recompressed (once) with a
+		// slower algorithm, see recompressOldChunks().
+		bool recompressed = false;
 	};
 	using Chunks = std::map<unsigned, ReverseChunk>;
 	using Events = std::deque<std::unique_ptr<StateChange>>;
 
+	// Host time (in us) spent on taking snapshots.
+	struct SnapshotStats {
+		unsigned count = 0;
+		uint64_t lastMainTime = 0;   // serialize (on the main thread)
+		uint64_t lastWorkerTime = 0; // delta calculation and compression
+		uint64_t totalMainTime = 0;
+		uint64_t totalWorkerTime = 0;
+	};
+
+	// Memory used by the history, updated each time a snapshot is taken.
+	struct MemoryStats {
+		size_t used = 0; // actual memory usage (shared blocks counted once)
+		size_t raw = 0;  // size of all snapshots when stored uncompressed
+		unsigned evicted = 0;      // chunks dropped to stay within the limit
+		unsigned recompressed = 0; // blocks recompressed with zlib
+	};
+
+	// Fast-forward part of the last goto (in case no goto was done yet,
+	// or it didn't need to fast-forward, both are zero).
+	struct SeekStats {
+		double emuTime = 0.0;  // in s
+		uint64_t hostTime = 0; // in us
+		[[nodiscard]] double getSpeed() const {
+			return hostTime ? emuTime * 1000000.0 / double(hostTime) : 0.0;
+		}
+	};
+
 	struct ReverseHistory {
-		void swap(ReverseHistory& other) noexcept;
+		void swap(ReverseHistory& other);
 		void clear();
 		[[nodiscard]] unsigned getNextSeqNum(EmuTime time) const;
 
+		// Delta calculation and compression for the most recent
+		// snapshot runs on worker threads. This must be called before
+		// taking a new snapshot or reading any of the chunks.
+		void waitForPendingWork();
+
+		// Only call after waitForPendingWork(). Updates 'memory'.
+		void calcMemoryUsage();
+
 		Chunks chunks;
 		Events events;
 		LastDeltaBlocks lastDeltaBlocks;
+
+		std::vector<std::future<void>> pendingWork;
+		std::shared_ptr<std::atomic<uint64_t>> pendingWorkerTime;
+		SnapshotStats stats;
+		MemoryStats memory;
 	};
 
 	void start();
@@ -121,6 +169,8 @@ private:
 	void schedule(EmuTime time);
 	void replayNextEvent();
 	template<unsigned N> void dropOldSnapshots(unsigned count);
+	void enforceMemoryLimit();
+	[[nodiscard]] std::vector<std::function<void()>> recompressOldChunks(EmuTime time);
 
 	// Schedulable
 	struct SyncNewSnapshot final : Schedulable {
@@ -160,6 +210,7 @@ private:
 
 	EventDelay* eventDelay = nullptr;
 	ReverseHistory history;
+	SeekStats lastSeek;
 	unsigned replayIndex = 0;
 	bool collecting = false;
 	bool pendingTakeSnapshot = false;
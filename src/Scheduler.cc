@@ -1,8 +1,10 @@
 #include "Scheduler.hh"
 
+#include "HostProfiler.hh"
 #include "MSXCPU.hh"
 #include "Schedulable.hh"
 #include "Thread.hh"
+#include "Timer.hh"
 
 #include "serialize.hh"
 #include "stl.hh"
@@ -38,10 +40,13 @@ void Scheduler::setSyncPoint(EmuTime time, Schedulable& device)
 	assert(time >= scheduleTime);
 
 	// Push sync point into queue.
+#ifdef OPENMSX_SCHEDULER_HEAP
+	queue.insert(SynchronizationPoint(time, &device));
+#else
 	queue.insert(SynchronizationPoint(time, &device),
 	             [](SynchronizationPoint& sp) { sp.setTime(EmuTime::infinity()); },
-	             [](const SynchronizationPoint& x, const SynchronizationPoint& y) {
-	                     return x.getTime() < y.getTime(); });
+	             EarlierSyncPoint{});
+#endif
 
 	if (!scheduleInProgress && cpu) {
 		// only when scheduleHelper() is not being executed
@@ -53,9 +58,15 @@ void Scheduler::setSyncPoint(EmuTime time, Schedulable& device)
 
 Scheduler::SyncPoints Scheduler::getSyncPoints(const Schedulable& device) const
 {
+#ifdef OPENMSX_SCHEDULER_HEAP
+	// heap is not sorted, but the (serialized) result should be, with
+	// equal times in insertion order (like in SchedulerQueue)
+	return queue.sorted_if(EqualSchedulable(device));
+#else
 	SyncPoints result;
 	std::ranges::copy_if(queue, back_inserter(result), EqualSchedulable(device));
 	return result;
+#endif
 }
 
 bool Scheduler::removeSyncPoint(const Schedulable& device)
@@ -73,11 +84,22 @@ void Scheduler::removeSyncPoints(const Schedulable& device)
 std::optional<EmuTime> Scheduler::isPending(const Schedulable& device) const
 {
 	assert(Thread::isMainThread());
+#ifdef OPENMSX_SCHEDULER_HEAP
+	// heap is not sorted, search the earliest sync point
+	std::optional<EmuTime> result;
+	for (const auto& sp : queue) {
+		if (sp.getDevice() == &device && (!result || sp.getTime() < *result)) {
+			result = sp.getTime();
+		}
+	}
+	return result;
+#else
 	if (auto it = std::ranges::find(queue, &device, &SynchronizationPoint::getDevice);
 	    it != std::end(queue)) {
 		return it->getTime();
 	}
 	return {};
+#endif
 }
 
 EmuTime Scheduler::getCurrentTime() const
@@ -90,6 +112,7 @@ void Scheduler::scheduleHelper(EmuTime limit, EmuTime next)
 {
 	assert(!scheduleInProgress);
 	scheduleInProgress = true;
+	uint64_t startTime = measureHostTime ? Timer::getTime() : 0;
 	while (true) {
 		assert(scheduleTime <= next);
 		scheduleTime = next;
@@ -99,11 +122,22 @@ void Scheduler::scheduleHelper(EmuTime limit, EmuTime next)
 
 		queue.remove_front();
 
-		device->executeUntil(next);
+		HostProfiler::profile(HostProfiler::Category::SYNC_POINT, device,
+			[](const void* d) {
+				return HostProfiler::getTypeName(typeid(*static_cast<const Schedulable*>(d)));
+			},
+			[&] { device->executeUntil(next); });
+		++stats.numSyncPoints;
 
 		next = getNext();
 		if (next > limit) [[likely]] break;
 	}
+	if (measureHostTime) {
+		// Note: individual sync points are often much shorter than the
+		// timer resolution (1us), but on average this still gives an
+		// accurate result.
+		stats.hostTime += Timer::getTime() - startTime;
+	}
 	scheduleInProgress = false;
 
 	cpu->setNextSyncPoint(next);
@@ -2,8 +2,10 @@
 #define SCHEDULER_HH
 
 #include "EmuTime.hh"
+#include "SchedulerHeap.hh"
 #include "SchedulerQueue.hh"
 
+#include <cstdint>
 #include <optional>
 #include <vector>
 
@@ -30,6 +32,12 @@ private:
 	Schedulable* device = nullptr;
 };
 
+struct EarlierSyncPoint {
+	[[nodiscard]] bool operator()(const SynchronizationPoint& x, const SynchronizationPoint& y) const {
+		return x.getTime() < y.getTime();
+	}
+};
+
 
 class Scheduler
 {
@@ -68,6 +76,18 @@ public:
 		scheduleTime = limit;
 	}
 
+	/** Statistics, used to report emulation speed (see 'benchmark'). */
+	struct Stats {
+		uint64_t numSyncPoints = 0; // number of executed sync points
+		uint64_t hostTime = 0; // us spent executing sync points, see below
+	};
+	[[nodiscard]] const Stats& getStats() const { return stats; }
+
+	/** Measuring the host time spent in the sync points has a small cost,
+	  * so by default it's not done (Stats::hostTime doesn't change).
+	  */
+	void setMeasureHostTime(bool enable) { measureHostTime = enable; }
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -109,13 +129,21 @@ private:
 	void scheduleHelper(EmuTime limit, EmuTime next);
 
 private:
-	/** Vector used as heap, not a priority queue because that
-	  * doesn't allow removal of non-top element.
+	/** By default a sorted array, this is the fastest option for the
+	  * typical number of sync points. Compile with
+	  * -DOPENMSX_SCHEDULER_HEAP to use a binary heap instead, that scales
+	  * better for machines with many Schedulables (see SchedulerHeap).
 	  */
+#ifdef OPENMSX_SCHEDULER_HEAP
+	SchedulerHeap<SynchronizationPoint, EarlierSyncPoint> queue;
+#else
 	SchedulerQueue<SynchronizationPoint> queue;
+#endif
 	EmuTime scheduleTime = EmuTime::zero();
 	MSXCPU* cpu = nullptr;
+	Stats stats;
 	bool scheduleInProgress = false;
+	bool measureHostTime = false;
 };
 
 } // namespace openmsx
@@ -0,0 +1,169 @@
+#ifndef SCHEDULERHEAP_HH
+#define SCHEDULERHEAP_HH
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace openmsx {
+
+// Alternative for SchedulerQueue, implemented as a binary heap.
+//
+// SchedulerQueue is a sorted array: removing the smallest element is O(1),
+// and inserting an element close to the front is usually cheap as well, but
+// in general inserting and removing an arbitrary element is O(N). This heap
+// has O(log(N)) insert and remove_front() operations. Removing an arbitrary
+// element (remove()) is still O(N), because finding it requires a linear
+// search (removing it once found is O(log(N))). So it's only faster when
+// there are many elements (e.g. a machine with many sound cartridges, MIDI,
+// RS232, V9990, ...).
+//
+// Like SchedulerQueue, elements that are equivalent according to 'Less'
+// are returned in the order in which they were inserted (required to keep
+// the emulation deterministic). Unlike SchedulerQueue, iterating over the
+// elements (begin()/end()) does NOT visit them in sorted order.
+template<typename T, typename Less> class SchedulerHeap
+{
+public:
+	[[nodiscard]] size_t size()  const { return items.size(); }
+	[[nodiscard]] bool   empty() const { return items.empty(); }
+
+	// Returns reference to the smallest element.
+	[[nodiscard]]       T& front()       { assert(!empty()); return items.front(); }
+	[[nodiscard]] const T& front() const { assert(!empty()); return items.front(); }
+
+	// Iterate over all elements (in unspecified order).
+	[[nodiscard]]       T* begin()       { return items.data(); }
+	[[nodiscard]] const T* begin() const { return items.data(); }
+	[[nodiscard]]       T* end()         { return items.data() + items.size(); }
+	[[nodiscard]] const T* end()   const { return items.data() + items.size(); }
+
+	// Insert new element, after existing equivalent elements.
+	void insert(const T& t)
+	{
+		items.push_back(t);
+		orders.push_back(counter++);
+		siftUp(items.size() - 1);
+	}
+
+	// Remove the smallest element.
+	void remove_front()
+	{
+		assert(!empty());
+		removeAt(0);
+	}
+
+	// Remove the smallest (same order as remove_front() would return them)
+	// element for which the given predicate returns true. Like in
+	// SchedulerQueue, which removes the first match in sorted order.
+	bool remove(std::predicate<T> auto p)
+	{
+		size_t best = items.size();
+		for (size_t i = 0; i < items.size(); ++i) {
+			if (p(items[i]) && (best == items.size() || before(i, best))) {
+				best = i;
+			}
+		}
+		if (best == items.size()) return false;
+		removeAt(best);
+		return true;
+	}
+
+	// Returns (a copy of) all elements for which the given predicate returns
+	// true, in the same order as remove_front() would return them.
+	[[nodiscard]] std::vector<T> sorted_if(std::predicate<T> auto p) const
+	{
+		std::vector<size_t> indices;
+		for (size_t i = 0; i < items.size(); ++i) {
+			if (p(items[i])) indices.push_back(i);
+		}
+		std::ranges::sort(indices, [&](size_t i, size_t j) { return before(i, j); });
+		std::vector<T> result;
+		result.reserve(indices.size());
+		for (auto i : indices) result.push_back(items[i]);
+		return result;
+	}
+
+	// Remove all elements for which the given predicate returns true.
+	void remove_all(std::predicate<T> auto p)
+	{
+		size_t j = 0;
+		for (size_t i = 0; i < items.size(); ++i) {
+			if (!p(items[i])) {
+				items[j] = items[i];
+				orders[j] = orders[i];
+				++j;
+			}
+		}
+		if (j == items.size()) return;
+		items.resize(j);
+		orders.resize(j);
+		for (size_t i = j / 2; i-- > 0; /**/) siftDown(i);
+	}
+
+private:
+	[[nodiscard]] bool before(size_t i, size_t j) const
+	{
+		Less less;
+		if (less(items[i], items[j])) return true;
+		if (less(items[j], items[i])) return false;
+		return orders[i] < orders[j];
+	}
+
+	void swapElements(size_t i, size_t j)
+	{
+		std::swap(items[i], items[j]);
+		std::swap(orders[i], orders[j]);
+	}
+
+	void siftUp(size_t i)
+	{
+		while (i != 0) {
+			size_t parent = (i - 1) / 2;
+			if (!before(i, parent)) break;
+			swapElements(i, parent);
+			i = parent;
+		}
+	}
+
+	void siftDown(size_t i)
+	{
+		size_t n = items.size();
+		while (true) {
+			size_t child = 2 * i + 1;
+			if (child >= n) break;
+			if ((child + 1) < n && before(child + 1, child)) ++child;
+			if (!before(child, i)) break;
+			swapElements(i, child);
+			i = child;
+		}
+	}
+
+	void removeAt(size_t i)
+	{
+		size_t last = items.size() - 1;
+		if (i != last) {
+			swapElements(i, last);
+			items.pop_back();
+			orders.pop_back();
+			siftDown(i);
+			siftUp(i);
+		} else {
+			items.pop_back();
+			orders.pop_back();
+		}
+	}
+
+private:
+	// Invariant: items.size() == orders.size()
+	std::vector<T> items;
+	std::vector<uint64_t> orders; // insertion order, to break ties
+	uint64_t counter = 0;
+};
+
+} // namespace openmsx
+
+#endif // SCHEDULERHEAP_HH
@@ -2,12 +2,15 @@
 #define BREAKPOINTBASE_HH
 
 #include "CommandException.hh"
+#include "CompiledCondition.hh"
 #include "GlobalCliComm.hh"
 #include "TclObject.hh"
 
 #include "ScopedAssign.hh"
 #include "strCat.hh"
 
+#include <memory>
+
 namespace openmsx {
 
 class Interpreter;
@@ -26,7 +29,10 @@ public:
 	[[nodiscard]] bool isEnabled() const { return enabled; }
 	[[nodiscard]] bool onlyOnce() const { return once; }
 
-	void setCondition(const TclObject& c) { condition = c; }
+	void setCondition(const TclObject& c) {
+		condition = c;
+		compiledCondition = CompiledCondition::compile(condition.getString());
+	}
 	void setCommand(const TclObject& c) { command = c; }
 	void setEnabled(Interpreter& interp, const TclObject& e) {
 		setEnabled(e.getBoolean(interp)); // may throw
@@ -37,14 +43,15 @@ public:
 	}
 	void setOnce(bool o) { once = o; }
 
-	bool checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp) {
+	bool checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp,
+	                     CompiledCondition::Context& context) {
 		if (!enabled) return false;
 		if (executing) {
 			// no recursive execution
 			return false;
 		}
 		ScopedAssign sa(executing, true);
-		if (isTrue(cliComm, interp)) {
+		if (isTrue(cliComm, interp, context)) {
 			try {
 				command.executeCommand(interp, true); // compile command
 			} catch (CommandException& e) {
@@ -63,12 +70,16 @@ private:
 	// Note: we require GlobalCliComm here because breakpoint objects can
 	// be transferred to different MSX machines, and so the MSXCliComm
 	// object won't remain valid.
-	[[nodiscard]] bool isTrue(GlobalCliComm& cliComm, Interpreter& interp) const {
+	[[nodiscard]] bool isTrue(GlobalCliComm& cliComm, Interpreter& interp,
+	                          CompiledCondition::Context& context) const {
 		if (condition.getString().empty()) {
 			// unconditional bp
 			return true;
 		}
 		try {
+			if (compiledCondition) {
+				return compiledCondition->evalBool(context);
+			}
 			return condition.evalBool(interp);
 		} catch (CommandException& e) {
 			cliComm.printWarning(e.getMessage());
@@ -79,6 +90,8 @@ private:
 private:
 	TclObject command{"debug break"};
 	TclObject condition;
+	// shared, because break points get copied (e.g. in checkBreakPoints())
+	std::shared_ptr<const CompiledCondition> compiledCondition;
 	bool enabled = true;
 	bool once = false;
 	bool executing = false;
@@ -58,6 +58,20 @@ protected:
 		return halts;
 	}
 
+	/** Skip iterations of an idle loop (a loop without side effects).
+	  * Advances the clock with the largest integer multiple of 'loopStates'
+	  * cycles such that, after adding the still 'pending' cycles of the
+	  * current instruction, the limit is not yet reached. Returns the number
+	  * of times 'loopStates' was added (0 when the limit is disabled).
+	  */
+	unsigned advanceIdleLoop(unsigned loopStates, unsigned pending) {
+		int left = remaining - narrow_cast<int>(pending);
+		if (left < 0) return 0;
+		unsigned loops = unsigned(left) / loopStates;
+		add(loops * loopStates);
+		return loops;
+	}
+
 	/** R800 runs at 7MHz, but I/O is done over a slower 3.5MHz bus. So
 	  * sometimes right before I/O it's needed to wait for one cycle so
 	  * that we're at the start of a clock cycle of the slower bus.
@@ -199,8 +199,9 @@
 //   But even on more recent gcc versions it still requires around 700MB.
 //
 // Probably the easiest way to enable this, is to pass the -DUSE_COMPUTED_GOTO
-// flag to the compiler. This is for example done in the super-opt flavour.
-// See build/flavour-super-opt.mk
+// flag to the compiler. This is for example done in the super-opt, threaded
+// and pgo flavours (see build/flavour-*.mk), or with the meson option
+// -Dcomputed_goto=true. Contrib/cpubench compares the speed of both variants.
 
 #ifndef _MSC_VER
   // [[maybe_unused]] on a label is not (yet?) officially part of c++
@@ -539,6 +540,29 @@ template<typename T> inline void CPUCore<T>::WRITE_PORT(uint16_t port, uint8_t v
 	// note: no forced page-break after IO
 }
 
+template<typename T> const uint8_t* CPUCore<T>::getWatchedReadLine(unsigned high)
+{
+	auto& w = watchedReadLine[high];
+	if (w.generation != cacheLinesGeneration) {
+		auto addrBase = narrow_cast<uint16_t>(high << CacheLine::BITS);
+		const uint8_t* line = interface->getWatchedReadCacheLine(addrBase);
+		w.line = line ? line - addrBase : nullptr;
+		w.generation = cacheLinesGeneration;
+	}
+	return w.line;
+}
+template<typename T> uint8_t* CPUCore<T>::getWatchedWriteLine(unsigned high)
+{
+	auto& w = watchedWriteLine[high];
+	if (w.generation != cacheLinesGeneration) {
+		auto addrBase = narrow_cast<uint16_t>(high << CacheLine::BITS);
+		uint8_t* line = interface->getWatchedWriteCacheLine(addrBase);
+		w.line = line ? line - addrBase : nullptr;
+		w.generation = cacheLinesGeneration;
+	}
+	return w.line;
+}
+
 template<typename T> template<bool PRE_PB, bool POST_PB>
 NEVER_INLINE uint8_t CPUCore<T>::RDMEMslow(unsigned address, unsigned cc)
 {
@@ -558,6 +582,14 @@ NEVER_INLINE uint8_t CPUCore<T>::RDMEMslow(unsigned address, unsigned cc)
 	}
 	// uncacheable
 	readCacheLine[high] = std::bit_cast<const uint8_t*>(uintptr_t(1));
+	if (const uint8_t* line = getWatchedReadLine(high);
+	    line && !interface->isReadWatched(narrow_cast<uint16_t>(address))) {
+		// in a line with watchpoints, but not on a watched address
+		interface->tick(CacheLineCounters::WatchedLineRead);
+		T::template PRE_MEM<PRE_PB, POST_PB>(address);
+		T::template POST_MEM<       POST_PB>(address);
+		return line[address];
+	}
 	T::template PRE_MEM<PRE_PB, POST_PB>(address);
 	EmuTime time = T::getTimeFast(cc);
 	scheduler.schedule(time);
@@ -603,6 +635,16 @@ template<typename T> ALWAYS_INLINE uint8_t CPUCore<T>::RDMEM(unsigned address, u
 {
 	return RDMEM_impl<true, true>(address, cc);
 }
+// Is there an 'ED <opcode>' instruction at the given address, in memory that
+// can be fetched via the read cache (so without side effects)?
+template<typename T> ALWAYS_INLINE bool CPUCore<T>::isCachedEDOpcode(unsigned address, uint8_t opcode) const
+{
+	auto address2 = narrow_cast<uint16_t>(address + 1);
+	const uint8_t* line  = readCacheLine[address  >> CacheLine::BITS];
+	const uint8_t* line2 = readCacheLine[address2 >> CacheLine::BITS];
+	return (uintptr_t(line) > 1) && (uintptr_t(line2) > 1) &&
+	       (line[address] == 0xED) && (line2[address2] == opcode);
+}
 
 template<typename T> template<bool PRE_PB, bool POST_PB>
 NEVER_INLINE uint16_t CPUCore<T>::RD_WORD_slow(unsigned address, unsigned cc)
@@ -663,6 +705,15 @@ NEVER_INLINE void CPUCore<T>::WRMEMslow(unsigned address, uint8_t value, unsigne
 	}
 	// uncacheable
 	writeCacheLine[high] = std::bit_cast<uint8_t*>(uintptr_t(1));
+	if (uint8_t* line = getWatchedWriteLine(high);
+	    line && !interface->isWriteWatched(narrow_cast<uint16_t>(address))) {
+		// see RDMEMslow()
+		interface->tick(CacheLineCounters::WatchedLineWrite);
+		T::template PRE_MEM<PRE_PB, POST_PB>(address);
+		T::template POST_MEM<       POST_PB>(address);
+		line[address] = value;
+		return;
+	}
 	T::template PRE_MEM<PRE_PB, POST_PB>(address);
 	EmuTime time = T::getTimeFast(cc);
 	scheduler.schedule(time);
@@ -805,10 +856,144 @@ template<typename T> inline void CPUCore<T>::irq2()
 	T::add(T::CC_IRQ2);
 }
 
+// Idle loop detection
+//
+// Programs often wait for an interrupt in a loop like
+//     loop: ld a,(JIFFY) ; cp b ; jr z,loop
+// or simply in 'jr $'. Such a loop only reads memory and registers that it
+// doesn't change itself, so after one full iteration each next iteration does
+// exactly the same, until a device changes something. And devices only run
+// at sync points. So instead of emulating all these iterations, we directly
+// advance the time (and the R register) to the end of the last iteration
+// before the next sync point. The remaining instructions are emulated as
+// usual, so the loop is left (e.g. to accept an IRQ) at exactly the same
+// moment as without this shortcut.
+//
+// A loop is recognized on a taken backwards JR or JP when:
+// - the loop body (from the jump target till the jump) only contains
+//   instructions from a small set (see analyzeIdleLoop()). These only write
+//   the A and F registers, in such a way that the next iteration computes
+//   the same values again. And they only read memory (and fetch opcodes) via
+//   the read cache, so without side effects.
+// - the same jump is taken a second time in a row, so a full iteration was
+//   executed in between. Leaving the loop (the jump isn't taken) or leaving
+//   executeInstructions() resets this.
+// Port reads are not allowed: an IO device (e.g. the VDP status registers)
+// can return a different value on each read, or the read can have side
+// effects. HALT is handled separately, see executeSlow(). This is only done
+// for the Z80: on the R800 the periodic DRAM refresh makes the iterations
+// not all take the same time.
+template<typename T> ALWAYS_INLINE void CPUCore<T>::checkIdleLoop(
+	unsigned jump, unsigned target, unsigned jumpLength, unsigned jumpCycles)
+{
+	if constexpr (!T::IS_R800) {
+		if ((narrow_cast<uint16_t>(jump - target) <= MAX_IDLE_LOOP_SIZE) &&
+		    (jump != notIdleLoopJump)) [[unlikely]] {
+			skipIdleLoop(jump, target, jumpLength, jumpCycles);
+		}
+	}
+}
+
+template<typename T> NEVER_INLINE void CPUCore<T>::skipIdleLoop(
+	unsigned jump, unsigned target, unsigned jumpLength, unsigned jumpCycles)
+{
+	if (jump != idleLoopJump) {
+		// first time, only check the loop body
+		if (auto loop = analyzeIdleLoop(jump, target, jumpLength, jumpCycles)) {
+			idleLoop = *loop;
+			idleLoopJump = jump;
+		} else {
+			notIdleLoopJump = jump;
+		}
+		return;
+	}
+	// a full iteration was executed, skip the next ones
+	unsigned loops = T::advanceIdleLoop(idleLoop.cycles, jumpCycles);
+	incR(uint64_t(loops) * idleLoop.r);
+}
+
+template<typename T> std::optional<typename CPUCore<T>::IdleLoop> CPUCore<T>::analyzeIdleLoop(
+	unsigned jump, unsigned target, unsigned jumpLength, unsigned jumpCycles) const
+{
+	// Returns the byte at the given address, or -1 when it's not in a
+	// cached memory line (then reading it might have side effects).
+	auto peek = [&](unsigned address) -> int {
+		address &= 0xFFFF;
+		const uint8_t* line = readCacheLine[address >> CacheLine::BITS];
+		return (uintptr_t(line) > 1) ? line[address] : -1;
+	};
+
+	for (auto i : xrange(jumpLength)) {
+		if (peek(jump + i) < 0) return {};
+	}
+	IdleLoop result{jumpCycles, 1};
+	unsigned size = narrow_cast<uint16_t>(jump - target);
+	unsigned offset = 0;
+	while (offset < size) {
+		unsigned address = target + offset;
+		unsigned length = 1;
+		unsigned cycles = 0;
+		std::optional<unsigned> read; // address of the memory operand
+		// Note: A only gets loaded from memory or from another register,
+		//  or masked with AND/OR. Any combination of these gives the same
+		//  result when applied twice.
+		switch (peek(address)) {
+		case 0x0a: // ld a,(bc)
+			read = getBC(); cycles = T::CC_LD_A_SS; break;
+		case 0x1a: // ld a,(de)
+			read = getDE(); cycles = T::CC_LD_A_SS; break;
+		case 0x3a: { // ld a,(nn)
+			int lo = peek(address + 1);
+			int hi = peek(address + 2);
+			if ((lo < 0) || (hi < 0)) return {};
+			read = unsigned(lo | (hi << 8)); length = 3; cycles = T::CC_LD_A_NN;
+			break;
+		}
+		case 0x7e: // ld a,(hl)
+			read = getHL(); cycles = T::CC_LD_R_HL; break;
+		case 0x78: case 0x79: case 0x7a: case 0x7b: case 0x7c: case 0x7d: // ld a,r
+			cycles = T::CC_LD_R_R; break;
+		case 0xa0: case 0xa1: case 0xa2: case 0xa3: case 0xa4: case 0xa5: case 0xa7: // and r
+		case 0xb0: case 0xb1: case 0xb2: case 0xb3: case 0xb4: case 0xb5: case 0xb7: // or r
+		case 0xb8: case 0xb9: case 0xba: case 0xbb: case 0xbc: case 0xbd: case 0xbf: // cp r
+			cycles = T::CC_CP_R; break;
+		case 0xa6: case 0xb6: case 0xbe: // and/or/cp (hl)
+			read = getHL(); cycles = T::CC_CP_XHL; break;
+		case 0xe6: case 0xf6: case 0xfe: // and/or/cp n
+			length = 2; cycles = T::CC_CP_N; break;
+		case 0xcb: { // bit n,r / bit n,(hl)
+			int op = peek(address + 1);
+			if ((op < 0x40) || (op >= 0x80)) return {};
+			if ((op & 7) == 6) {
+				read = getHL(); cycles = T::CC_BIT_XHL;
+			} else {
+				cycles = T::CC_BIT_R;
+			}
+			length = 2;
+			++result.r; // prefix
+			break;
+		}
+		default:
+			return {};
+		}
+		for (auto i : xrange(length)) {
+			if (peek(address + i) < 0) return {};
+		}
+		if (read && (peek(*read) < 0)) return {};
+		result.cycles += cycles;
+		++result.r;
+		offset += length;
+	}
+	if (offset != size) return {}; // last instruction overlaps the jump
+	return result;
+}
+
 template<typename T>
 void CPUCore<T>::executeInstructions()
 {
 	checkNoCurrentFlags();
+	idleLoopJump = NO_IDLE_LOOP;
+	notIdleLoopJump = NO_IDLE_LOOP;
 #ifdef USE_COMPUTED_GOTO
 	// Addresses of all main-opcode routines,
 	// Note that 40/49/53/5B/64/6D/7F is replaced by 00 (ld r,r == nop)
@@ -915,6 +1100,31 @@ void CPUCore<T>::executeInstructions()
 
 #endif // USE_COMPUTED_GOTO
 
+// Like NEXT, but for the block instructions (LDIR, OUTI, ...). These often
+// execute many times in a row: the repeating variants re-execute themselves,
+// and the others are typically unrolled (e.g. a sequence of OUTI instructions
+// to upload data to the VDP). So as long as the next instruction is the same
+// one, directly execute it, skipping the (two-level) opcode dispatch. This
+// does exactly the same as the general path (timing, R register, memory
+// hooks); in all other cases (e.g. the code got overwritten or isn't
+// cacheable) we fall back to that general path.
+#define NEXT_BLOCK(INSTR, OPCODE) \
+	while (isCachedEDOpcode(narrow_cast<uint16_t>(getPC() + ii.length), OPCODE)) { \
+		setPC(getPC() + ii.length); \
+		T::add(ii.cycles); \
+		T::R800Refresh(*this); \
+		if (T::limitReached()) [[unlikely]] return; \
+		incR(1); \
+		T::template PRE_MEM<false, false>(getPC()); \
+		T::template POST_MEM<      false>(getPC()); \
+		setPC(getPC() + 1); \
+		T::template PRE_MEM<false, false>(getPC()); \
+		T::template POST_MEM<      false>(getPC()); \
+		incR(1); \
+		ii = INSTR(); \
+	} \
+	NEXT;
+
 #ifndef USE_COMPUTED_GOTO
 start:
 #endif
@@ -1571,22 +1781,22 @@ CASE(ED) {
 		case 0x64: case 0x6c: case 0x74: case 0x7c:
 		           { II ii = neg(); NEXT; }
 
-		case 0xa0: { II ii = ldi();  NEXT; }
-		case 0xa1: { II ii = cpi();  NEXT; }
-		case 0xa2: { II ii = ini();  NEXT; }
-		case 0xa3: { II ii = outi(); NEXT; }
-		case 0xa8: { II ii = ldd();  NEXT; }
-		case 0xa9: { II ii = cpd();  NEXT; }
-		case 0xaa: { II ii = ind();  NEXT; }
-		case 0xab: { II ii = outd(); NEXT; }
-		case 0xb0: { II ii = ldir(); NEXT; }
-		case 0xb1: { II ii = cpir(); NEXT; }
-		case 0xb2: { II ii = inir(); NEXT; }
-		case 0xb3: { II ii = otir(); NEXT; }
-		case 0xb8: { II ii = lddr(); NEXT; }
-		case 0xb9: { II ii = cpdr(); NEXT; }
-		case 0xba: { II ii = indr(); NEXT; }
-		case 0xbb: { II ii = otdr(); NEXT; }
+		case 0xa0: { II ii = ldi();  NEXT_BLOCK(ldi,  0xa0); }
+		case 0xa1: { II ii = cpi();  NEXT_BLOCK(cpi,  0xa1); }
+		case 0xa2: { II ii = ini();  NEXT_BLOCK(ini,  0xa2); }
+		case 0xa3: { II ii = outi(); NEXT_BLOCK(outi, 0xa3); }
+		case 0xa8: { II ii = ldd();  NEXT_BLOCK(ldd,  0xa8); }
+		case 0xa9: { II ii = cpd();  NEXT_BLOCK(cpd,  0xa9); }
+		case 0xaa: { II ii = ind();  NEXT_BLOCK(ind,  0xaa); }
+		case 0xab: { II ii = outd(); NEXT_BLOCK(outd, 0xab); }
+		case 0xb0: { II ii = ldir(); NEXT_BLOCK(ldir, 0xb0); }
+		case 0xb1: { II ii = cpir(); NEXT_BLOCK(cpir, 0xb1); }
+		case 0xb2: { II ii = inir(); NEXT_BLOCK(inir, 0xb2); }
+		case 0xb3: { II ii = otir(); NEXT_BLOCK(otir, 0xb3); }
+		case 0xb8: { II ii = lddr(); NEXT_BLOCK(lddr, 0xb8); }
+		case 0xb9: { II ii = cpdr(); NEXT_BLOCK(cpdr, 0xb9); }
+		case 0xba: { II ii = indr(); NEXT_BLOCK(indr, 0xba); }
+		case 0xbb: { II ii = otdr(); NEXT_BLOCK(otdr, 0xbb); }
 
 		case 0xc1: { II ii = T::IS_R800 ? mulub_a_R<B>() : nop(); NEXT; }
 		case 0xc9: { II ii = T::IS_R800 ? mulub_a_R<C>() : nop(); NEXT; }
@@ -2466,7 +2676,7 @@ template<typename T> void CPUCore<T>::executeSlow(ExecIRQ execIRQ)
 		}
 	} else if (getHALT()) [[unlikely]] {
 		// in halt mode
-		incR(narrow_cast<uint8_t>(T::advanceHalt(T::HALT_STATES, scheduler.getNext())));
+		incR(T::advanceHalt(T::HALT_STATES, scheduler.getNext()));
 		setSlowInstructions();
 	} else {
 		assert(T::limitReached()); // we want only one instruction
@@ -3879,10 +4089,12 @@ template<typename T> template<typename COND> II CPUCore<T>::jp(COND cond) {
 	uint16_t addr = RD_WORD_PC<1>(T::CC_JP_1);
 	T::setMemPtr(addr);
 	if (cond(getF())) {
+		checkIdleLoop(getPC(), addr, 3, T::CC_JP_A);
 		setPC(addr);
 		T::R800ForcePageBreak();
 		return {0/*3*/, T::CC_JP_A};
 	} else {
+		idleLoopJump = NO_IDLE_LOOP; // left the loop (if any)
 		return {3, T::CC_JP_B};
 	}
 }
@@ -3921,10 +4133,12 @@ template<typename T> template<typename COND> II CPUCore<T>::jr(COND cond) {
 			// See doc/r800-djnz.txt for more details.
 			T::R800ForcePageBreak();
 		}
+		checkIdleLoop(getPC(), narrow_cast<uint16_t>(getPC() + 2 + ofst), 2, T::CC_JR_A);
 		setPC(narrow_cast<uint16_t>(getPC() + 2 + ofst));
 		T::setMemPtr(getPC());
 		return {0/*2*/, T::CC_JR_A};
 	} else {
+		idleLoopJump = NO_IDLE_LOOP; // left the loop (if any)
 		return {2, T::CC_JR_B};
 	}
 }
@@ -13,6 +13,7 @@
 #include <array>
 #include <atomic>
 #include <cstdint>
+#include <optional>
 #include <span>
 #include <string>
 
@@ -84,7 +85,9 @@ public:
 	void wait(EmuTime time);
 	EmuTime waitCycles(EmuTime time, unsigned cycles);
 	void setNextSyncPoint(EmuTime time);
+	/** The caller (MSXCPU) is allowed to modify the returned cache lines. */
 	[[nodiscard]] CacheLines getCacheLines() {
+		++cacheLinesGeneration; // invalidates watchedReadLine/watchedWriteLine
 		return {.read = readCacheLine, .write = writeCacheLine};
 	}
 	[[nodiscard]] bool isM1Cycle(unsigned address) const;
@@ -138,6 +141,32 @@ private:
 	std::array<const uint8_t*, CacheLine::NUM> readCacheLine;
 	std::array<      uint8_t*, CacheLine::NUM> writeCacheLine;
 
+	// Lines that are only non-cacheable because they contain a watched
+	// address. The other addresses in such a line can still be accessed
+	// directly (though not via the inlined fast path), so that a
+	// watchpoint on a single address doesn't slow down all accesses to
+	// the surrounding 256 bytes. An entry is only valid when its
+	// generation matches 'cacheLinesGeneration'.
+	template<typename Line> struct WatchedLine {
+		Line line = nullptr;
+		uint64_t generation = 0;
+	};
+	std::array<WatchedLine<const uint8_t*>, CacheLine::NUM> watchedReadLine;
+	std::array<WatchedLine<      uint8_t*>, CacheLine::NUM> watchedWriteLine;
+	uint64_t cacheLinesGeneration = 1;
+
+	// Idle loop detection (Z80 only), see checkIdleLoop(). Addresses are
+	// those of the backwards jump instruction, NO_IDLE_LOOP means none.
+	static constexpr unsigned NO_IDLE_LOOP = unsigned(-1);
+	static constexpr unsigned MAX_IDLE_LOOP_SIZE = 32; // in bytes, excluding the jump
+	struct IdleLoop {
+		unsigned cycles = 0; // per iteration, including the jump
+		uint8_t r = 0;       // increment of the R register per iteration
+	};
+	IdleLoop idleLoop;
+	unsigned idleLoopJump = NO_IDLE_LOOP;    // jump of idleLoop
+	unsigned notIdleLoopJump = NO_IDLE_LOOP; // last rejected jump
+
 	MSXMotherBoard& motherboard;
 	Scheduler& scheduler;
 	MSXCPUInterface* interface = nullptr;
@@ -172,6 +201,8 @@ private:
 	inline uint8_t READ_PORT(uint16_t port, unsigned cc);
 	inline void WRITE_PORT(uint16_t port, uint8_t value, unsigned cc);
 
+	[[nodiscard]] const uint8_t* getWatchedReadLine(unsigned high);
+	[[nodiscard]] uint8_t* getWatchedWriteLine(unsigned high);
 	template<bool PRE_PB, bool POST_PB>
 	uint8_t RDMEMslow(unsigned address, unsigned cc);
 	template<bool PRE_PB, bool POST_PB>
@@ -181,6 +212,7 @@ private:
 	template<unsigned PC_OFFSET>
 	inline uint8_t RDMEM_OPCODE(unsigned cc);
 	inline uint8_t RDMEM(unsigned address, unsigned cc);
+	[[nodiscard]] inline bool isCachedEDOpcode(unsigned address, uint8_t opcode) const;
 
 	template<bool PRE_PB, bool POST_PB>
 	uint16_t RD_WORD_slow(unsigned address, unsigned cc);
@@ -211,6 +243,10 @@ private:
 	inline void WR_WORD_rev (unsigned address, uint16_t value, unsigned cc);
 
 	void executeInstructions();
+	inline void checkIdleLoop(unsigned jump, unsigned target, unsigned jumpLength, unsigned jumpCycles);
+	void skipIdleLoop(unsigned jump, unsigned target, unsigned jumpLength, unsigned jumpCycles);
+	[[nodiscard]] std::optional<IdleLoop> analyzeIdleLoop(
+		unsigned jump, unsigned target, unsigned jumpLength, unsigned jumpCycles) const;
 	inline void nmi();
 	inline void irq0();
 	inline void irq1();
@@ -5,6 +5,7 @@
 
 #include <bit>
 #include <cassert>
+#include <concepts>
 #include <cstdint>
 
 namespace openmsx {
@@ -61,7 +62,7 @@ public:
 
 	[[nodiscard]] uint8_t getIM()  const { return IM_; }
 	[[nodiscard]] uint8_t getI()   const { return I_; }
-	[[nodiscard]] uint8_t getR()   const { return (R_ & Rmask) | (R2_ & ~Rmask); }
+	[[nodiscard]] uint8_t getR()   const { return uint8_t(((R_ + Roffset_) & Rmask) | (R2_ & ~Rmask)); }
 	[[nodiscard]] bool getIFF1()     const { return IFF1_; }
 	[[nodiscard]] bool getIFF2()     const { return IFF2_; }
 	[[nodiscard]] uint8_t getHALT()     const { return HALT_; }
@@ -106,13 +107,29 @@ public:
 
 	void setIM(uint8_t x) { IM_ = x; }
 	void setI(uint8_t x)  { I_ = x; }
-	void setR(uint8_t x)  { R_ = x; R2_ = x; }
+	void setR(uint8_t x)  { Roffset_ = uint8_t(x - R_); R2_ = x; }
 	void setIFF1(bool x)    { IFF1_ = x; }
 	void setIFF2(bool x)    { IFF2_ = x; }
 	void setHALT(bool x)    { HALT_ = (HALT_ & ~1) | (x ? 1 : 0); }
 	void setExtHALT(bool x) { HALT_ = (HALT_ & ~2) | (x ? 2 : 0); }
 
 	void incR(uint8_t x) { R_ += x; }
+	/** Same, but for a count that can be larger than 255 (e.g. when
+	  * skipping many HALT or idle loop iterations at once). Only the
+	  * lower bits are visible in the R register, but getRefreshCount()
+	  * must include the full count.
+	  */
+	void incR(std::unsigned_integral auto x) { R_ += x; }
+
+	/** The number of times the R register was incremented. That's the
+	  * number of M1 (opcode fetch) cycles: prefixed instructions count two
+	  * or more times and on R800 also the periodic refresh cycles are
+	  * included. It's not affected by setR() (e.g. 'LD R,A'), so it never
+	  * goes backwards. This is used to report emulation speed (see
+	  * 'benchmark' command), we get it for free because the R register is
+	  * incremented anyway.
+	  */
+	[[nodiscard]] uint64_t getRefreshCount() const { return R_; }
 
 	// Sometimes we need to look at sequences of instructions/actions
 	// instead of only individual instructions. The most obvious example is
@@ -199,10 +216,12 @@ private:
 	z80regPair AF_, BC_, DE_, HL_;
 	z80regPair AF2_, BC2_, DE2_, HL2_;
 	z80regPair IX_, IY_, SP_;
+	uint64_t R_ = 0; // refresh = (R + Roffset) & Rmask | R2 & ~Rmask, see getRefreshCount()
 	bool IFF1_, IFF2_;
 	uint8_t HALT_ = 0;
 	uint8_t IM_, I_;
-	uint8_t R_, R2_; // refresh = R & Rmask | R2 & ~Rmask
+	uint8_t R2_;
+	uint8_t Roffset_ = 0; // set by setR(), so that R_ keeps counting
 	/*const*/ uint8_t Rmask; // 0x7F for Z80, 0xFF for R800
 	unsigned prev_;
 };
@@ -6,6 +6,7 @@
 #include "Z80.hh"
 
 #include "Debugger.hh"
+#include "HostProfiler.hh"
 #include "IntegerSetting.hh"
 #include "MSXMotherBoard.hh"
 #include "Scheduler.hh"
@@ -115,8 +116,10 @@ void MSXCPU::execute(bool fastForward)
 		copy_to_range(from.read,  to.read);
 		copy_to_range(from.write, to.write);
 	}
-	z80Active ? z80 ->execute(fastForward)
-	          : r800->execute(fastForward);
+	HostProfiler::profile(HostProfiler::Category::CPU, z80Active ? "Z80" : "R800", [&] {
+		z80Active ? z80 ->execute(fastForward)
+		          : r800->execute(fastForward);
+	});
 }
 
 void MSXCPU::exitCPULoopSync()
@@ -348,6 +351,16 @@ CPURegs& MSXCPU::getRegisters()
 	}
 }
 
+uint64_t MSXCPU::getRefreshCount() const
+{
+	return z80->getRefreshCount() + (r800 ? r800->getRefreshCount() : 0);
+}
+
+unsigned MSXCPU::getActiveFreq() const
+{
+	return z80Active ? z80->getFreq() : r800->getFreq();
+}
+
 void MSXCPU::update(const Setting& setting) noexcept
 {
 	          z80 ->update(setting);
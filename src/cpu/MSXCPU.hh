@@ -149,6 +149,12 @@ public:
 
 	[[nodiscard]] CPURegs& getRegisters();
 
+	/** The sum of CPURegs::getRefreshCount() of both Z80 and R800. */
+	[[nodiscard]] uint64_t getRefreshCount() const;
+
+	/** The clock frequency of the currently active CPU. */
+	[[nodiscard]] unsigned getActiveFreq() const;
+
 	[[nodiscard]] auto* getZ80() { return z80.get(); }
 	[[nodiscard]] auto* getR800() { return r800.get(); }
 
@@ -3,6 +3,8 @@
 #include "BooleanSetting.hh"
 #include "CartridgeSlotManager.hh"
 #include "CommandException.hh"
+#include "Debuggable.hh"
+#include "Debugger.hh"
 #include "DeviceFactory.hh"
 #include "DummyDevice.hh"
 #include "Event.hh"
@@ -72,6 +74,8 @@ std::ostream& operator<<(std::ostream& os, EnumValueName<CacheLineCounters> evn)
 		"FillReadWrite",
 		"FillRead",
 		"FillWrite",
+		"WatchedLineRead",
+		"WatchedLineWrite",
 	};
 	return os << names[size_t(evn.e)];
 }
@@ -187,6 +191,22 @@ void MSXCPUInterface::removeAllWatchPoints()
 	}
 }
 
+const uint8_t* MSXCPUInterface::getWatchedReadCacheLine(uint16_t start) const
+{
+	if (disallowReadCache[start >> CacheLine::BITS] != MEMORY_WATCH_BIT) {
+		return nullptr;
+	}
+	return visibleDevices[start >> 14]->getReadCacheLine(start);
+}
+
+uint8_t* MSXCPUInterface::getWatchedWriteCacheLine(uint16_t start) const
+{
+	if (disallowWriteCache[start >> CacheLine::BITS] != MEMORY_WATCH_BIT) {
+		return nullptr;
+	}
+	return visibleDevices[start >> 14]->getWriteCacheLine(start);
+}
+
 uint8_t MSXCPUInterface::readMemSlow(uint16_t address, EmuTime time)
 {
 	tick(CacheLineCounters::DisallowCacheRead);
@@ -903,15 +923,16 @@ bool MSXCPUInterface::checkBreakPoints(unsigned pc)
 
 	auto& globalCliComm = motherBoard.getReactor().getGlobalCliComm();
 	auto& interp        = motherBoard.getReactor().getInterpreter();
+	ConditionContext context(*this);
 	auto scopedBlock = motherBoard.getStateChangeDistributor().tempBlockNewEventsDuringReplay();
 	for (auto& p : bpCopy) {
-		bool remove = p.checkAndExecute(globalCliComm, interp);
+		bool remove = p.checkAndExecute(globalCliComm, interp, context);
 		if (remove) {
 			removeBreakPoint(p.getId());
 		}
 	}
 	for (auto& c : condCopy) {
-		bool remove = c.checkAndExecute(globalCliComm, interp);
+		bool remove = c.checkAndExecute(globalCliComm, interp, context);
 		if (remove) {
 			removeCondition(c.getId());
 		}
@@ -1055,9 +1076,12 @@ void MSXCPUInterface::executeMemWatch(WatchPoint::Type type,
 	auto& interp        = motherBoard.getReactor().getInterpreter();
 	interp.setVariable(TclObject("wp_last_address"),
 	                   TclObject(int(address)));
+	ConditionContext context(*this);
+	context.wpLastAddress = narrow_cast<uint16_t>(address);
 	if (value != ~0u) {
 		interp.setVariable(TclObject("wp_last_value"),
 		                   TclObject(int(value)));
+		context.wpLastValue = narrow_cast<uint8_t>(value);
 	}
 
 	auto scopedBlock = motherBoard.getStateChangeDistributor().tempBlockNewEventsDuringReplay();
@@ -1065,7 +1089,7 @@ void MSXCPUInterface::executeMemWatch(WatchPoint::Type type,
 		if ((w->getBeginAddress() <= address) &&
 		    (w->getEndAddress()   >= address) &&
 		    (w->getType()         == type)) {
-			bool remove = w->checkAndExecute(globalCliComm, interp);
+			bool remove = w->checkAndExecute(globalCliComm, interp, context);
 			if (remove) {
 				removeWatchPoint(w);
 			}
@@ -1076,6 +1100,27 @@ void MSXCPUInterface::executeMemWatch(WatchPoint::Type type,
 	interp.unsetVariable("wp_last_value");
 }
 
+uint8_t MSXCPUInterface::ConditionContext::readReg(unsigned index)
+{
+	if (!cpuRegs) {
+		cpuRegs = interface.motherBoard.getDebugger().findDebuggable("CPU regs");
+		assert(cpuRegs);
+	}
+	return cpuRegs->read(index);
+}
+
+uint8_t MSXCPUInterface::ConditionContext::peek(uint16_t address)
+{
+	return interface.peekMem(address, interface.motherBoard.getCurrentTime());
+}
+
+std::pair<int, int> MSXCPUInterface::ConditionContext::getSelectedSlot(unsigned page)
+{
+	int ps = interface.primarySlotState[page];
+	int ss = interface.isExpanded(ps) ? interface.secondarySlotState[page] : -1;
+	return {ps, ss};
+}
+
 
 void MSXCPUInterface::doBreak()
 {
@@ -3,6 +3,7 @@
 
 #include "BreakPoint.hh"
 #include "CacheLine.hh"
+#include "CompiledCondition.hh"
 #include "DebugCondition.hh"
 #include "WatchPoint.hh"
 
@@ -18,6 +19,7 @@
 #include <concepts>
 #include <cstdint>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace openmsx {
@@ -25,6 +27,7 @@ namespace openmsx {
 class BooleanSetting;
 class BreakPoint;
 class CliComm;
+class Debuggable;
 class DummyDevice;
 class MSXCPU;
 class MSXMotherBoard;
@@ -47,6 +50,8 @@ enum class CacheLineCounters : uint8_t {
 	FillReadWrite,
 	FillRead,
 	FillWrite,
+	WatchedLineRead,
+	WatchedLineWrite,
 	NUM // must be last
 };
 std::ostream& operator<<(std::ostream& os, EnumTypeName<CacheLineCounters>);
@@ -215,6 +220,25 @@ public:
 		return visibleDevices[start >> 14]->getWriteCacheLine(start);
 	}
 
+	/**
+	 * Like getReadCacheLine(), but for a line that is only non-cacheable
+	 * because it contains addresses with a read watchpoint. For all other
+	 * lines this returns a null pointer. The caller must still check
+	 * isReadWatched() before each access via the returned buffer.
+	 */
+	[[nodiscard]] const uint8_t* getWatchedReadCacheLine(uint16_t start) const;
+
+	/** Same as above, for write watchpoints. */
+	[[nodiscard]] uint8_t* getWatchedWriteCacheLine(uint16_t start) const;
+
+	/** Is there a read/write watchpoint on the given address? */
+	[[nodiscard]] bool isReadWatched(uint16_t address) const {
+		return readWatchSet[address >> CacheLine::BITS][address & CacheLine::LOW];
+	}
+	[[nodiscard]] bool isWriteWatched(uint16_t address) const {
+		return writeWatchSet[address >> CacheLine::BITS][address & CacheLine::LOW];
+	}
+
 	/**
 	 * CPU uses this method to read 'extra' data from the data bus
 	 * used in interrupt routines. In MSX this returns always 255.
@@ -298,6 +322,21 @@ public:
 		return ScopedChangeWatchpoint(*this, std::move(wp));
 	}
 
+	/** The machine state as seen by compiled break point conditions. */
+	class ConditionContext final : public CompiledCondition::Context {
+	public:
+		explicit ConditionContext(MSXCPUInterface& interface_)
+			: interface(interface_) {}
+
+		[[nodiscard]] uint8_t readReg(unsigned index) override;
+		[[nodiscard]] uint8_t peek(uint16_t address) override;
+		[[nodiscard]] std::pair<int, int> getSelectedSlot(unsigned page) override;
+
+	private:
+		MSXCPUInterface& interface;
+		Debuggable* cpuRegs = nullptr; // looked up on first use
+	};
+
 	void setCondition(DebugCondition cond);
 	void removeCondition(const DebugCondition& cond);
 	void removeCondition(unsigned id);
@@ -8,6 +8,7 @@
 #include "TclObject.hh"
 
 #include "checked_cast.hh"
+#include "narrow.hh"
 #include "one_of.hh"
 
 #include <cassert>
@@ -62,12 +63,14 @@ void WatchPoint::doReadCallback(MSXMotherBoard& motherBoard, unsigned port)
 	auto& cliComm = reactor.getGlobalCliComm();
 	auto& interp  = reactor.getInterpreter();
 	interp.setVariable(TclObject("wp_last_address"), TclObject(int(port)));
+	MSXCPUInterface::ConditionContext context(cpuInterface);
+	context.wpLastAddress = narrow_cast<uint16_t>(port);
 
 	// keep this object alive by holding a shared_ptr to it, for the case
 	// this watchpoint deletes itself in checkAndExecute()
 	auto keepAlive = shared_from_this();
 	auto scopedBlock = motherBoard.getStateChangeDistributor().tempBlockNewEventsDuringReplay();
-	if (bool remove = checkAndExecute(cliComm, interp); remove) {
+	if (bool remove = checkAndExecute(cliComm, interp, context); remove) {
 		cpuInterface.removeWatchPoint(keepAlive);
 	}
 
@@ -84,11 +87,14 @@ void WatchPoint::doWriteCallback(MSXMotherBoard& motherBoard, unsigned port, uns
 	auto& interp  = reactor.getInterpreter();
 	interp.setVariable(TclObject("wp_last_address"), TclObject(int(port)));
 	interp.setVariable(TclObject("wp_last_value"),   TclObject(int(value)));
+	MSXCPUInterface::ConditionContext context(cpuInterface);
+	context.wpLastAddress = narrow_cast<uint16_t>(port);
+	context.wpLastValue = narrow_cast<uint8_t>(value);
 
 	// see comment in doReadCallback() above
 	auto keepAlive = shared_from_this();
 	auto scopedBlock = motherBoard.getStateChangeDistributor().tempBlockNewEventsDuringReplay();
-	if (bool remove = checkAndExecute(cliComm, interp); remove) {
+	if (bool remove = checkAndExecute(cliComm, interp, context); remove) {
 		cpuInterface.removeWatchPoint(keepAlive);
 	}
 
@@ -0,0 +1,672 @@
+#include "CompiledCondition.hh"
+
+#include "CommandException.hh"
+
+#include "StringOp.hh"
+#include "one_of.hh"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cctype>
+#include <charconv>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace openmsx {
+
+// Same names and indices as in _cpuregs.tcl.
+static constexpr std::array<std::pair<std::string_view, int>, 28> byteRegs = {{
+	{"A",    0}, {"F",    1}, {"B",    2}, {"C",    3},
+	{"D",    4}, {"E",    5}, {"H",    6}, {"L",    7},
+	{"A2",   8}, {"F2",   9}, {"B2",  10}, {"C2",  11},
+	{"D2",  12}, {"E2",  13}, {"H2",  14}, {"L2",  15},
+	{"IXH", 16}, {"IXL", 17}, {"IYH", 18}, {"IYL", 19},
+	{"PCH", 20}, {"PCL", 21}, {"SPH", 22}, {"SPL", 23},
+	{"I",   24}, {"R",   25}, {"IM",  26}, {"IFF", 27},
+}};
+static constexpr std::array<std::pair<std::string_view, int>, 12> wordRegs = {{
+	{"AF",   0}, {"BC",   2}, {"DE",   4}, {"HL",   6},
+	{"AF2",  8}, {"BC2", 10}, {"DE2", 12}, {"HL2", 14},
+	{"IX",  16}, {"IY",  18}, {"PC",  20}, {"SP",  22},
+}};
+static constexpr int PC_INDEX = 20;
+
+// Longer operators first, so that e.g. "<<" is not seen as "<".
+static constexpr std::array<std::string_view, 25> operators = {
+	"<<", ">>", "<=", ">=", "==", "!=", "&&", "||", "**",
+	"+", "-", "*", "/", "%", "<", ">", "&", "^", "|", "!", "~",
+	"?", ":", "(", ")",
+};
+
+[[nodiscard]] static bool isAlnum(char c)
+{
+	return std::isalnum(static_cast<unsigned char>(c));
+}
+
+[[nodiscard]] static std::optional<int64_t> parseInteger(std::string_view word)
+{
+	int base = 10;
+	if ((word.size() > 2) && (word[0] == '0')) {
+		switch (word[1]) {
+			case 'x': case 'X': base = 16; break;
+			case 'o': case 'O': base =  8; break;
+			case 'b': case 'B': base =  2; break;
+			// A leading zero means octal in Tcl 8, but not in Tcl 9.
+			default: return {};
+		}
+		word.remove_prefix(2);
+	} else if ((word.size() > 1) && (word[0] == '0')) {
+		return {};
+	}
+	uint64_t value = 0;
+	const auto* end = word.data() + word.size();
+	auto [ptr, ec] = std::from_chars(word.data(), end, value, base);
+	if ((ec != std::errc{}) || (ptr != end) || word.empty() ||
+	    (value > uint64_t(std::numeric_limits<int64_t>::max()))) {
+		return {};
+	}
+	return int64_t(value);
+}
+
+// Overflow checked arithmetic, nullopt when the result doesn't fit in 64 bits.
+[[nodiscard]] static std::optional<int64_t> checkedAdd(int64_t a, int64_t b)
+{
+	using L = std::numeric_limits<int64_t>;
+	if ((b > 0) ? (a > L::max() - b) : (a < L::min() - b)) return {};
+	return a + b;
+}
+[[nodiscard]] static std::optional<int64_t> checkedSub(int64_t a, int64_t b)
+{
+	using L = std::numeric_limits<int64_t>;
+	if ((b < 0) ? (a > L::max() + b) : (a < L::min() + b)) return {};
+	return a - b;
+}
+[[nodiscard]] static std::optional<int64_t> checkedMul(int64_t a, int64_t b)
+{
+	using L = std::numeric_limits<int64_t>;
+	if ((a == -1) || (b == -1)) {
+		auto other = (a == -1) ? b : a;
+		if (other == L::min()) return {};
+		return -other;
+	}
+	auto r = int64_t(uint64_t(a) * uint64_t(b));
+	if ((b != 0) && (r / b != a)) return {};
+	return r;
+}
+
+namespace {
+
+/** The possible values of an (intermediate) result. */
+struct Range {
+	int64_t min;
+	int64_t max;
+	bool inSlot = false; // result of pc_in_slot, in Tcl "true" or 0
+};
+constexpr Range BOOL = {0, 1};
+constexpr Range ANY = {std::numeric_limits<int64_t>::min(),
+                       std::numeric_limits<int64_t>::max()};
+
+} // namespace
+
+/** Recursive descent parser for the supported subset of Tcl expressions,
+  * directly emits the bytecode.
+  *
+  * For each value on the (evaluation) stack it keeps track of the range of
+  * possible values, so that it can refuse expressions that might overflow.
+  */
+class ConditionParser
+{
+	using Op = CompiledCondition::Op;
+
+public:
+	struct Unsupported {};
+
+	explicit ConditionParser(std::string_view input_) : input(input_) {}
+
+	/** @throw Unsupported */
+	[[nodiscard]] CompiledCondition parse() {
+		parseTernary();
+		skipSpace();
+		if (pos != input.size()) throw Unsupported{};
+		assert(ranges.size() == 1);
+		return std::move(result);
+	}
+
+private:
+	void push(Range range) {
+		ranges.push_back(range);
+		if (ranges.size() > CompiledCondition::MAX_STACK) throw Unsupported{};
+	}
+	Range pop() {
+		assert(!ranges.empty());
+		auto range = ranges.back();
+		ranges.pop_back();
+		return range;
+	}
+	// Pop an operand that is used as a number (not only as a boolean).
+	Range popNumber() {
+		auto range = pop();
+		if (range.inSlot) throw Unsupported{};
+		return range;
+	}
+
+	// All possible results of a monotonic operation lie in between the
+	// results for the corners of the operand ranges.
+	template<typename F>
+	[[nodiscard]] static Range corners(Range a, Range b, F op) {
+		Range r = {ANY.max, ANY.min};
+		for (auto x : {a.min, a.max}) {
+			for (auto y : {b.min, b.max}) {
+				auto v = op(x, y);
+				if (!v) throw Unsupported{}; // might overflow
+				r.min = std::min(r.min, *v);
+				r.max = std::max(r.max, *v);
+			}
+		}
+		return r;
+	}
+	[[nodiscard]] static Range binaryRange(Op op, Range a, Range b) {
+		switch (op) {
+		case Op::MUL:
+			return corners(a, b, checkedMul);
+		case Op::ADD:
+			return corners(a, b, checkedAdd);
+		case Op::SUB:
+			return corners(a, b, checkedSub);
+		case Op::DIV:
+			// |a / b| <= |a|, except for 'min / -1'
+			if (a.min == ANY.min) {
+				if ((b.min <= -1) && (-1 <= b.max)) throw Unsupported{};
+				return ANY;
+			} else {
+				auto m = std::max(-a.min, a.max);
+				return {-m, m};
+			}
+		case Op::MOD: {
+			// |a % b| < |b|
+			if (b.min == ANY.min) return ANY;
+			auto m = std::max({-b.min, b.max, int64_t(1)});
+			return {1 - m, m - 1};
+		}
+		case Op::SHL: {
+			if (b.max < 0) return {0, 0}; // always throws
+			if ((a.min == 0) && (a.max == 0)) return a;
+			if (b.max >= 63) throw Unsupported{};
+			Range factor = {int64_t(1) << std::max(b.min, int64_t(0)),
+			                int64_t(1) << b.max};
+			return corners(a, factor, checkedMul);
+		}
+		case Op::SHR:
+			return {std::min(a.min, int64_t(0)), std::max(a.max, int64_t(0))};
+		case Op::BIT_AND:
+			if ((a.min >= 0) && (b.min >= 0)) return {0, std::min(a.max, b.max)};
+			if (a.min >= 0) return {0, a.max};
+			if (b.min >= 0) return {0, b.max};
+			return ANY;
+		case Op::BIT_XOR:
+		case Op::BIT_OR:
+			if ((a.min >= 0) && (b.min >= 0)) {
+				auto bits = std::bit_width(uint64_t(std::max(a.max, b.max)));
+				return {0, int64_t((uint64_t(1) << bits) - 1)};
+			}
+			return ANY;
+		default: // comparisons
+			return BOOL;
+		}
+	}
+
+	void emit(Op op, int64_t arg = 0, int arg2 = 0) {
+		switch (op) {
+		case Op::PUSH:       push({arg, arg}); break;
+		case Op::REG8:       push({0, 0xFF}); break;
+		case Op::REG16:      push({0, 0xFFFF}); break;
+		case Op::WP_ADDRESS: push({0, 0xFFFF}); break;
+		case Op::WP_VALUE:   push({0, 0xFF}); break;
+		case Op::PEEK8:      popNumber(); push({0, 0xFF}); break;
+		case Op::PEEK16:     popNumber(); push({0, 0xFFFF}); break;
+		case Op::IN_SLOT:    popNumber(); push({0, 1, true}); break;
+		case Op::NEG: {
+			auto a = popNumber();
+			push(corners({0, 0}, a, checkedSub));
+			break;
+		}
+		case Op::BIT_NOT: {
+			auto a = popNumber();
+			push({~a.max, ~a.min});
+			break;
+		}
+		case Op::NOT: case Op::TO_BOOL:
+			pop();
+			push(BOOL);
+			break;
+		case Op::AND_JUMP: case Op::OR_JUMP: case Op::JUMP_IF_ZERO:
+			pop();
+			break;
+		case Op::JUMP:
+			break;
+		default: { // binary operators
+			auto b = popNumber();
+			auto a = popNumber();
+			push(binaryRange(op, a, b));
+		}
+		}
+		result.code.push_back({.op = op, .arg2 = arg2, .arg = arg});
+	}
+	[[nodiscard]] size_t emitJump(Op op) {
+		emit(op);
+		return result.code.size() - 1;
+	}
+	void patchJump(size_t jump) {
+		result.code[jump].arg = int64_t(result.code.size());
+	}
+
+	void skipSpace() {
+		while ((pos < input.size()) && (input[pos] == one_of(' ', '\t', '\n', '\r'))) ++pos;
+	}
+	[[nodiscard]] std::string_view peekOperator() {
+		skipSpace();
+		auto rest = input.substr(pos);
+		for (auto op : operators) {
+			if (rest.starts_with(op)) return op;
+		}
+		return {};
+	}
+	[[nodiscard]] bool accept(std::string_view op) {
+		if (peekOperator() != op) return false;
+		pos += op.size();
+		return true;
+	}
+	void expect(std::string_view op) {
+		if (!accept(op)) throw Unsupported{};
+	}
+
+	void parseTernary() {
+		parseOr();
+		if (accept("?")) {
+			auto ifZero = emitJump(Op::JUMP_IF_ZERO);
+			parseTernary();
+			expect(":");
+			auto toEnd = emitJump(Op::JUMP);
+			auto a = pop(); // only one of both alternatives is evaluated
+			patchJump(ifZero);
+			parseTernary();
+			auto b = pop();
+			push({std::min(a.min, b.min), std::max(a.max, b.max),
+			      a.inSlot || b.inSlot});
+			patchJump(toEnd);
+		}
+	}
+	void parseOr() {
+		parseAnd();
+		while (accept("||")) {
+			auto toEnd = emitJump(Op::OR_JUMP);
+			parseAnd();
+			emit(Op::TO_BOOL);
+			patchJump(toEnd);
+		}
+	}
+	void parseAnd() {
+		parseBitOr();
+		while (accept("&&")) {
+			auto toEnd = emitJump(Op::AND_JUMP);
+			parseBitOr();
+			emit(Op::TO_BOOL);
+			patchJump(toEnd);
+		}
+	}
+	template<typename Next, size_t N>
+	void parseBinary(Next next, const std::array<std::pair<std::string_view, Op>, N>& ops) {
+		next();
+		while (true) {
+			auto op = peekOperator();
+			auto it = std::ranges::find(ops, op, &std::pair<std::string_view, Op>::first);
+			if (op.empty() || (it == ops.end())) return;
+			pos += op.size();
+			next();
+			emit(it->second);
+		}
+	}
+	void parseBitOr() {
+		static constexpr std::array ops = {std::pair{std::string_view("|"), Op::BIT_OR}};
+		parseBinary([&] { parseBitXor(); }, ops);
+	}
+	void parseBitXor() {
+		static constexpr std::array ops = {std::pair{std::string_view("^"), Op::BIT_XOR}};
+		parseBinary([&] { parseBitAnd(); }, ops);
+	}
+	void parseBitAnd() {
+		static constexpr std::array ops = {std::pair{std::string_view("&"), Op::BIT_AND}};
+		parseBinary([&] { parseEquality(); }, ops);
+	}
+	void parseEquality() {
+		static constexpr std::array ops = {
+			std::pair{std::string_view("=="), Op::EQ},
+			std::pair{std::string_view("!="), Op::NE}};
+		parseBinary([&] { parseRelational(); }, ops);
+	}
+	void parseRelational() {
+		static constexpr std::array ops = {
+			std::pair{std::string_view("<"),  Op::LT},
+			std::pair{std::string_view(">"),  Op::GT},
+			std::pair{std::string_view("<="), Op::LE},
+			std::pair{std::string_view(">="), Op::GE}};
+		parseBinary([&] { parseShift(); }, ops);
+	}
+	void parseShift() {
+		static constexpr std::array ops = {
+			std::pair{std::string_view("<<"), Op::SHL},
+			std::pair{std::string_view(">>"), Op::SHR}};
+		parseBinary([&] { parseAdditive(); }, ops);
+	}
+	void parseAdditive() {
+		static constexpr std::array ops = {
+			std::pair{std::string_view("+"), Op::ADD},
+			std::pair{std::string_view("-"), Op::SUB}};
+		parseBinary([&] { parseMultiplicative(); }, ops);
+	}
+	void parseMultiplicative() {
+		static constexpr std::array ops = {
+			std::pair{std::string_view("*"), Op::MUL},
+			std::pair{std::string_view("/"), Op::DIV},
+			std::pair{std::string_view("%"), Op::MOD}};
+		parseBinary([&] { parseUnary(); }, ops);
+	}
+	void parseUnary() {
+		if (accept("-")) {
+			parseUnary();
+			emit(Op::NEG);
+		} else if (accept("+")) {
+			parseUnary();
+		} else if (accept("~")) {
+			parseUnary();
+			emit(Op::BIT_NOT);
+		} else if (accept("!")) {
+			parseUnary();
+			emit(Op::NOT);
+		} else {
+			parsePrimary();
+		}
+	}
+	void parsePrimary() {
+		if (accept("(")) {
+			parseTernary();
+			expect(")");
+			return;
+		}
+		skipSpace();
+		if (pos == input.size()) throw Unsupported{};
+		if (input[pos] == '[') {
+			++pos;
+			parseCommand();
+		} else if (input[pos] == '$') {
+			++pos;
+			parseVariable();
+		} else {
+			auto start = pos;
+			while ((pos < input.size()) &&
+			       (isAlnum(input[pos]) || (input[pos] == one_of('_', '.')))) {
+				++pos;
+			}
+			auto value = parseInteger(input.substr(start, pos - start));
+			if (!value) throw Unsupported{};
+			emit(Op::PUSH, *value);
+		}
+	}
+	void parseVariable() {
+		auto start = pos;
+		while ((pos < input.size()) &&
+		       (isAlnum(input[pos]) || (input[pos] == one_of('_', ':')))) {
+			++pos;
+		}
+		auto name = input.substr(start, pos - start);
+		if (name.starts_with("::")) name.remove_prefix(2);
+		if (name == "wp_last_address") {
+			emit(Op::WP_ADDRESS);
+		} else if (name == "wp_last_value") {
+			emit(Op::WP_VALUE);
+		} else {
+			throw Unsupported{};
+		}
+	}
+
+	// Inside a command: words are separated by spaces or tabs.
+	void skipWordSpace() {
+		while ((pos < input.size()) && (input[pos] == one_of(' ', '\t'))) ++pos;
+	}
+	[[nodiscard]] bool atCommandEnd() {
+		skipWordSpace();
+		return (pos < input.size()) && (input[pos] == ']');
+	}
+	[[nodiscard]] std::string_view readWord() {
+		skipWordSpace();
+		auto start = pos;
+		while ((pos < input.size()) &&
+		       (isAlnum(input[pos]) || (input[pos] == one_of('_', '.', '-', '+')))) {
+			++pos;
+		}
+		if (pos == start) throw Unsupported{}; // e.g. quotes, braces, ...
+		return input.substr(start, pos - start);
+	}
+	// Pushes the value of a command argument.
+	void parseArgument() {
+		skipWordSpace();
+		if ((pos < input.size()) && (input[pos] == '[')) {
+			++pos;
+			parseCommand();
+		} else {
+			auto value = parseInteger(readWord());
+			if (!value) throw Unsupported{};
+			emit(Op::PUSH, *value);
+		}
+	}
+	[[nodiscard]] int parseSlot() {
+		auto word = readWord();
+		if (word == "X") return -1;
+		auto value = parseInteger(word);
+		if (!value || (*value < 0) || (*value > 3)) throw Unsupported{};
+		return int(*value);
+	}
+	// Pushes the result of the command, the opening '[' is already parsed.
+	void parseCommand() {
+		auto name = readWord();
+		if (name == "reg") {
+			auto reg = readWord();
+			auto sameName = [&](const auto& p) { return StringOp::casecmp{}(p.first, reg); };
+			if (auto it = std::ranges::find_if(byteRegs, sameName); it != byteRegs.end()) {
+				emit(Op::REG8, it->second);
+			} else if (auto it2 = std::ranges::find_if(wordRegs, sameName); it2 != wordRegs.end()) {
+				emit(Op::REG16, it2->second);
+			} else {
+				throw Unsupported{};
+			}
+		} else if (name == one_of("peek", "peek8", "peek_u8", "peek16", "peek_u16")) {
+			parseArgument();
+			if (!atCommandEnd() && (readWord() != "memory")) {
+				throw Unsupported{};
+			}
+			emit(name.contains("16") ? Op::PEEK16 : Op::PEEK8);
+		} else if (name == one_of("pc_in_slot", "watch_in_slot")) {
+			if (name == "pc_in_slot") {
+				emit(Op::REG16, PC_INDEX);
+			} else {
+				emit(Op::WP_ADDRESS);
+			}
+			int ps = parseSlot();
+			int ss = atCommandEnd() ? -1 : parseSlot();
+			// checking the mapper block is not supported
+			emit(Op::IN_SLOT, ps, ss);
+		} else {
+			throw Unsupported{};
+		}
+		if (!atCommandEnd()) throw Unsupported{};
+		++pos; // skip ']'
+	}
+
+private:
+	std::string_view input;
+	size_t pos = 0;
+	std::vector<Range> ranges;
+	CompiledCondition result;
+};
+
+std::shared_ptr<const CompiledCondition> CompiledCondition::compile(std::string_view expression)
+{
+	try {
+		return std::make_shared<const CompiledCondition>(ConditionParser(expression).parse());
+	} catch (ConditionParser::Unsupported&) {
+		return nullptr;
+	}
+}
+
+[[nodiscard]] static uint8_t peekAddress(CompiledCondition::Context& context, int64_t address)
+{
+	if ((address < 0) || (address > 0xFFFF)) {
+		throw CommandException("Invalid address");
+	}
+	return context.peek(uint16_t(address));
+}
+
+int64_t CompiledCondition::evaluate(Context& context) const
+{
+	std::array<int64_t, MAX_STACK> stack;
+	size_t sp = 0;
+	auto binary = [&](auto op) {
+		auto b = stack[--sp];
+		auto& a = stack[sp - 1];
+		a = op(a, b);
+	};
+
+	size_t pc = 0;
+	while (pc < code.size()) {
+		const auto& instr = code[pc++];
+		switch (instr.op) {
+		case Op::PUSH:
+			stack[sp++] = instr.arg;
+			break;
+		case Op::REG8:
+			stack[sp++] = context.readReg(unsigned(instr.arg));
+			break;
+		case Op::REG16:
+			stack[sp++] = 256 * context.readReg(unsigned(instr.arg)) +
+			                    context.readReg(unsigned(instr.arg + 1));
+			break;
+		case Op::PEEK8:
+			stack[sp - 1] = peekAddress(context, stack[sp - 1]);
+			break;
+		case Op::PEEK16: {
+			auto addr = stack[sp - 1];
+			stack[sp - 1] = peekAddress(context, addr) + 256 * peekAddress(context, addr + 1);
+			break;
+		}
+		case Op::WP_ADDRESS:
+			if (!context.wpLastAddress) {
+				throw CommandException("can't read \"wp_last_address\": no such variable");
+			}
+			stack[sp++] = *context.wpLastAddress;
+			break;
+		case Op::WP_VALUE:
+			if (!context.wpLastValue) {
+				throw CommandException("can't read \"wp_last_value\": no such variable");
+			}
+			stack[sp++] = *context.wpLastValue;
+			break;
+		case Op::IN_SLOT: {
+			// same as 'address_in_slot' in _slot.tcl
+			auto [ps, ss] = context.getSelectedSlot(unsigned(stack[sp - 1] >> 14) & 3);
+			int wantPs = int(instr.arg);
+			int wantSs = instr.arg2;
+			bool in = ((wantPs == -1) || (wantPs == ps)) &&
+			          ((wantSs == -1) || (ss == -1) || (wantSs == ss));
+			stack[sp - 1] = in;
+			break;
+		}
+		case Op::NEG:
+			stack[sp - 1] = int64_t(0 - uint64_t(stack[sp - 1])); // no UB on overflow
+			break;
+		case Op::NOT:
+			stack[sp - 1] = stack[sp - 1] == 0;
+			break;
+		case Op::BIT_NOT:
+			stack[sp - 1] = ~stack[sp - 1];
+			break;
+		case Op::TO_BOOL:
+			stack[sp - 1] = stack[sp - 1] != 0;
+			break;
+		case Op::MUL:
+			binary([](int64_t a, int64_t b) { return int64_t(uint64_t(a) * uint64_t(b)); });
+			break;
+		case Op::DIV:
+			binary([](int64_t a, int64_t b) {
+				if (b == 0) throw CommandException("divide by zero");
+				if (b == -1) return int64_t(0 - uint64_t(a));
+				// Tcl rounds towards negative infinity
+				auto q = a / b;
+				if (((a % b) != 0) && ((a < 0) != (b < 0))) --q;
+				return q;
+			});
+			break;
+		case Op::MOD:
+			binary([](int64_t a, int64_t b) {
+				if (b == 0) throw CommandException("divide by zero");
+				if (b == -1) return int64_t(0);
+				// the result has the same sign as the divisor
+				auto r = a % b;
+				if ((r != 0) && ((r < 0) != (b < 0))) r += b;
+				return r;
+			});
+			break;
+		case Op::ADD:
+			binary([](int64_t a, int64_t b) { return int64_t(uint64_t(a) + uint64_t(b)); });
+			break;
+		case Op::SUB:
+			binary([](int64_t a, int64_t b) { return int64_t(uint64_t(a) - uint64_t(b)); });
+			break;
+		case Op::SHL:
+			binary([](int64_t a, int64_t b) {
+				if (b < 0) throw CommandException("negative shift argument");
+				return (b >= 64) ? 0 : int64_t(uint64_t(a) << b);
+			});
+			break;
+		case Op::SHR:
+			binary([](int64_t a, int64_t b) {
+				if (b < 0) throw CommandException("negative shift argument");
+				return (b >= 64) ? ((a < 0) ? -1 : 0) : (a >> b);
+			});
+			break;
+		case Op::LT: binary([](int64_t a, int64_t b) { return int64_t(a <  b); }); break;
+		case Op::GT: binary([](int64_t a, int64_t b) { return int64_t(a >  b); }); break;
+		case Op::LE: binary([](int64_t a, int64_t b) { return int64_t(a <= b); }); break;
+		case Op::GE: binary([](int64_t a, int64_t b) { return int64_t(a >= b); }); break;
+		case Op::EQ: binary([](int64_t a, int64_t b) { return int64_t(a == b); }); break;
+		case Op::NE: binary([](int64_t a, int64_t b) { return int64_t(a != b); }); break;
+		case Op::BIT_AND: binary([](int64_t a, int64_t b) { return a & b; }); break;
+		case Op::BIT_XOR: binary([](int64_t a, int64_t b) { return a ^ b; }); break;
+		case Op::BIT_OR:  binary([](int64_t a, int64_t b) { return a | b; }); break;
+		case Op::AND_JUMP:
+			if (stack[--sp] == 0) {
+				stack[sp++] = 0;
+				pc = size_t(instr.arg);
+			}
+			break;
+		case Op::OR_JUMP:
+			if (stack[--sp] != 0) {
+				stack[sp++] = 1;
+				pc = size_t(instr.arg);
+			}
+			break;
+		case Op::JUMP_IF_ZERO:
+			if (stack[--sp] == 0) pc = size_t(instr.arg);
+			break;
+		case Op::JUMP:
+			pc = size_t(instr.arg);
+			break;
+		}
+	}
+	assert(sp == 1);
+	return stack[0];
+}
+
+} // namespace openmsx
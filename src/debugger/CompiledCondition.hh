@@ -0,0 +1,104 @@
+#ifndef COMPILEDCONDITION_HH
+#define COMPILEDCONDITION_HH
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace openmsx {
+
+/** A breakpoint, watchpoint or debug condition, translated from a Tcl
+  * expression into a small bytecode program. Evaluating that is orders of
+  * magnitude faster than evaluating the expression in the Tcl interpreter
+  * (which e.g. for each [reg A] calls a Tcl proc, which in turn calls the
+  * 'debug read' command).
+  *
+  * Only a common subset of Tcl expressions is recognized:
+  *  - integer literals: decimal, or with 0x, 0o or 0b prefix
+  *  - the operators  - + ~ !  * / %  << >>  < > <= >=  == !=  & ^ |  && ||
+  *    ?:  and parentheses
+  *  - the variables $wp_last_address and $wp_last_value (with or without
+  *    :: prefix)
+  *  - these commands (procs from the standard scripts):
+  *      [reg <name>]
+  *      [peek <addr>]  [peek8 ..]  [peek_u8 ..]  [peek16 ..]  [peek_u16 ..]
+  *      [pc_in_slot <ps> [<ss>]]  [watch_in_slot <ps> [<ss>]]
+  *    where the arguments are literals (or 'X' for the slots) or nested
+  *    commands. The optional <mem> argument of peek must be 'memory'.
+  * For anything else compile() fails, and the caller should keep using the
+  * Tcl interpreter. The same happens for expressions that might overflow 64
+  * bits (Tcl switches to arbitrary precision integers), and for expressions
+  * that use the result of pc_in_slot or watch_in_slot other than as a boolean
+  * (in Tcl that result is either "true" or 0). Redefining the above procs has
+  * no effect on compiled conditions.
+  */
+class CompiledCondition
+{
+public:
+	/** Gives access to the (emulated) machine state. */
+	class Context {
+	public:
+		/** Read a byte from the "CPU regs" debuggable. */
+		[[nodiscard]] virtual uint8_t readReg(unsigned index) = 0;
+		/** Read a byte from the "memory" debuggable. */
+		[[nodiscard]] virtual uint8_t peek(uint16_t address) = 0;
+		/** The selected primary and secondary slot (-1 when the primary
+		  * slot is not expanded) in the given page [0..3].
+		  */
+		[[nodiscard]] virtual std::pair<int, int> getSelectedSlot(unsigned page) = 0;
+
+		/** The values of the Tcl variables with the same name, only
+		  * set while checking watchpoints.
+		  */
+		std::optional<uint16_t> wpLastAddress;
+		std::optional<uint8_t> wpLastValue;
+
+	protected:
+		~Context() = default;
+	};
+
+	/** Returns nullptr if the expression is not in the supported subset. */
+	[[nodiscard]] static std::shared_ptr<const CompiledCondition> compile(std::string_view expression);
+
+	/** Where Tcl would give "true" (see above) this returns 1.
+	  * @throw CommandException In the cases Tcl would also throw, e.g.
+	  *        division by zero or an unset watchpoint variable.
+	  */
+	[[nodiscard]] int64_t evaluate(Context& context) const;
+	[[nodiscard]] bool evalBool(Context& context) const { return evaluate(context) != 0; }
+
+private:
+	friend class ConditionParser;
+
+	enum class Op : uint8_t {
+		PUSH,          // push 'arg'
+		REG8, REG16,   // push register 'arg'
+		PEEK8, PEEK16, // replace the address on top with the memory content
+		WP_ADDRESS, WP_VALUE,
+		IN_SLOT,       // replace the address on top with: is it in slot 'arg', 'arg2'?
+		NEG, NOT, BIT_NOT,
+		MUL, DIV, MOD, ADD, SUB, SHL, SHR,
+		LT, GT, LE, GE, EQ, NE,
+		BIT_AND, BIT_XOR, BIT_OR,
+		TO_BOOL,
+		AND_JUMP,      // pop, if zero: push 0 and jump to 'arg'
+		OR_JUMP,       // pop, if non-zero: push 1 and jump to 'arg'
+		JUMP_IF_ZERO,  // pop, if zero: jump to 'arg'
+		JUMP,          // jump to 'arg'
+	};
+	struct Instruction {
+		Op op;
+		int arg2 = 0;
+		int64_t arg = 0;
+	};
+	static constexpr size_t MAX_STACK = 32;
+
+	std::vector<Instruction> code;
+};
+
+} // namespace openmsx
+
+#endif
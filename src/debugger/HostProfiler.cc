@@ -0,0 +1,117 @@
+#include "HostProfiler.hh"
+
+#include "hash_map.hh"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+#ifdef __GNUC__
+#include <cxxabi.h>
+#include <cstdlib>
+#include <memory>
+#endif
+
+namespace openmsx {
+
+using Clock = std::chrono::steady_clock;
+
+static std::vector<HostProfiler::Entry> entries;
+static std::array<hash_map<const void*, unsigned>, size_t(HostProfiler::Category::NUM)> entryIndex;
+static HostProfileScope* currentScope = nullptr;
+static HostProfiler::Duration elapsed{};
+static Clock::time_point enableTime;
+
+void HostProfiler::setEnabled(bool enable)
+{
+	if (enable == enabled) return;
+	if (enable) {
+		enableTime = Clock::now();
+	} else {
+		elapsed += Clock::now() - enableTime;
+	}
+	enabled = enable;
+}
+
+void HostProfiler::reset()
+{
+	// Scopes that are still active keep on referring to their entry, so
+	// only clear the statistics, not the entries themselves.
+	for (auto& e : entries) {
+		e.calls = 0;
+		e.total = e.self = Duration{};
+	}
+	elapsed = Duration{};
+	enableTime = Clock::now();
+}
+
+HostProfiler::Duration HostProfiler::getElapsed()
+{
+	return enabled ? elapsed + (Clock::now() - enableTime) : elapsed;
+}
+
+std::span<const HostProfiler::Entry> HostProfiler::getEntries()
+{
+	return entries;
+}
+
+std::string_view HostProfiler::getCategoryName(Category category)
+{
+	static constexpr std::array<std::string_view, size_t(Category::NUM)> names = {
+		"cpu", "sync_point", "render", "sound", "post_process",
+	};
+	return names[size_t(category)];
+}
+
+std::string HostProfiler::getTypeName(const std::type_info& info)
+{
+	std::string result = info.name();
+#ifdef __GNUC__
+	int status = 0;
+	std::unique_ptr<char, decltype(&free)> demangled(
+		abi::__cxa_demangle(info.name(), nullptr, nullptr, &status), &free);
+	if (status == 0) result = demangled.get();
+#endif
+	// remove "class " (msvc) and namespace prefixes
+	for (std::string_view prefix : {"class ", "struct ", "openmsx::"}) {
+		if (result.starts_with(prefix)) result.erase(0, prefix.size());
+	}
+	return result;
+}
+
+unsigned HostProfiler::findEntry(Category category, const void* key, GetName getName)
+{
+	auto& index = entryIndex[size_t(category)];
+	if (const auto* idx = lookup(index, key)) return *idx;
+	// Note: keys are typically pointers to devices. When such a device gets
+	// deleted, a new device may later get the same address. We don't try
+	// to detect that, it would only (slightly) confuse the statistics.
+	auto idx = unsigned(entries.size());
+	entries.push_back(Entry{getName(key), category});
+	index.emplace(key, idx);
+	return idx;
+}
+
+void HostProfileScope::begin(HostProfiler::Category category, const void* key, HostProfiler::GetName getName)
+{
+	entry = HostProfiler::findEntry(category, key, getName);
+	parent = std::exchange(currentScope, this);
+	start = Clock::now();
+}
+
+void HostProfileScope::end()
+{
+	auto duration = HostProfiler::Duration(Clock::now() - start);
+	auto& e = entries[entry];
+	++e.calls;
+	e.total += duration;
+	e.self += duration - std::min(children, duration);
+
+	assert(currentScope == this);
+	currentScope = parent;
+	if (parent) parent->children += duration;
+}
+
+} // namespace openmsx
@@ -0,0 +1,139 @@
+#ifndef HOSTPROFILER_HH
+#define HOSTPROFILER_HH
+
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <typeinfo>
+
+namespace openmsx {
+
+class HostProfileScope;
+
+/** Attributes host (wall clock) time to the main emulation subsystems: the
+  * CPU emulation loop, the individual scheduler sync points, rendering,
+  * sound generation (per sound device) and post-processing.
+  *
+  * This is always compiled in, but disabled by default. When disabled, the
+  * overhead of profile() is a single (well predicted) branch. When enabled,
+  * the time spent in a nested scope is subtracted from the enclosing scope,
+  * so the 'self' times of all entries add up to (at most) the total elapsed
+  * time.
+  *
+  * The profiler is not bound to a specific MSX machine, it's only used from
+  * the main thread.
+  */
+class HostProfiler
+{
+public:
+	using Duration = std::chrono::nanoseconds;
+	using GetName = std::string (*)(const void* key);
+
+	enum class Category : uint8_t {
+		CPU,          // CPU emulation loop
+		SYNC_POINT,   // a Schedulable, executed from the Scheduler
+		RENDER,       // drawing the MSX video output
+		SOUND,        // a SoundDevice, generating sound
+		POST_PROCESS, // post-processing and uploading a frame
+		NUM
+	};
+
+	struct Entry {
+		std::string name;
+		Category category;
+		uint64_t calls = 0;
+		Duration total{}; // including nested scopes
+		Duration self{};  // excluding nested scopes
+	};
+
+	[[nodiscard]] static bool isEnabled() { return enabled; }
+	static void setEnabled(bool enable);
+
+	/** Set all statistics back to zero (but keep the entries). */
+	static void reset();
+
+	/** Time during which the profiler was enabled (since the last reset). */
+	[[nodiscard]] static Duration getElapsed();
+
+	[[nodiscard]] static std::span<const Entry> getEntries();
+	[[nodiscard]] static std::string_view getCategoryName(Category category);
+
+	/** Readable name for a (polymorphic) type, e.g. "VDP::SyncDisplayStart". */
+	[[nodiscard]] static std::string getTypeName(const std::type_info& info);
+
+	/** Execute 'f' and, when the profiler is enabled, attribute the host
+	  * time it takes to the given entry. For an entry with a fixed name,
+	  * 'name' must be a string literal.
+	  * An entry is identified by its category plus a key (e.g. a pointer
+	  * to a device). The name of an entry is only determined the first
+	  * time that entry is seen.
+	  */
+	static decltype(auto) profile(Category category, const char* name, std::invocable auto&& f);
+	static decltype(auto) profile(Category category, const void* key, GetName getName,
+	                              std::invocable auto&& f);
+
+private:
+	friend class HostProfileScope;
+	[[nodiscard]] static unsigned findEntry(Category category, const void* key, GetName getName);
+
+	static inline bool enabled = false;
+};
+
+/** Measures the host time of the scope in which this object lives. Only
+  * used (and only constructed while the profiler is enabled) by
+  * HostProfiler::profile(), so that a disabled profiler costs a single
+  * branch, not one in both the constructor and the destructor.
+  */
+class HostProfileScope
+{
+public:
+	HostProfileScope(HostProfiler::Category category, const void* key,
+	                 HostProfiler::GetName getName)
+	{
+		begin(category, key, getName);
+	}
+
+	~HostProfileScope()
+	{
+		end();
+	}
+
+	HostProfileScope(const HostProfileScope&) = delete;
+	HostProfileScope(HostProfileScope&&) = delete;
+	HostProfileScope& operator=(const HostProfileScope&) = delete;
+	HostProfileScope& operator=(HostProfileScope&&) = delete;
+
+private:
+	void begin(HostProfiler::Category category, const void* key, HostProfiler::GetName getName);
+	void end();
+
+private:
+	unsigned entry = 0;
+	HostProfileScope* parent = nullptr;
+	std::chrono::steady_clock::time_point start;
+	HostProfiler::Duration children{};
+};
+
+decltype(auto) HostProfiler::profile(Category category, const char* name, std::invocable auto&& f)
+{
+	return profile(category, name, [](const void* key) {
+		return std::string(static_cast<const char*>(key));
+	}, f);
+}
+
+decltype(auto) HostProfiler::profile(Category category, const void* key, GetName getName,
+                                     std::invocable auto&& f)
+{
+	if (isEnabled()) [[unlikely]] {
+		HostProfileScope scope(category, key, getName);
+		return f();
+	}
+	return f();
+}
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,78 @@
+#include "HostProfilerCommand.hh"
+
+#include "HostProfiler.hh"
+#include "TclObject.hh"
+
+#include "stl.hh"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+
+namespace openmsx {
+
+HostProfilerCommand::HostProfilerCommand(CommandController& commandController_)
+	: Command(commandController_, "host_profile")
+{
+}
+
+static double toSeconds(HostProfiler::Duration d)
+{
+	return std::chrono::duration<double>(d).count();
+}
+
+static TclObject report()
+{
+	auto sorted = to_vector(HostProfiler::getEntries());
+	std::erase_if(sorted, [](const auto& e) { return e.calls == 0; });
+	std::ranges::sort(sorted, std::greater<>{}, &HostProfiler::Entry::self);
+
+	TclObject list;
+	for (const auto& e : sorted) {
+		list.addListElement(makeTclDict(
+			"category", HostProfiler::getCategoryName(e.category),
+			"name", e.name,
+			"calls", e.calls,
+			"total", toSeconds(e.total),
+			"self", toSeconds(e.self)));
+	}
+	return makeTclDict(
+		"elapsed", toSeconds(HostProfiler::getElapsed()),
+		"entries", list);
+}
+
+void HostProfilerCommand::execute(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, 2, "subcommand");
+	executeSubCommand(tokens[1].getString(),
+		"start",   [&]{ HostProfiler::setEnabled(true); },
+		"stop",    [&]{ HostProfiler::setEnabled(false); },
+		"reset",   [&]{ HostProfiler::reset(); },
+		"enabled", [&]{ result = HostProfiler::isEnabled(); },
+		"report",  [&]{ result = report(); });
+}
+
+std::string HostProfilerCommand::help(std::span<const TclObject> /*tokens*/) const
+{
+	return "Measure how much host time is spent in the different parts of the emulation.\n"
+	       "  host_profile start     start measuring\n"
+	       "  host_profile stop      stop measuring\n"
+	       "  host_profile reset     set all statistics back to zero\n"
+	       "  host_profile enabled   returns whether measuring is active\n"
+	       "  host_profile report    returns a dict with the elapsed (measuring) time and a\n"
+	       "                         list of entries, sorted on decreasing 'self' time.\n"
+	       "Each entry is a dict with keys 'category', 'name', 'calls', 'total' and 'self'.\n"
+	       "'total' includes the time spent in nested entries (e.g. a sync point executed\n"
+	       "from within the CPU loop), 'self' doesn't. All times are in seconds.\n";
+}
+
+void HostProfilerCommand::tabCompletion(std::vector<std::string>& tokens) const
+{
+	using namespace std::literals;
+	static constexpr std::array cmds = {
+		"start"sv, "stop"sv, "reset"sv, "enabled"sv, "report"sv,
+	};
+	completeString(tokens, cmds);
+}
+
+} // namespace openmsx
@@ -0,0 +1,20 @@
+#ifndef HOSTPROFILERCOMMAND_HH
+#define HOSTPROFILERCOMMAND_HH
+
+#include "Command.hh"
+
+namespace openmsx {
+
+/** The 'host_profile' Tcl command. */
+class HostProfilerCommand final : public Command
+{
+public:
+	explicit HostProfilerCommand(CommandController& commandController);
+	void execute(std::span<const TclObject> tokens, TclObject& result) override;
+	[[nodiscard]] std::string help(std::span<const TclObject> tokens) const override;
+	void tabCompletion(std::vector<std::string>& tokens) const override;
+};
+
+} // namespace openmsx
+
+#endif
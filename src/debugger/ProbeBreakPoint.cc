@@ -3,6 +3,7 @@
 #include "Debugger.hh"
 #include "Probe.hh"
 
+#include "MSXCPUInterface.hh"
 #include "MSXMotherBoard.hh"
 #include "Reactor.hh"
 #include "StateChangeDistributor.hh"
@@ -40,7 +41,8 @@ void ProbeBreakPoint::update(const ProbeBase& /*subject*/) noexcept
 	auto& reactor = motherBoard.getReactor();
 	auto& cliComm = reactor.getGlobalCliComm();
 	auto& interp  = reactor.getInterpreter();
-	bool remove = checkAndExecute(cliComm, interp);
+	MSXCPUInterface::ConditionContext context(motherBoard.getCPUInterface());
+	bool remove = checkAndExecute(cliComm, interp, context);
 	if (remove) {
 		debugger.removeProbeBreakPoint(*this);
 	}
@@ -0,0 +1,107 @@
+#include "ImGuiHostProfiler.hh"
+
+#include "ImGuiCpp.hh"
+#include "ImGuiUtils.hh"
+
+#include "HostProfiler.hh"
+
+#include "stl.hh"
+
+#include <chrono>
+
+namespace openmsx {
+
+using namespace std::literals;
+
+void ImGuiHostProfiler::save(ImGuiTextBuffer& buf)
+{
+	savePersistent(buf, *this, persistentElements);
+}
+
+void ImGuiHostProfiler::loadLine(std::string_view name, zstring_view value)
+{
+	loadOnePersistent(name, value, *this, persistentElements);
+}
+
+void ImGuiHostProfiler::paint(MSXMotherBoard* /*motherBoard*/)
+{
+	if (!show) return;
+
+	ImGui::SetNextWindowSize(gl::vec2{36, 20} * ImGui::GetFontSize(), ImGuiCond_FirstUseEver);
+	im::Window("Host profiler", &show, [&]{
+		bool enabled = HostProfiler::isEnabled();
+		if (ImGui::Checkbox("Enabled", &enabled)) {
+			HostProfiler::setEnabled(enabled);
+		}
+		HelpMarker("Measures how much host time is spent in the different parts of the emulation.\n"
+		           "'Self' excludes the time spent in nested entries, e.g. the sync points\n"
+		           "that get executed from within the CPU emulation loop. 'Total' includes\n"
+		           "that time.");
+		ImGui::SameLine();
+		if (ImGui::Button("Reset")) {
+			HostProfiler::reset();
+		}
+		auto toMs = [](HostProfiler::Duration d) {
+			return std::chrono::duration<double, std::milli>(d).count();
+		};
+		auto elapsed = toMs(HostProfiler::getElapsed());
+		ImGui::SameLine();
+		ImGui::Text("Elapsed: %.1f ms", elapsed);
+
+		auto entries = to_vector(HostProfiler::getEntries());
+		std::erase_if(entries, [](const auto& e) { return e.calls == 0; });
+
+		int flags = ImGuiTableFlags_RowBg |
+		            ImGuiTableFlags_BordersV |
+		            ImGuiTableFlags_BordersOuter |
+		            ImGuiTableFlags_Resizable |
+		            ImGuiTableFlags_Sortable |
+		            ImGuiTableFlags_Hideable |
+		            ImGuiTableFlags_ScrollY;
+		im::Table("##profile", 6, flags, [&]{
+			ImGui::TableSetupScrollFreeze(0, 1); // Make top row always visible
+			ImGui::TableSetupColumn("Category");
+			ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_NoHide);
+			ImGui::TableSetupColumn("Calls");
+			ImGui::TableSetupColumn("Self (ms)", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+			ImGui::TableSetupColumn("Self (%)", ImGuiTableColumnFlags_PreferSortDescending);
+			ImGui::TableSetupColumn("Total (ms)", ImGuiTableColumnFlags_PreferSortDescending);
+			ImGui::TableHeadersRow();
+
+			if (auto* sortSpecs = ImGui::TableGetSortSpecs(); sortSpecs && sortSpecs->SpecsCount) {
+				// The statistics change every frame, so always sort
+				switch (sortSpecs->Specs->ColumnIndex) {
+				case 0: sortUpDown_T(entries, sortSpecs, &HostProfiler::Entry::category); break;
+				case 1: sortUpDown_String(entries, sortSpecs, &HostProfiler::Entry::name); break;
+				case 2: sortUpDown_T(entries, sortSpecs, &HostProfiler::Entry::calls); break;
+				case 3: case 4: sortUpDown_T(entries, sortSpecs, &HostProfiler::Entry::self); break;
+				case 5: sortUpDown_T(entries, sortSpecs, &HostProfiler::Entry::total); break;
+				}
+			}
+
+			for (const auto& e : entries) {
+				if (ImGui::TableNextColumn()) {
+					ImGui::TextUnformatted(HostProfiler::getCategoryName(e.category));
+				}
+				if (ImGui::TableNextColumn()) {
+					ImGui::TextUnformatted(e.name);
+				}
+				if (ImGui::TableNextColumn()) {
+					ImGui::Text("%llu", static_cast<unsigned long long>(e.calls));
+				}
+				auto self = toMs(e.self);
+				if (ImGui::TableNextColumn()) {
+					ImGui::Text("%.2f", self);
+				}
+				if (ImGui::TableNextColumn()) {
+					ImGui::Text("%.1f", (elapsed > 0.0) ? (100.0 * self / elapsed) : 0.0);
+				}
+				if (ImGui::TableNextColumn()) {
+					ImGui::Text("%.2f", toMs(e.total));
+				}
+			}
+		});
+	});
+}
+
+} // namespace openmsx
@@ -8,6 +8,7 @@
 #include "ImGuiDebugger.hh"
 #include "ImGuiDiskManipulator.hh"
 #include "ImGuiHelp.hh"
+#include "ImGuiHostProfiler.hh"
 #include "ImGuiKeyboard.hh"
 #include "ImGuiMachine.hh"
 #include "ImGuiMedia.hh"
@@ -183,6 +184,7 @@ ImGuiManager::ImGuiManager(Reactor& reactor_)
 	sccViewer = std::make_unique<ImGuiSCCViewer>(*this);
 	msxMusicViewer = std::make_unique<ImGuiMsxMusicViewer>(*this);
 	waveViewer = std::make_unique<ImGuiWaveViewer>(*this);
+	hostProfiler = std::make_unique<ImGuiHostProfiler>(*this);
 	diskManipulator = std::make_unique<ImGuiDiskManipulator>(*this);
 	soundChip = std::make_unique<ImGuiSoundChip>(*this);
 	keyboard = std::make_unique<ImGuiKeyboard>(*this);
@@ -37,6 +37,7 @@ class ImGuiConsole;
 class ImGuiDebugger;
 class ImGuiDiskManipulator;
 class ImGuiHelp;
+class ImGuiHostProfiler;
 class ImGuiKeyboard;
 class ImGuiMachine;
 class ImGuiMedia;
@@ -172,6 +173,7 @@ public:
 	std::unique_ptr<ImGuiSCCViewer> sccViewer;
 	std::unique_ptr<ImGuiMsxMusicViewer> msxMusicViewer;
 	std::unique_ptr<ImGuiWaveViewer> waveViewer;
+	std::unique_ptr<ImGuiHostProfiler> hostProfiler;
 	std::unique_ptr<ImGuiCheatFinder> cheatFinder;
 	std::unique_ptr<ImGuiDiskManipulator> diskManipulator;
 	std::unique_ptr<ImGuiSettings> settings;
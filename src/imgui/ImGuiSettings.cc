@@ -244,6 +244,7 @@ void ImGuiSettings::showMenu(MSXMotherBoard* motherBoard)
 			ImGui::Separator();
 			static constexpr std::array resamplerToolTips = {
 				EnumToolTip{.value = "hq",   .tip = "best quality, uses more CPU"},
+				EnumToolTip{.value = "mq",   .tip = "like hq, but a shorter filter, roughly twice as fast"},
 				EnumToolTip{.value = "blip", .tip = "good speed/quality tradeoff"},
 				EnumToolTip{.value = "fast", .tip = "fast but low quality"},
 			};
@@ -4,6 +4,7 @@
 #include "ImGuiConsole.hh"
 #include "ImGuiCpp.hh"
 #include "ImGuiDiskManipulator.hh"
+#include "ImGuiHostProfiler.hh"
 #include "ImGuiKeyboard.hh"
 #include "ImGuiManager.hh"
 #include "ImGuiMessages.hh"
@@ -145,6 +146,9 @@ void ImGuiTools::showMenu(MSXMotherBoard* motherBoard)
 		ImGui::MenuItem("Audio channel viewer", nullptr, &manager.waveViewer->show);
 		ImGui::Separator();
 
+		ImGui::MenuItem("Host profiler", nullptr, &manager.hostProfiler->show);
+		ImGui::Separator();
+
 		im::Menu("Toys", [&]{
 			const auto& toys = getAllToyScripts(manager);
 			for (const auto& toy : toys) {
@@ -0,0 +1,78 @@
+#ifndef DIRTYPAGES_HH
+#define DIRTYPAGES_HH
+
+#include "CacheLine.hh"
+
+#include "xrange.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace openmsx {
+
+/** Keeps track of which pages of a memory block were written since the last
+  * call to clear(). The page size matches CacheLine::SIZE.
+  *
+  * This is used to speed up taking reverse snapshots: regions of memory that
+  * didn't change since the previous snapshot don't need to be compared
+  * against that previous snapshot (see MemOutputArchive::serialize_blob()).
+  * Initially (and after markAllDirty()) all pages are dirty.
+  */
+class DirtyPages
+{
+public:
+	static constexpr unsigned PAGE_BITS = CacheLine::BITS;
+	static constexpr size_t PAGE_SIZE = CacheLine::SIZE;
+
+	explicit DirtyPages(size_t memSize)
+		: numPages((memSize + PAGE_SIZE - 1) >> PAGE_BITS)
+		, words((numPages + 63) / 64)
+	{
+		markAllDirty();
+	}
+
+	void markDirty(size_t addr) {
+		auto page = addr >> PAGE_BITS;
+		assert(page < numPages);
+		words[page / 64] |= uint64_t(1) << (page % 64);
+	}
+
+	void markDirty(size_t addr, size_t size) {
+		if (size == 0) return;
+		auto last = (addr + size - 1) >> PAGE_BITS;
+		for (auto page : xrange(addr >> PAGE_BITS, last + 1)) {
+			assert(page < numPages);
+			words[page / 64] |= uint64_t(1) << (page % 64);
+		}
+	}
+
+	void markAllDirty() {
+		std::ranges::fill(words, ~uint64_t(0));
+	}
+
+	void clear() {
+		std::ranges::fill(words, 0);
+	}
+
+	/** Is any page that overlaps with the range [addr, addr + size) dirty? */
+	[[nodiscard]] bool isDirty(size_t addr, size_t size) const {
+		if (size == 0) return false;
+		auto first = addr >> PAGE_BITS;
+		auto last = std::min((addr + size - 1) >> PAGE_BITS, numPages - 1);
+		for (auto page : xrange(first, last + 1)) {
+			if (words[page / 64] & (uint64_t(1) << (page % 64))) return true;
+		}
+		return false;
+	}
+
+private:
+	size_t numPages;
+	std::vector<uint64_t> words;
+};
+
+} // namespace openmsx
+
+#endif
@@ -10,9 +10,11 @@ void TrackedRam::serialize(Archive& ar, unsigned /*version*/)
 	// Note: This is the exact same serialization format as the Ram class.
 	//  This allows to change from Ram to TrackedRam without having to
 	//  increase the class serialization version (of the user).
-	bool diff = writeSinceLastReverseSnapshot || !ar.isReverseSnapshot();
-	ar.serialize_blob("ram", std::span{ram}, diff);
-	if (ar.isReverseSnapshot()) writeSinceLastReverseSnapshot = false;
+	if (debugWriteSinceLastReverseSnapshot) {
+		dirtyPages.markAllDirty();
+		debugWriteSinceLastReverseSnapshot = false;
+	}
+	ar.serialize_blob("ram", std::span{ram}, dirtyPages);
 }
 INSTANTIATE_SERIALIZE_METHODS(TrackedRam);
 
@@ -1,6 +1,7 @@
 #ifndef TRACKED_RAM_HH
 #define TRACKED_RAM_HH
 
+#include "DirtyPages.hh"
 #include "Ram.hh"
 
 #include <cstdint>
@@ -14,10 +15,12 @@ public:
 	// Most methods simply delegate to the internal 'ram' object.
 	TrackedRam(const DeviceConfig& config, const std::string& name,
 	           static_string_view description, size_t size)
-		: ram(config, name, description, size, &writeSinceLastReverseSnapshot) {}
+		: ram(config, name, description, size, &debugWriteSinceLastReverseSnapshot)
+		, dirtyPages(size) {}
 
 	TrackedRam(const XMLElement& xml, size_t size)
-		: ram(xml, size) {}
+		: ram(xml, size)
+		, dirtyPages(size) {}
 
 	[[nodiscard]] size_t size() const {
 		return ram.size();
@@ -41,12 +44,12 @@ public:
 
 	// Only allow write/clear via an explicit method.
 	void write(size_t addr, uint8_t value) {
-		writeSinceLastReverseSnapshot = true;
+		dirtyPages.markDirty(addr);
 		ram[addr] = value;
 	}
 
 	void clear(uint8_t c = 0xff) {
-		writeSinceLastReverseSnapshot = true;
+		dirtyPages.markAllDirty();
 		ram.clear(c);
 	}
 
@@ -55,7 +58,7 @@ public:
 	// invocation, so the resulting pointer (although the same each time)
 	// should not be reused for multiple (distinct) bulk write operations.
 	[[nodiscard]] std::span<uint8_t> getWriteBackdoor() {
-		writeSinceLastReverseSnapshot = true;
+		dirtyPages.markAllDirty();
 		return {ram.data(), size()};
 	}
 
@@ -64,7 +67,9 @@ public:
 
 private:
 	Ram ram;
-	bool writeSinceLastReverseSnapshot = true;
+	DirtyPages dirtyPages;
+	// Writes via the debuggable don't tell which page they touched.
+	bool debugWriteSinceLastReverseSnapshot = false;
 };
 
 } // namespace openmsx
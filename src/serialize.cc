@@ -8,6 +8,7 @@
 #include "Base64.hh"
 #include "Date.hh"
 #include "DeltaBlock.hh"
+#include "DirtyPages.hh"
 #include "HexDump.hh"
 #include "MemBuffer.hh"
 #include "narrow.hh"
@@ -17,6 +18,7 @@
 #include "build-info.hh"
 
 #include "cstdiop.hh" // for dup()
+#include <algorithm>
 #include <bit>
 #include <cstdint>
 #include <cstring>
@@ -162,6 +164,22 @@ void MemOutputArchive::serialize_blob(const char* /*tag*/, std::span<const uint8
 	}
 }
 
+// Blobs with dirty-page tracking are split in segments of this size. Each
+// segment gets its own DeltaBlock, so that for clean segments no delta has to
+// be calculated at all. Smaller segments skip more, but each DeltaBlock has
+// some overhead.
+static constexpr size_t DIRTY_SEGMENT_SIZE = 16 * DirtyPages::PAGE_SIZE;
+void MemOutputArchive::serialize_blob(const char* tag, std::span<const uint8_t> data,
+                                      DirtyPages& dirty)
+{
+	for (size_t pos = 0; pos < data.size(); pos += DIRTY_SEGMENT_SIZE) {
+		auto segment = data.subspan(pos, std::min(DIRTY_SEGMENT_SIZE, data.size() - pos));
+		bool diff = !reverseSnapshot || dirty.isDirty(pos, segment.size());
+		serialize_blob(tag, segment, diff);
+	}
+	if (reverseSnapshot) dirty.clear();
+}
+
 void MemInputArchive::serialize_blob(const char* /*tag*/, std::span<uint8_t> data,
                                      bool /*diff*/)
 {
@@ -182,6 +200,15 @@ void MemInputArchive::serialize_blob(const char* /*tag*/, std::span<uint8_t> dat
 	}
 }
 
+void MemInputArchive::serialize_blob(const char* tag, std::span<uint8_t> data,
+                                     DirtyPages& dirty)
+{
+	for (size_t pos = 0; pos < data.size(); pos += DIRTY_SEGMENT_SIZE) {
+		serialize_blob(tag, data.subspan(pos, std::min(DIRTY_SEGMENT_SIZE, data.size() - pos)));
+	}
+	dirty.markAllDirty();
+}
+
 ////
 
 XmlOutputArchive::XmlOutputArchive(zstring_view filename_)
@@ -558,4 +585,11 @@ void XmlInputArchive::serialize_blob(
 	}
 }
 
+void XmlInputArchive::serialize_blob(
+	const char* tag, std::span<uint8_t> data, DirtyPages& dirty)
+{
+	serialize_blob(tag, data);
+	dirty.markAllDirty();
+}
+
 } // namespace openmsx
@@ -31,6 +31,7 @@ namespace openmsx {
 
 class LastDeltaBlocks;
 class DeltaBlock;
+class DirtyPages;
 
 // TODO move somewhere in utils once we use this more often
 struct HashPair {
@@ -151,6 +152,15 @@ public:
 	//   cannot know whether a byte-array should be serialized as a blob
 	//   or as a collection of bytes (IOW we cannot decide it based on the
 	//   type).
+	//
+	//
+	// void serialize_blob(const char* tag, std::span<uint8_t> data, DirtyPages& dirty)
+	//
+	//   Like above, but for memory blocks that keep track of which pages
+	//   were written (see DirtyPages.hh). For reverse snapshots only the
+	//   dirty regions are compared against the previous snapshot, and
+	//   afterwards all pages are marked clean again. Loading marks all
+	//   pages dirty. The XML format is the same as for a plain blob.
 
 	template<typename T>
 	void serialize_blob(const char* tag, std::span<T> data, bool diff = true)
@@ -679,6 +689,8 @@ public:
 	void save(std::string_view s);
 	void serialize_blob(const char* tag, std::span<const uint8_t> data,
 	                    bool diff = true);
+	void serialize_blob(const char* tag, std::span<const uint8_t> data,
+	                    DirtyPages& dirty);
 
 	using OutputArchiveBase<MemOutputArchive>::serialize;
 	template<typename T, typename ...Args>
@@ -787,6 +799,8 @@ public:
 	[[nodiscard]] std::string_view loadStr();
 	void serialize_blob(const char* tag, std::span<uint8_t> data,
 	                    bool diff = true);
+	void serialize_blob(const char* tag, std::span<uint8_t> data,
+	                    DirtyPages& dirty);
 
 	using InputArchiveBase<MemInputArchive>::serialize;
 	template<typename T, typename ...Args>
@@ -882,6 +896,11 @@ public:
 
 	void serialize_blob(const char* tag, std::span<const uint8_t> data,
 	                    bool diff = true);
+	void serialize_blob(const char* tag, std::span<const uint8_t> data,
+	                    DirtyPages& /*dirty*/)
+	{
+		serialize_blob(tag, data);
+	}
 
 	auto& getXMLOutputStream() { return writer; }
 
@@ -951,6 +970,8 @@ public:
 
 	void serialize_blob(const char* tag, std::span<uint8_t> data,
 	                    bool diff = true);
+	void serialize_blob(const char* tag, std::span<uint8_t> data,
+	                    DirtyPages& dirty);
 
 	void skipSection(bool /*skip*/) const { /*nothing*/ }
 
@@ -14,6 +14,8 @@
 #include "DeviceConfig.hh"
 #include "GlobalSettings.hh"
 #include "MSXException.hh"
+#include "MSXMotherBoard.hh"
+#include "VGMRecorder.hh"
 
 #include "Math.hh"
 #include "StringOp.hh"
@@ -481,6 +483,7 @@ AY8910::AY8910(const std::string& name_, AY8910Periphery& periphery_,
                const DeviceConfig& config, EmuTime time)
 	: ResampledSoundDevice(config.getMotherBoard(), name_, "PSG", 3, NATIVE_FREQ_INT, false)
 	, periphery(periphery_)
+	, vgmRecorder(config.getMotherBoard().getVGMRecorder())
 	, debuggable(config.getMotherBoard(), getName())
 	, vibratoPercent(
 		config.getCommandController(), tmpStrCat(getName(), "_vibrato_percent"),
@@ -582,6 +585,9 @@ uint8_t AY8910::peekRegister(unsigned reg, EmuTime time) const
 void AY8910::writeRegister(unsigned reg, uint8_t value, EmuTime time)
 {
 	if (reg >= 16) return;
+	if ((reg < AY_PORTA) && vgmRecorder.isRecording(VGMRecorder::Chip::AY8910)) [[unlikely]] {
+		vgmRecorder.write(VGMRecorder::Chip::AY8910, 0, uint8_t(reg), value, time);
+	}
 	if ((reg < AY_PORTA) && (reg == AY_ESHAPE || regs[reg] != value)) {
 		// Update the output buffer before changing the register.
 		updateStream(time);
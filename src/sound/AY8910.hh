@@ -14,6 +14,7 @@ namespace openmsx {
 
 class AY8910Periphery;
 class DeviceConfig;
+class VGMRecorder;
 
 /** This class implements the AY-3-8910 sound chip.
   * Only the AY-3-8910 is emulated, no surrounding hardware,
@@ -173,6 +174,7 @@ private:
 
 private:
 	AY8910Periphery& periphery;
+	VGMRecorder& vgmRecorder;
 
 	struct Debuggable final : SimpleDebuggable {
 		Debuggable(MSXMotherBoard& motherBoard, const std::string& name);
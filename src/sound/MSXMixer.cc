@@ -9,13 +9,17 @@
 #include "FileOperations.hh"
 #include "Filename.hh"
 #include "GlobalSettings.hh"
+#include "HostProfiler.hh"
 #include "IntegerSetting.hh"
 #include "MSXCliComm.hh"
 #include "MSXCommandController.hh"
 #include "MSXMotherBoard.hh"
+#include "MixKernels.hh"
 #include "StringSetting.hh"
 #include "TclObject.hh"
 #include "ThrottleManager.hh"
+#include "ThreadPool.hh"
+#include "Timer.hh"
 
 #include "Math.hh"
 #include "aligned.hh"
@@ -27,8 +31,11 @@
 #include "ranges.hh"
 #include "stl.hh"
 #include "unreachable.hh"
+#include "xrange.hh"
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
 #include <cmath>
 #include <memory>
@@ -155,10 +162,23 @@ void MSXMixer::updateStream(EmuTime time)
 {
 	unsigned count = prevTime.getTicksTill(time);
 	assert(count <= 8192);
+	if (seeking && !recorder) {
+		// skip sound generation, see setSeeking()
+		generateWhileSeeking(count, time);
+		prevTime += count;
+		return;
+	}
 	inplace_buffer<StereoFloat, 8192> mixBuffer(uninitialized_tag{}, count);
 
 	// call generate() even if count==0 and even if muted
-	generate(mixBuffer, time);
+	if (measureStats) [[unlikely]] {
+		auto start = Timer::getTime();
+		generate(mixBuffer, time);
+		stats.hostTime += Timer::getTime() - start;
+		stats.samples += count;
+	} else {
+		generate(mixBuffer, time);
+	}
 
 	if (!muteCount && fragmentSize) {
 		mixer.uploadBuffer(*this, mixBuffer);
@@ -178,95 +198,52 @@ void MSXMixer::updateStream(EmuTime time)
 // accumulation buffer is still empty (as-if it contains zeros), in that case
 // we skip the accumulation step.
 
+// The actual loops are in MixKernels, these wrappers only translate from
+// spans to raw pointers.
+
 // buf[0:n] *= f
-static inline void mul(float* buf, size_t n, float f)
-{
-	// C++ version, unrolled 4x,
-	//   this allows gcc/clang to do much better auto-vectorization
-	// Note that this can process upto 3 samples too many, but that's OK.
-	size_t i = 0;
-	do {
-		buf[i + 0] *= f;
-		buf[i + 1] *= f;
-		buf[i + 2] *= f;
-		buf[i + 3] *= f;
-		i += 4;
-	} while (i < n);
-}
+//  (can process upto 3 samples too many, but that's OK)
 static inline void mul(std::span<float> buf, float f)
 {
 	assert(!buf.empty());
-	mul(buf.data(), buf.size(), f);
+	MixKernels::get().mul(buf.data(), buf.size(), f);
 }
 static inline void mul(std::span<StereoFloat> buf, float f)
 {
 	assert(!buf.empty());
-	mul(&buf.data()->left, 2 * buf.size(), f);
+	MixKernels::get().mul(&buf.data()->left, 2 * buf.size(), f);
 }
 
 // acc[0:n] += mul[0:n] * f
-static inline void mulAcc(
-	float* __restrict acc, const float* __restrict mul, size_t n, float f)
-{
-	// C++ version, unrolled 4x, see comments above.
-	size_t i = 0;
-	do {
-		acc[i + 0] += mul[i + 0] * f;
-		acc[i + 1] += mul[i + 1] * f;
-		acc[i + 2] += mul[i + 2] * f;
-		acc[i + 3] += mul[i + 3] * f;
-		i += 4;
-	} while (i < n);
-}
 static inline void mulAcc(std::span<float> acc, std::span<const float> mul, float f)
 {
 	assert(!acc.empty());
 	assert(acc.size() == mul.size());
-	mulAcc(acc.data(), mul.data(), acc.size(), f);
+	MixKernels::get().mulAcc(acc.data(), mul.data(), acc.size(), f);
 }
 static inline void mulAcc(std::span<StereoFloat> acc, std::span<const StereoFloat> mul, float f)
 {
 	assert(!acc.empty());
 	assert(acc.size() == mul.size());
-	mulAcc(&acc.data()->left, &mul.data()->left, 2 * acc.size(), f);
+	MixKernels::get().mulAcc(&acc.data()->left, &mul.data()->left, 2 * acc.size(), f);
 }
 
 // buf[0:2n+0:2] = buf[0:n] * l
 // buf[1:2n+1:2] = buf[0:n] * r
-static inline void mulExpand(float* buf, size_t n, float l, float r)
-{
-	size_t i = n;
-	do {
-		--i; // back-to-front
-		auto t = buf[i];
-		buf[2 * i + 0] = l * t;
-		buf[2 * i + 1] = r * t;
-	} while (i != 0);
-}
 static inline void mulExpand(std::span<StereoFloat> buf, float l, float r)
 {
-	mulExpand(&buf.data()->left, buf.size(), l, r);
+	assert(!buf.empty());
+	MixKernels::get().mulExpand(&buf.data()->left, buf.size(), l, r);
 }
 
 // acc[0:2n+0:2] += mul[0:n] * l
 // acc[1:2n+1:2] += mul[0:n] * r
-static inline void mulExpandAcc(
-	float* __restrict acc, const float* __restrict mul, size_t n,
-	float l, float r)
-{
-	size_t i = 0;
-	do {
-		auto t = mul[i];
-		acc[2 * i + 0] += l * t;
-		acc[2 * i + 1] += r * t;
-	} while (++i < n);
-}
 static inline void mulExpandAcc(
 	std::span<StereoFloat> acc, std::span<const float> mul, float l, float r)
 {
 	assert(!acc.empty());
 	assert(acc.size() == mul.size());
-	mulExpandAcc(&acc.data()->left, mul.data(), acc.size(), l, r);
+	MixKernels::get().mulExpandAcc(&acc.data()->left, mul.data(), acc.size(), l, r);
 }
 
 // buf[0:2n+0:2] = buf[0:2n+0:2] * l1 + buf[1:2n+1:2] * l2
@@ -274,12 +251,7 @@ static inline void mulExpandAcc(
 static inline void mulMix2(std::span<StereoFloat> buf, float l1, float l2, float r1, float r2)
 {
 	assert(!buf.empty());
-	for (auto& s : buf) {
-		auto t1 = s.left;
-		auto t2 = s.right;
-		s.left  = l1 * t1 + l2 * t2;
-		s.right = r1 * t1 + r2 * t2;
-	}
+	MixKernels::get().mulMix2(&buf.data()->left, buf.size(), l1, l2, r1, r2);
 }
 
 // acc[0:2n+0:2] += mul[0:2n+0:2] * l1 + mul[1:2n+1:2] * l2
@@ -290,14 +262,7 @@ static inline void mulMix2Acc(
 {
 	assert(!acc.empty());
 	assert(acc.size() == mul.size());
-	auto n = acc.size();
-	size_t i = 0;
-	do {
-		auto t1 = mul[i].left;
-		auto t2 = mul[i].right;
-		acc[i].left  += l1 * t1 + l2 * t2;
-		acc[i].right += r1 * t1 + r2 * t2;
-	} while (++i < n);
+	MixKernels::get().mulMix2Acc(&acc.data()->left, &mul.data()->left, acc.size(), l1, l2, r1, r2);
 }
 
 
@@ -462,17 +427,25 @@ void MSXMixer::generate(std::span<StereoFloat> output, EmuTime time)
 	auto* tmpBufPtr    = &tmpBufExtra.data()->left; // can be used either for mono or stereo data
 	auto monoBuf      = subspan(monoBufExtra,   0, samples);
 	auto stereoBuf    = subspan(stereoBufExtra, 0, samples);
-	auto tmpBufStereo = subspan(tmpBufExtra,    0, samples); // StereoFloat
-	auto tmpBufMono   = std::span{tmpBufPtr, samples};      // float
 
 	constexpr unsigned HAS_MONO_FLAG = 1;
 	constexpr unsigned HAS_STEREO_FLAG = 2;
 	unsigned usedBuffers = 0;
 
-	// TODO: The Infos should be ordered such that all the mono
-	// devices are handled first
-	for (auto& info : infos) {
-		SoundDevice& device = *info.device;
+	// Mix the output of one device into 'monoBuf' or 'stereoBuf'.
+	// 'generate(buf)' produces the sound of the device: 'buf' is the
+	// preferred location for the result, but the data may also be
+	// returned elsewhere. It returns nullptr when the device is silent.
+	auto mixDevice = [&](const SoundDeviceInfo& info, auto generate) {
+		const SoundDevice& device = *info.device;
+		// generate in 'buf', if the result ended up elsewhere copy it
+		auto generateIn = [&](float* buf, size_t num) {
+			const float* result = generate(buf);
+			if (result && (result != buf)) {
+				std::copy_n(result, num, buf);
+			}
+			return result != nullptr;
+		};
 		auto l1 = info.left1;
 		auto r1 = info.right1;
 		if (!device.isStereo()) {
@@ -482,15 +455,15 @@ void MSXMixer::generate(std::span<StereoFloat> output, EmuTime time)
 				if (!(usedBuffers & HAS_MONO_FLAG)) {
 					// generate in 'monoBuf' (because it was still empty)
 					// then multiply in-place
-					if (device.updateBuffer(samples, monoBufPtr, time)) {
+					if (generateIn(monoBufPtr, samples)) {
 						usedBuffers |= HAS_MONO_FLAG;
 						mul(monoBuf, l1);
 					}
 				} else {
 					// generate in 'tmpBuf' (as mono data)
 					// then multiply-accumulate into 'monoBuf'
-					if (device.updateBuffer(samples, tmpBufPtr, time)) {
-						mulAcc(monoBuf, tmpBufMono, l1);
+					if (const auto* data = generate(tmpBufPtr)) {
+						mulAcc(monoBuf, std::span{data, samples}, l1);
 					}
 				}
 			} else {
@@ -498,20 +471,23 @@ void MSXMixer::generate(std::span<StereoFloat> output, EmuTime time)
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
 					// 'stereoBuf' (which is still empty) is first filled with mono-data,
 					// then in-place expanded to stereo-data
-					if (device.updateBuffer(samples, stereoBufPtr, time)) {
+					if (generateIn(stereoBufPtr, samples)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mulExpand(stereoBuf, l1, r1);
 					}
 				} else {
 					// 'tmpBuf' is first filled with mono-data,
 					// then expanded to stereo and mul-acc into 'stereoBuf'
-					if (device.updateBuffer(samples, tmpBufPtr, time)) {
-						mulExpandAcc(stereoBuf, tmpBufMono, l1, r1);
+					if (const auto* data = generate(tmpBufPtr)) {
+						mulExpandAcc(stereoBuf, std::span{data, samples}, l1, r1);
 					}
 				}
 			}
 		} else {
 			// device generates stereo output
+			auto asStereo = [&](const float* data) {
+				return std::span{std::bit_cast<const StereoFloat*>(data), samples};
+			};
 			auto l2 = info.left2;
 			auto r2 = info.right2;
 			if (l1 == r2) {
@@ -521,15 +497,15 @@ void MSXMixer::generate(std::span<StereoFloat> output, EmuTime time)
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
 					// generate in 'stereoBuf' (because it was still empty)
 					// then multiply in-place
-					if (device.updateBuffer(samples, stereoBufPtr, time)) {
+					if (generateIn(stereoBufPtr, 2 * samples)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mul(stereoBuf, l1);
 					}
 				} else {
 					// generate in 'tmpBuf' (as stereo data)
 					// then multiply-accumulate into 'stereoBuf'
-					if (device.updateBuffer(samples, tmpBufPtr, time)) {
-						mulAcc(stereoBuf, tmpBufStereo, l1);
+					if (const auto* data = generate(tmpBufPtr)) {
+						mulAcc(stereoBuf, asStereo(data), l1);
 					}
 				}
 			} else {
@@ -538,19 +514,63 @@ void MSXMixer::generate(std::span<StereoFloat> output, EmuTime time)
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
 					// generate in 'stereoBuf' (because it was still empty)
 					// then mix in-place
-					if (device.updateBuffer(samples, stereoBufPtr, time)) {
+					if (generateIn(stereoBufPtr, 2 * samples)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mulMix2(stereoBuf, l1, l2, r1, r2);
 					}
 				} else {
 					// 'tmpBuf' is first filled with stereo-data,
 					// then mixed into stereoBuf
-					if (device.updateBuffer(samples, tmpBufPtr, time)) {
-						mulMix2Acc(stereoBuf, tmpBufStereo, l1, l2, r1, r2);
+					if (const auto* data = generate(tmpBufPtr)) {
+						mulMix2Acc(stereoBuf, asStereo(data), l1, l2, r1, r2);
 					}
 				}
 			}
 		}
+	};
+
+	// TODO: The Infos should be ordered such that all the mono
+	// devices are handled first
+	if (auto* workers = mixer.getAudioWorkers(); workers && (infos.size() > 1)) {
+		// Let all devices generate in parallel, each in its own buffer.
+		// Devices only touch their own state while generating sound, and
+		// the emulation is halted until all of them are done. Afterwards
+		// the results are mixed in the same order and with the same
+		// operations as below, so the output is bit-identical.
+		// (The HostProfiler is not thread-safe, so no per-device
+		// profiling on this path.)
+		auto stride = (2 * (samples + 3) + 3) & ~size_t(3); // keep SSE alignment
+		deviceBuffers.resize(infos.size() * stride);
+		deviceActive.resize(infos.size());
+		auto generateDevice = [&](size_t i) {
+			Math::DenormalGuard guard; // this is per thread
+			deviceActive[i] = infos[i].device->updateBuffer(
+				samples, &deviceBuffers[i * stride], time);
+		};
+		deviceTasks.clear();
+		for (auto i : xrange(size_t(1), infos.size())) {
+			deviceTasks.push_back(workers->enqueue([&, i] { generateDevice(i); }));
+		}
+		generateDevice(0); // the main thread takes part as well
+		for (auto& task : deviceTasks) task.get();
+
+		for (auto [i, info] : enumerate(infos)) {
+			const float* data = deviceActive[i] ? &deviceBuffers[i * stride] : nullptr;
+			mixDevice(info, [&](float* /*buf*/) { return data; });
+		}
+	} else {
+		for (auto& info : infos) {
+			SoundDevice& device = *info.device;
+			HostProfiler::profile(HostProfiler::Category::SOUND, &device,
+				[](const void* d) {
+					return std::string(static_cast<const SoundDevice*>(d)->getName());
+				},
+				[&] {
+					mixDevice(info, [&](float* buf) {
+						return device.updateBuffer(samples, buf, time) ? buf : nullptr;
+					});
+				});
+		}
 	}
 
 	// DC removal filter
@@ -617,6 +637,35 @@ void MSXMixer::unmute()
 	}
 }
 
+void MSXMixer::setSeeking(bool newSeeking)
+{
+	if (seeking == newSeeking) return;
+	seeking = newSeeking;
+	if (!seeking) {
+		// The (other) sound devices didn't generate anything while
+		// seeking, restart them at the current time.
+		reInit();
+		for (auto& info : infos) {
+			if (!info.device->needsGenerateWhileSeeking()) {
+				info.device->setOutputRate(hostSampleRate, speedManager.getSpeed());
+			}
+		}
+	}
+}
+
+void MSXMixer::generateWhileSeeking(unsigned samples, EmuTime time)
+{
+	// Only the devices whose emulation depends on it, the output is
+	// discarded. Room for stereo output, plus upto 3 extra samples.
+	inplace_buffer<float, 2 * (8192 + 3)> buf(uninitialized_tag{}, 2 * (samples + 3));
+	for (auto& info : infos) {
+		if (info.device->needsGenerateWhileSeeking()) {
+			bool ignore = info.device->updateBuffer(samples, buf.data(), time);
+			(void)ignore;
+		}
+	}
+}
+
 void MSXMixer::reInit()
 {
 	prevTime.reset(getCurrentTime());
@@ -829,12 +878,22 @@ void MSXMixer::SoundDeviceInfoTopic::execute(
 			msxMixer.infos,
 			[](const auto& info) { return info.device->getName(); }));
 		break;
-	case 3: {
+	case 3:
+	case 4: {
 		const auto* device = msxMixer.findDevice(tokens[2].getString());
 		if (!device) {
 			throw CommandException("Unknown sound device");
 		}
-		result = device->getDescription();
+		if (tokens.size() == 3) {
+			result = device->getDescription();
+		} else if (tokens[3] == "silence_stats") {
+			const auto& stats = device->getSilenceStats();
+			result.addDictKeyValues("fragments", stats.generated,
+			                        "skipped", stats.skipped,
+			                        "resample_skipped", stats.resampleSkipped);
+		} else {
+			throw CommandException("Unknown subcommand, must be 'silence_stats'");
+		}
 		break;
 	}
 	default:
@@ -844,7 +903,11 @@ void MSXMixer::SoundDeviceInfoTopic::execute(
 
 std::string MSXMixer::SoundDeviceInfoTopic::help(std::span<const TclObject> /*tokens*/) const
 {
-	return "Shows a list of available sound devices.\n";
+	return "Shows a list of available sound devices.\n"
+	       "  machine_info sounddevice                        list of sound devices\n"
+	       "  machine_info sounddevice <name>                 description of the device\n"
+	       "  machine_info sounddevice <name> silence_stats   how often (in number of\n"
+	       "      sound fragments) synthesis and resampling of a silent device was skipped\n";
 }
 
 void MSXMixer::SoundDeviceInfoTopic::tabCompletion(std::vector<std::string>& tokens) const
@@ -853,6 +916,10 @@ void MSXMixer::SoundDeviceInfoTopic::tabCompletion(std::vector<std::string>& tok
 		completeString(tokens, std::views::transform(
 			OUTER(MSXMixer, soundDeviceInfo).infos,
 			[](auto& info) -> std::string_view { return info.device->getName(); }));
+	} else if (tokens.size() == 4) {
+		using namespace std::literals;
+		static constexpr std::array options = {"silence_stats"sv};
+		completeString(tokens, options);
 	}
 }
 
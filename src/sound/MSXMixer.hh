@@ -7,9 +7,13 @@
 #include "Mixer.hh"
 #include "Schedulable.hh"
 
+#include "MemBuffer.hh"
 #include "Observer.hh"
+#include "aligned.hh"
 #include "dynarray.hh"
 
+#include <cstdint>
+#include <future>
 #include <memory>
 #include <span>
 #include <vector>
@@ -111,6 +115,26 @@ public:
 	void mute();
 	void unmute();
 
+	/** While seeking (e.g. the fast-forward part of 'reverse goto') no
+	 * sound is generated, not even for muted output. Except for the
+	 * devices whose emulation depends on generating their sound (see
+	 * SoundDevice::needsGenerateWhileSeeking()), they keep generating
+	 * but their output is discarded. When seeking ends, the other sound
+	 * devices restart generating from the current time.
+	 */
+	void setSeeking(bool newSeeking);
+	[[nodiscard]] bool isSeeking() const { return seeking; }
+
+	/** Statistics, used to report emulation speed (see 'benchmark').
+	 * Only updated while enabled via setMeasureStats().
+	 */
+	struct Stats {
+		uint64_t samples = 0;  // number of generated (host) samples
+		uint64_t hostTime = 0; // us spent generating those samples
+	};
+	[[nodiscard]] const Stats& getStats() const { return stats; }
+	void setMeasureStats(bool enable) { measureStats = enable; }
+
 	// Called by Mixer or SoundDriver
 
 	/** Set new fragment size and sample frequency.
@@ -148,6 +172,7 @@ private:
 	void reschedule();
 	void reschedule2();
 	void generate(std::span<StereoFloat> output, EmuTime time);
+	void generateWhileSeeking(unsigned samples, EmuTime time);
 
 	// Schedulable
 	void executeUntil(EmuTime time) override;
@@ -190,7 +215,16 @@ private:
 	AviRecorder* recorder = nullptr;
 	unsigned synchronousCounter = 0;
 
+	// Only used when generating the sound devices in parallel (see
+	// Mixer::getAudioWorkers()), kept here to avoid reallocations.
+	MemBuffer<float, SSE_ALIGNMENT> deviceBuffers;
+	std::vector<uint8_t> deviceActive; // not vector<bool>, written by multiple threads
+	std::vector<std::future<void>> deviceTasks;
+
+	Stats stats;
 	unsigned muteCount = 1; // start muted
+	bool seeking = false;
+	bool measureStats = false;
 	float tl0, tr0; // internal DC-filter state
 };
 
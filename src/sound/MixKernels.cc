@@ -0,0 +1,472 @@
+#include "MixKernels.hh"
+
+#include "unreachable.hh"
+#include "xrange.hh"
+
+#include <cassert>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define MIX_KERNELS_AVX2
+#endif
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define MIX_KERNELS_NEON
+#endif
+
+namespace openmsx::MixKernels {
+
+// --- Portable C++ versions ---
+//
+// These are the reference for the other implementations. Several loops are
+// unrolled 4x, this allows gcc/clang to do much better auto-vectorization.
+
+struct Scalar
+{
+	static void mul(float* buf, size_t n, float f)
+	{
+		size_t i = 0;
+		do {
+			buf[i + 0] *= f;
+			buf[i + 1] *= f;
+			buf[i + 2] *= f;
+			buf[i + 3] *= f;
+			i += 4;
+		} while (i < n);
+	}
+
+	static void mulAcc(float* __restrict acc, const float* __restrict in, size_t n, float f)
+	{
+		size_t i = 0;
+		do {
+			acc[i + 0] += in[i + 0] * f;
+			acc[i + 1] += in[i + 1] * f;
+			acc[i + 2] += in[i + 2] * f;
+			acc[i + 3] += in[i + 3] * f;
+			i += 4;
+		} while (i < n);
+	}
+
+	static void mulExpand(float* buf, size_t n, float l, float r)
+	{
+		size_t i = n;
+		do {
+			--i; // back-to-front
+			auto t = buf[i];
+			buf[2 * i + 0] = l * t;
+			buf[2 * i + 1] = r * t;
+		} while (i != 0);
+	}
+
+	static void mulExpandAcc(float* __restrict acc, const float* __restrict in, size_t n, float l, float r)
+	{
+		size_t i = 0;
+		do {
+			auto t = in[i];
+			acc[2 * i + 0] += l * t;
+			acc[2 * i + 1] += r * t;
+		} while (++i < n);
+	}
+
+	static void mulMix2(float* buf, size_t n, float l1, float l2, float r1, float r2)
+	{
+		for (size_t i = 0; i < n; ++i) {
+			auto t1 = buf[2 * i + 0];
+			auto t2 = buf[2 * i + 1];
+			buf[2 * i + 0] = l1 * t1 + l2 * t2;
+			buf[2 * i + 1] = r1 * t1 + r2 * t2;
+		}
+	}
+
+	static void mulMix2Acc(float* __restrict acc, const float* __restrict in, size_t n,
+	                       float l1, float l2, float r1, float r2)
+	{
+		for (size_t i = 0; i < n; ++i) {
+			auto t1 = in[2 * i + 0];
+			auto t2 = in[2 * i + 1];
+			acc[2 * i + 0] += l1 * t1 + l2 * t2;
+			acc[2 * i + 1] += r1 * t1 + r2 * t2;
+		}
+	}
+
+	static void sumChannels(float* out, const float* const* bufs, size_t num, size_t n)
+	{
+		sumChannelsFrom(0, out, bufs, num, n);
+	}
+	static void sumChannelsFrom(size_t i, float* out, const float* const* bufs, size_t num, size_t n)
+	{
+		assert(num >= 1);
+		do {
+			auto out0 = out[i + 0];
+			auto out1 = out[i + 1];
+			auto out2 = out[i + 2];
+			auto out3 = out[i + 3];
+			size_t j = 0;
+			do {
+				out0 += bufs[j][i + 0];
+				out1 += bufs[j][i + 1];
+				out2 += bufs[j][i + 2];
+				out3 += bufs[j][i + 3];
+				++j;
+			} while (j < num);
+			out[i + 0] = out0;
+			out[i + 1] = out1;
+			out[i + 2] = out2;
+			out[i + 3] = out3;
+			i += 4;
+		} while (i < n);
+	}
+
+	static void mixBalance(float* out, const float* const* bufs, const float* balance,
+	                       size_t num, size_t n)
+	{
+		mixBalanceFrom(0, out, bufs, balance, num, n);
+	}
+	static void mixBalanceFrom(size_t i, float* out, const float* const* bufs, const float* balance,
+	                           size_t num, size_t n)
+	{
+		assert(num >= 1);
+		do {
+			float left0  = 0.0f;
+			float right0 = 0.0f;
+			float left1  = 0.0f;
+			float right1 = 0.0f;
+			size_t j = 0;
+			do {
+				left0  += bufs[j][i + 0] * balance[2 * j + 0];
+				left1  += bufs[j][i + 1] * balance[2 * j + 0];
+				right0 += bufs[j][i + 0] * balance[2 * j + 1];
+				right1 += bufs[j][i + 1] * balance[2 * j + 1];
+				++j;
+			} while (j < num);
+			out[2 * i + 0] = left0;
+			out[2 * i + 1] = right0;
+			out[2 * i + 2] = left1;
+			out[2 * i + 3] = right1;
+			i += 2;
+		} while (i < n);
+	}
+};
+
+
+// --- 4-wide SIMD versions ---
+//
+// Written once on top of a small set of vector operations, instantiated for
+// SSE2 and NEON. Only vertical multiplications and additions are used, in the
+// same order as in the scalar code (only the operands of some commutative
+// operations are swapped), so the results are identical.
+
+template<typename Vec> struct Simd4
+{
+	using V = typename Vec::V;
+
+	static void mul(float* buf, size_t n, float f)
+	{
+		V vf = Vec::splat(f);
+		size_t i = 0;
+		do {
+			Vec::store(buf + i, Vec::mul(Vec::load(buf + i), vf));
+			i += 4;
+		} while (i < n);
+	}
+
+	static void mulAcc(float* __restrict acc, const float* __restrict in, size_t n, float f)
+	{
+		V vf = Vec::splat(f);
+		size_t i = 0;
+		do {
+			V a = Vec::load(acc + i);
+			V m = Vec::load(in + i);
+			Vec::store(acc + i, Vec::add(a, Vec::mul(m, vf)));
+			i += 4;
+		} while (i < n);
+	}
+
+	static void mulExpand(float* buf, size_t n, float l, float r)
+	{
+		// In-place, so work back-to-front. First the last (n % 4)
+		// samples, then groups of 4: those are loaded before the
+		// (overlapping) result is stored.
+		V lr = Vec::pair(l, r);
+		size_t n4 = n & ~size_t(3);
+		for (size_t i = n; i != n4; /**/) {
+			--i;
+			auto t = buf[i];
+			buf[2 * i + 0] = l * t;
+			buf[2 * i + 1] = r * t;
+		}
+		for (size_t i = n4; i != 0; /**/) {
+			i -= 4;
+			V m = Vec::load(buf + i);
+			V lo = Vec::mul(Vec::dupLo(m), lr);
+			V hi = Vec::mul(Vec::dupHi(m), lr);
+			Vec::store(buf + 2 * i + 0, lo);
+			Vec::store(buf + 2 * i + 4, hi);
+		}
+	}
+
+	static void mulExpandAcc(float* __restrict acc, const float* __restrict in, size_t n, float l, float r)
+	{
+		V lr = Vec::pair(l, r);
+		size_t i = 0;
+		for (/**/; (i + 4) <= n; i += 4) {
+			V m = Vec::load(in + i);
+			V lo = Vec::add(Vec::load(acc + 2 * i + 0), Vec::mul(Vec::dupLo(m), lr));
+			V hi = Vec::add(Vec::load(acc + 2 * i + 4), Vec::mul(Vec::dupHi(m), lr));
+			Vec::store(acc + 2 * i + 0, lo);
+			Vec::store(acc + 2 * i + 4, hi);
+		}
+		for (/**/; i < n; ++i) {
+			auto t = in[i];
+			acc[2 * i + 0] += l * t;
+			acc[2 * i + 1] += r * t;
+		}
+	}
+
+	// Two stereo samples per vector: (L0, R0, L1, R1) * (l1, r2, l1, r2)
+	//                              + (R0, L0, R1, L1) * (l2, r1, l2, r1)
+	static void mulMix2(float* buf, size_t n, float l1, float l2, float r1, float r2)
+	{
+		V c1 = Vec::pair(l1, r2);
+		V c2 = Vec::pair(l2, r1);
+		size_t i = 0;
+		for (/**/; (i + 2) <= n; i += 2) {
+			V v = Vec::load(buf + 2 * i);
+			V s = Vec::swapPairs(v);
+			Vec::store(buf + 2 * i, Vec::add(Vec::mul(v, c1), Vec::mul(s, c2)));
+		}
+		if (i < n) Scalar::mulMix2(buf + 2 * i, n - i, l1, l2, r1, r2);
+	}
+
+	static void mulMix2Acc(float* __restrict acc, const float* __restrict in, size_t n,
+	                       float l1, float l2, float r1, float r2)
+	{
+		V c1 = Vec::pair(l1, r2);
+		V c2 = Vec::pair(l2, r1);
+		size_t i = 0;
+		for (/**/; (i + 2) <= n; i += 2) {
+			V v = Vec::load(in + 2 * i);
+			V s = Vec::swapPairs(v);
+			V a = Vec::load(acc + 2 * i);
+			Vec::store(acc + 2 * i, Vec::add(a, Vec::add(Vec::mul(v, c1), Vec::mul(s, c2))));
+		}
+		if (i < n) Scalar::mulMix2Acc(acc + 2 * i, in + 2 * i, n - i, l1, l2, r1, r2);
+	}
+
+	// Channel by channel (instead of sample by sample like the scalar
+	// version), this streams through the buffers. Each output element
+	// still gets the channels added in the same order.
+	static void sumChannels(float* out, const float* const* bufs, size_t num, size_t n)
+	{
+		sumChannelsFrom(0, out, bufs, num, n);
+	}
+	static void sumChannelsFrom(size_t start, float* out, const float* const* bufs, size_t num, size_t n)
+	{
+		assert(num >= 1);
+		for (auto j : xrange(num)) {
+			const float* b = bufs[j];
+			size_t i = start;
+			do {
+				Vec::store(out + i, Vec::add(Vec::load(out + i), Vec::load(b + i)));
+				i += 4;
+			} while (i < n);
+		}
+	}
+
+	// Groups of 4 (mono) input samples, channel by channel. The remaining
+	// samples are processed in pairs (like the scalar version), so that
+	// the input buffers are never read past the (rounded up) end.
+	static void mixBalance(float* out, const float* const* bufs, const float* balance,
+	                       size_t num, size_t n)
+	{
+		assert(num >= 1);
+		size_t n4 = n & ~size_t(3);
+		V zero = Vec::splat(0.0f);
+		for (auto j : xrange(num)) {
+			const float* b = bufs[j];
+			V lr = Vec::pair(balance[2 * j + 0], balance[2 * j + 1]);
+			for (size_t i = 0; i < n4; i += 4) {
+				V m = Vec::load(b + i);
+				// (for j == 0 this adds to zero, like the scalar version)
+				V lo = (j == 0) ? zero : Vec::load(out + 2 * i + 0);
+				V hi = (j == 0) ? zero : Vec::load(out + 2 * i + 4);
+				Vec::store(out + 2 * i + 0, Vec::add(lo, Vec::mul(Vec::dupLo(m), lr)));
+				Vec::store(out + 2 * i + 4, Vec::add(hi, Vec::mul(Vec::dupHi(m), lr)));
+			}
+		}
+		if (n4 < n) Scalar::mixBalanceFrom(n4, out, bufs, balance, num, n);
+	}
+};
+
+#ifdef __SSE2__
+struct VecSSE2
+{
+	using V = __m128;
+	static V load(const float* p) { return _mm_loadu_ps(p); }
+	static void store(float* p, V v) { _mm_storeu_ps(p, v); }
+	static V splat(float f) { return _mm_set1_ps(f); }
+	static V pair(float a, float b) { return _mm_setr_ps(a, b, a, b); }
+	static V add(V a, V b) { return _mm_add_ps(a, b); }
+	static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+	static V dupLo(V a) { return _mm_unpacklo_ps(a, a); } // a0 a0 a1 a1
+	static V dupHi(V a) { return _mm_unpackhi_ps(a, a); } // a2 a2 a3 a3
+	static V swapPairs(V a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)); } // a1 a0 a3 a2
+};
+using SSE2 = Simd4<VecSSE2>;
+#endif
+
+#ifdef MIX_KERNELS_NEON
+struct VecNEON
+{
+	using V = float32x4_t;
+	static V load(const float* p) { return vld1q_f32(p); }
+	static void store(float* p, V v) { vst1q_f32(p, v); }
+	static V splat(float f) { return vdupq_n_f32(f); }
+	static V pair(float a, float b) {
+		float32x2_t ab = vset_lane_f32(b, vdup_n_f32(a), 1);
+		return vcombine_f32(ab, ab);
+	}
+	static V add(V a, V b) { return vaddq_f32(a, b); }
+	static V mul(V a, V b) { return vmulq_f32(a, b); }
+	static V dupLo(V a) { return vzip1q_f32(a, a); }
+	static V dupHi(V a) { return vzip2q_f32(a, a); }
+	static V swapPairs(V a) { return vrev64q_f32(a); }
+};
+using NEON = Simd4<VecNEON>;
+#endif
+
+// Not all x86_64 CPUs have AVX2, so these functions are compiled for that
+// instruction set separately, and only called after a run-time check. Only
+// the simple element-wise loops benefit from the wider vectors, the other
+// routines use the SSE2 versions.
+#ifdef MIX_KERNELS_AVX2
+struct AVX2
+{
+	[[gnu::target("avx2")]] static void mul(float* buf, size_t n, float f)
+	{
+		__m256 vf = _mm256_set1_ps(f);
+		size_t i = 0;
+		for (/**/; (i + 8) <= n; i += 8) {
+			_mm256_storeu_ps(buf + i, _mm256_mul_ps(_mm256_loadu_ps(buf + i), vf));
+		}
+		if (i < n) SSE2::mul(buf + i, n - i, f);
+	}
+
+	[[gnu::target("avx2")]] static void mulAcc(float* __restrict acc, const float* __restrict in, size_t n, float f)
+	{
+		__m256 vf = _mm256_set1_ps(f);
+		size_t i = 0;
+		for (/**/; (i + 8) <= n; i += 8) {
+			__m256 a = _mm256_loadu_ps(acc + i);
+			__m256 m = _mm256_loadu_ps(in + i);
+			_mm256_storeu_ps(acc + i, _mm256_add_ps(a, _mm256_mul_ps(m, vf)));
+		}
+		if (i < n) SSE2::mulAcc(acc + i, in + i, n - i, f);
+	}
+
+	[[gnu::target("avx2")]] static void sumChannels(float* out, const float* const* bufs, size_t num, size_t n)
+	{
+		assert(num >= 1);
+		size_t n8 = n & ~size_t(7);
+		for (auto j : xrange(num)) {
+			const float* b = bufs[j];
+			for (size_t i = 0; i < n8; i += 8) {
+				_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_loadu_ps(b + i)));
+			}
+		}
+		if (n8 < n) SSE2::sumChannelsFrom(n8, out, bufs, num, n);
+	}
+};
+#endif
+
+template<typename Impl> static constexpr Kernels makeKernels()
+{
+	return Kernels{
+		&Impl::mul, &Impl::mulAcc, &Impl::mulExpand, &Impl::mulExpandAcc,
+		&Impl::mulMix2, &Impl::mulMix2Acc, &Impl::sumChannels, &Impl::mixBalance,
+	};
+}
+
+bool isSupported(ISA isa)
+{
+	switch (isa) {
+	case ISA::SCALAR:
+		return true;
+	case ISA::SSE2:
+#ifdef __SSE2__
+		return true;
+#else
+		return false;
+#endif
+	case ISA::AVX2:
+#ifdef MIX_KERNELS_AVX2
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	case ISA::NEON:
+#ifdef MIX_KERNELS_NEON
+		return true;
+#else
+		return false;
+#endif
+	default:
+		UNREACHABLE;
+	}
+}
+
+ISA getBest()
+{
+	for (auto isa : {ISA::AVX2, ISA::SSE2, ISA::NEON}) {
+		if (isSupported(isa)) return isa;
+	}
+	return ISA::SCALAR;
+}
+
+const Kernels& get(ISA isa)
+{
+	assert(isSupported(isa));
+	switch (isa) {
+	case ISA::SCALAR: {
+		static constexpr auto kernels = makeKernels<Scalar>();
+		return kernels;
+	}
+#ifdef __SSE2__
+	case ISA::SSE2: {
+		static constexpr auto kernels = makeKernels<SSE2>();
+		return kernels;
+	}
+#endif
+#ifdef MIX_KERNELS_AVX2
+	case ISA::AVX2: {
+		static constexpr auto kernels = [] {
+			auto k = makeKernels<SSE2>();
+			k.mul         = &AVX2::mul;
+			k.mulAcc      = &AVX2::mulAcc;
+			k.sumChannels = &AVX2::sumChannels;
+			return k;
+		}();
+		return kernels;
+	}
+#endif
+#ifdef MIX_KERNELS_NEON
+	case ISA::NEON: {
+		static constexpr auto kernels = makeKernels<NEON>();
+		return kernels;
+	}
+#endif
+	default:
+		UNREACHABLE;
+	}
+}
+
+const Kernels& get()
+{
+	static const Kernels& best = get(getBest());
+	return best;
+}
+
+} // namespace openmsx::MixKernels
@@ -0,0 +1,80 @@
+#ifndef MIXKERNELS_HH
+#define MIXKERNELS_HH
+
+#include <cstddef>
+#include <cstdint>
+
+namespace openmsx {
+
+/** The inner loops of the sound mixing: scaling a buffer by a volume,
+  * accumulating one buffer into another, expanding mono to stereo with a
+  * balance, re-panning stereo and summing the channels of a sound device.
+  *
+  * There are several instruction set specific implementations. They all
+  * perform the same floating point operations in the same order, so (apart
+  * from possible compiler contractions into fused multiply-adds) they give
+  * the same result. Normally the best one supported by the host CPU is used
+  * (see get()), the others are only exposed for unittests and benchmarks.
+  *
+  * Buffers are passed as raw pointers, stereo data is interleaved (left,
+  * right). No alignment is required. Routines that are documented to
+  * process 'up to 3 extra' elements may read and write past the end of the
+  * buffer, the caller must provide the necessary padding (like MSXMixer and
+  * SoundDevice already do).
+  */
+namespace MixKernels {
+	enum class ISA : uint8_t { SCALAR, SSE2, AVX2, NEON };
+
+	[[nodiscard]] bool isSupported(ISA isa);
+	[[nodiscard]] ISA getBest();
+
+	struct Kernels {
+		// buf[0:n] *= f
+		//  (processes up to 3 extra elements)
+		void (*mul)(float* buf, size_t n, float f);
+
+		// acc[0:n] += in[0:n] * f
+		//  (processes up to 3 extra elements)
+		void (*mulAcc)(float* __restrict acc, const float* __restrict in, size_t n, float f);
+
+		// buf[0:2n+0:2] = buf[0:n] * l
+		// buf[1:2n+1:2] = buf[0:n] * r
+		//  (in-place, mono input, stereo output)
+		void (*mulExpand)(float* buf, size_t n, float l, float r);
+
+		// acc[0:2n+0:2] += in[0:n] * l
+		// acc[1:2n+1:2] += in[0:n] * r
+		void (*mulExpandAcc)(float* __restrict acc, const float* __restrict in, size_t n, float l, float r);
+
+		// buf[0:2n+0:2] = buf[0:2n+0:2] * l1 + buf[1:2n+1:2] * l2
+		// buf[1:2n+1:2] = buf[0:2n+0:2] * r1 + buf[1:2n+1:2] * r2
+		void (*mulMix2)(float* buf, size_t n, float l1, float l2, float r1, float r2);
+
+		// acc[0:2n+0:2] += in[0:2n+0:2] * l1 + in[1:2n+1:2] * l2
+		// acc[1:2n+1:2] += in[0:2n+0:2] * r1 + in[1:2n+1:2] * r2
+		void (*mulMix2Acc)(float* __restrict acc, const float* __restrict in, size_t n,
+		                   float l1, float l2, float r1, float r2);
+
+		// out[0:n] += bufs[0][0:n] + bufs[1][0:n] + ... + bufs[num-1][0:n]
+		//  (num >= 1, processes up to 3 extra elements)
+		void (*sumChannels)(float* out, const float* const* bufs, size_t num, size_t n);
+
+		// out[0:2n+0:2] = bufs[0][0:n] * balance[0] + bufs[1][0:n] * balance[2] + ...
+		// out[1:2n+1:2] = bufs[0][0:n] * balance[1] + bufs[1][0:n] * balance[3] + ...
+		//  (num >= 1, mono inputs, stereo output, processes up to 1 extra
+		//   sample)
+		void (*mixBalance)(float* out, const float* const* bufs, const float* balance,
+		                   size_t num, size_t n);
+	};
+
+	/** Get the implementation for the given instruction set, which must
+	  * be supported. */
+	[[nodiscard]] const Kernels& get(ISA isa);
+
+	/** Shortcut for get(getBest()). */
+	[[nodiscard]] const Kernels& get();
+}
+
+} // namespace openmsx
+
+#endif
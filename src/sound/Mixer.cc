@@ -6,14 +6,20 @@
 
 #include "CliComm.hh"
 #include "CommandController.hh"
+#include "CommandException.hh"
 #include "MSXException.hh"
+#include "TclObject.hh"
+#include "ThreadPool.hh"
 
 #include "one_of.hh"
+#include "outer.hh"
 #include "stl.hh"
 #include "unreachable.hh"
 
+#include <array>
 #include <cassert>
 #include <memory>
+#include <string_view>
 
 namespace openmsx {
 
@@ -50,11 +56,18 @@ Mixer::Mixer(Reactor& reactor_, CommandController& commandController_)
 	, samplesSetting(
 		commandController, "samples",
 		"mixer samples", defaultSamples, 64, 8192)
+	, audioWorkersSetting(
+		commandController, "audio_workers",
+		"number of extra threads used to generate the sound of the "
+		"individual sound chips, 0 means all sound is generated on "
+		"the main thread", 0, 0, 16)
+	, statsCmd(commandController)
 {
 	muteSetting       .attach(*this);
 	frequencySetting  .attach(*this);
 	samplesSetting    .attach(*this);
 	soundDriverSetting.attach(*this);
+	audioWorkersSetting.attach(*this);
 
 	// Set correct initial mute state.
 	if (muteSetting.getBoolean()) ++muteCount;
@@ -67,6 +80,7 @@ Mixer::~Mixer()
 	assert(msxMixers.empty());
 	driver.reset();
 
+	audioWorkersSetting.detach(*this);
 	soundDriverSetting.detach(*this);
 	samplesSetting    .detach(*this);
 	frequencySetting  .detach(*this);
@@ -158,6 +172,16 @@ void Mixer::uploadBuffer(MSXMixer& /*msxMixer*/, std::span<const StereoFloat> bu
 	driver->uploadBuffer(buffer);
 }
 
+ThreadPool* Mixer::getAudioWorkers()
+{
+	auto num = unsigned(audioWorkersSetting.getInt());
+	if (num == 0) return nullptr;
+	if (!audioWorkers) {
+		audioWorkers = std::make_unique<ThreadPool>(num);
+	}
+	return audioWorkers.get();
+}
+
 void Mixer::update(const Setting& setting) noexcept
 {
 	if (&setting == &muteSetting) {
@@ -169,9 +193,70 @@ void Mixer::update(const Setting& setting) noexcept
 	} else if (&setting == one_of(&samplesSetting, &soundDriverSetting, &frequencySetting)) {
 		reloadDriver();
 		muteHelper();
+	} else if (&setting == &audioWorkersSetting) {
+		// (re)created with the new number of threads on next use
+		audioWorkers.reset();
 	} else {
 		UNREACHABLE;
 	}
 }
 
+
+// class Mixer::StatsCmd
+
+Mixer::StatsCmd::StatsCmd(CommandController& controller)
+	: Command(controller, "sound_driver_stats")
+{
+}
+
+void Mixer::StatsCmd::execute(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, Between{1, 2}, "?reset?");
+	auto& mixer = OUTER(Mixer, statsCmd);
+	if (!mixer.driver) {
+		throw CommandException("No sound driver active.");
+	}
+	if (tokens.size() == 2) {
+		if (tokens[1] != "reset") {
+			throw CommandException("Unknown subcommand, must be 'reset'.");
+		}
+		mixer.driver->resetStats();
+		return;
+	}
+	auto stats = mixer.driver->getStats();
+	auto toMs = [&](double samples) {
+		return 1000.0 * samples / double(mixer.driver->getFrequency());
+	};
+	result.addDictKeyValues("callbacks",            stats.callbacks,
+	                        "underruns",            stats.underruns,
+	                        "underrun_samples",     stats.underrunSamples,
+	                        "overruns",             stats.overruns,
+	                        "dropped_samples",      stats.droppedSamples,
+	                        "mean_queue_depth",     stats.meanQueueDepth,
+	                        "mean_queue_depth_ms",  toMs(stats.meanQueueDepth),
+	                        "target_latency",       stats.targetLatency,
+	                        "target_latency_ms",    toMs(stats.targetLatency));
+}
+
+std::string Mixer::StatsCmd::help(std::span<const TclObject> /*tokens*/) const
+{
+	return "Statistics about the buffer between the emulation and the audio device.\n"
+	       "  sound_driver_stats         returns a dict with: the number of callbacks\n"
+	       "                             from the audio device, how many of those were\n"
+	       "                             underruns (and the number of missing samples),\n"
+	       "                             the number of overruns (uploads that didn't fit)\n"
+	       "                             and dropped samples, the mean number of queued\n"
+	       "                             samples and the current (adaptive) target latency\n"
+	       "  sound_driver_stats reset   reset the counters\n";
+}
+
+void Mixer::StatsCmd::tabCompletion(std::vector<std::string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		using namespace std::literals;
+		static constexpr std::array subCommands = {"reset"sv};
+		completeString(tokens, subCommands);
+	}
+}
+
 } // namespace openmsx
@@ -2,6 +2,7 @@
 #define MIXER_HH
 
 #include "BooleanSetting.hh"
+#include "Command.hh"
 #include "EnumSetting.hh"
 #include "IntegerSetting.hh"
 
@@ -15,6 +16,7 @@ namespace openmsx {
 
 class SoundDriver;
 class Reactor;
+class ThreadPool;
 class CommandController;
 class MSXMixer;
 
@@ -58,6 +60,12 @@ public:
 	[[nodiscard]] IntegerSetting& getMasterVolume() { return masterVolume; }
 	[[nodiscard]] BooleanSetting& getMuteSetting() { return muteSetting; }
 
+	/** Threads to generate the sound of the individual sound devices in
+	  * parallel, see the 'audio_workers' setting. Returns nullptr when all
+	  * sound should be generated on the main thread.
+	  */
+	[[nodiscard]] ThreadPool* getAudioWorkers();
+
 private:
 	void reloadDriver();
 	void muteHelper();
@@ -69,6 +77,7 @@ private:
 	std::vector<MSXMixer*> msxMixers; // unordered
 
 	std::unique_ptr<SoundDriver> driver;
+	std::unique_ptr<ThreadPool> audioWorkers; // created on demand
 	Reactor& reactor;
 	CommandController& commandController;
 
@@ -77,6 +86,14 @@ private:
 	IntegerSetting masterVolume;
 	IntegerSetting frequencySetting;
 	IntegerSetting samplesSetting;
+	IntegerSetting audioWorkersSetting;
+
+	struct StatsCmd final : Command {
+		explicit StatsCmd(CommandController& controller);
+		void execute(std::span<const TclObject> tokens, TclObject& result) override;
+		[[nodiscard]] std::string help(std::span<const TclObject> tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} statsCmd;
 
 	int muteCount = 0;
 };
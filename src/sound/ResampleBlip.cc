@@ -72,13 +72,18 @@ bool ResampleBlip<CHANNELS>::generateOutputImpl(float* dataOut, size_t hostNum,
 			}
 		} else {
 			// input all zero
-			BlipBuffer::TimeIndex pos;
-			hostClock.getTicksTill(emu1, pos);
-			for (auto ch : xrange(CHANNELS)) {
-				if (lastInput[ch] != 0.0f) {
-					auto delta = -lastInput[ch];
-					lastInput[ch] = 0.0f;
-					blip[ch].addDelta(pos, delta);
+			if (std::ranges::all_of(lastInput, [](float f) { return f == 0.0f; })) {
+				// and it already was zero: nothing to do
+				input.countResampleSkipped();
+			} else {
+				BlipBuffer::TimeIndex pos;
+				hostClock.getTicksTill(emu1, pos);
+				for (auto ch : xrange(CHANNELS)) {
+					if (lastInput[ch] != 0.0f) {
+						auto delta = -lastInput[ch];
+						lastInput[ch] = 0.0f;
+						blip[ch].addDelta(pos, delta);
+					}
 				}
 			}
 		}
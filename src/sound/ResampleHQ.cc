@@ -21,6 +21,7 @@
 #include "ranges.hh"
 #include "small_buffer.hh"
 #include "stl.hh"
+#include "unreachable.hh"
 #include "xrange.hh"
 
 #include <algorithm>
@@ -33,6 +34,10 @@
 #include <vector>
 #ifdef __SSE2__
 #include <emmintrin.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define RESAMPLE_HQ_AVX2
+#endif
 #endif
 
 namespace openmsx {
@@ -53,8 +58,15 @@ using FilterIndex = FixedPoint<16>;
 static constexpr int INDEX_INC = 128;
 static constexpr int COEFF_LEN = int(std::size(coeffs) - 1);
 static constexpr int COEFF_HALF_LEN = COEFF_LEN - 1;
-static constexpr size_t TAB_LEN      = ResampleHQ<1>::TAB_LEN;
-static constexpr size_t HALF_TAB_LEN = ResampleHQ<1>::HALF_TAB_LEN;
+static constexpr size_t TAB_LEN      = ResampleFilter::TAB_LEN;
+static constexpr size_t HALF_TAB_LEN = ResampleFilter::HALF_TAB_LEN;
+
+// The filter for Quality::MEDIUM is calculated (instead of interpolated from
+// the table above). It has the same cut-off frequency (zero crossings every
+// 1.2 input samples), but only half the length. Instead of the original
+// window (not known exactly) it uses a 4-term Blackman-Harris window.
+static constexpr int MEDIUM_HALF_LEN = COEFF_HALF_LEN / 2;
+static constexpr double MEDIUM_CUTOFF = 1.0 / 1.2;
 
 class ResampleCoeffs
 {
@@ -64,9 +76,12 @@ public:
 	ResampleCoeffs& operator=(const ResampleCoeffs&) = delete;
 	ResampleCoeffs& operator=(ResampleCoeffs&&) = delete;
 
+	using Quality = ResampleFilter::Quality;
+
 	static ResampleCoeffs& instance();
-	void getCoeffs(double ratio, std::span<const int16_t, HALF_TAB_LEN>& permute, float*& table, unsigned& filterLen);
-	void releaseCoeffs(double ratio);
+	void getCoeffs(double ratio, Quality quality, std::span<const int16_t, HALF_TAB_LEN>& permute,
+	               const float*& table, unsigned& filterLen, unsigned& delay);
+	void releaseCoeffs(double ratio, Quality quality);
 
 private:
 	using Table = MemBuffer<float, SSE_ALIGNMENT>;
@@ -75,13 +90,16 @@ private:
 	ResampleCoeffs() = default;
 	~ResampleCoeffs();
 
-	static Table calcTable(double ratio, std::span<int16_t, HALF_TAB_LEN> permute, unsigned& filterLen);
+	static Table calcTable(double ratio, Quality quality, std::span<int16_t, HALF_TAB_LEN> permute,
+	                       unsigned& filterLen, unsigned& delay);
 
 	struct Element {
 		double ratio;
+		Quality quality;
 		PermuteTable permute; // need stable address (can't directly use std::array)
 		Table table;
 		unsigned filterLen;
+		unsigned delay;
 		unsigned count;
 	};
 	std::vector<Element> cache; // typically 1-4 entries -> unsorted vector
@@ -99,31 +117,38 @@ ResampleCoeffs& ResampleCoeffs::instance()
 }
 
 void ResampleCoeffs::getCoeffs(
-	double ratio, std::span<const int16_t, HALF_TAB_LEN>& permute, float*& table, unsigned& filterLen)
+	double ratio, Quality quality, std::span<const int16_t, HALF_TAB_LEN>& permute,
+	const float*& table, unsigned& filterLen, unsigned& delay)
 {
-	if (auto it = std::ranges::find(cache, ratio, &Element::ratio);
+	if (auto it = std::ranges::find_if(cache, [&](const Element& e) {
+		return (e.ratio == ratio) && (e.quality == quality); });
 	    it != end(cache)) {
 		permute   = std::span<int16_t, HALF_TAB_LEN>{it->permute};
 		table     = it->table.data();
 		filterLen = it->filterLen;
+		delay     = it->delay;
 		it->count++;
 		return;
 	}
 	Element elem;
 	elem.ratio = ratio;
+	elem.quality = quality;
 	elem.count = 1;
 	elem.permute = PermuteTable(HALF_TAB_LEN);
 	auto perm = std::span<int16_t, HALF_TAB_LEN>{elem.permute};
-	elem.table = calcTable(ratio, perm, elem.filterLen);
+	elem.table = calcTable(ratio, quality, perm, elem.filterLen, elem.delay);
 	permute   = perm;
 	table     = elem.table.data();
 	filterLen = elem.filterLen;
+	delay     = elem.delay;
 	cache.push_back(std::move(elem));
 }
 
-void ResampleCoeffs::releaseCoeffs(double ratio)
+void ResampleCoeffs::releaseCoeffs(double ratio, Quality quality)
 {
-	auto it = rfind_unguarded(cache, ratio, &Element::ratio);
+	auto it = std::ranges::find_if(cache, [&](const Element& e) {
+		return (e.ratio == ratio) && (e.quality == quality); });
+	assert(it != end(cache));
 	it->count--;
 	if (it->count == 0) {
 		move_pop_back(cache, it);
@@ -333,21 +358,40 @@ static constexpr double getCoeff(FilterIndex index)
 	       fraction * (double(coeffs[indx + 1]) - double(coeffs[indx]));
 }
 
+static double getMediumCoeff(FilterIndex index)
+{
+	// 'x' is expressed in input samples (for ratio <= 1)
+	double x = index.toDouble() / INDEX_INC;
+	double halfLen = double(MEDIUM_HALF_LEN) / INDEX_INC;
+	if (x >= halfLen) return 0.0;
+	double t = Math::pi * x / halfLen;
+	double window = 0.35875 + 0.48829 * cos(t) + 0.14128 * cos(2 * t) + 0.01168 * cos(3 * t);
+	double s = Math::pi * MEDIUM_CUTOFF * x;
+	double sinc = (s == 0.0) ? 1.0 : sin(s) / s;
+	return MEDIUM_CUTOFF * sinc * window;
+}
+
 ResampleCoeffs::Table ResampleCoeffs::calcTable(
-	double ratio, std::span<int16_t, HALF_TAB_LEN> permute, unsigned& filterLen)
+	double ratio, Quality quality, std::span<int16_t, HALF_TAB_LEN> permute,
+	unsigned& filterLen, unsigned& delay)
 {
 	calcPermute(ratio, permute);
 
 	double floatIncr = (ratio > 1.0) ? INDEX_INC / ratio : INDEX_INC;
 	double normFactor = floatIncr / INDEX_INC;
 	auto increment = FilterIndex(floatIncr);
-	FilterIndex maxFilterIndex(COEFF_HALF_LEN);
+	bool high = quality == Quality::HIGH;
+	FilterIndex maxFilterIndex(high ? COEFF_HALF_LEN : MEDIUM_HALF_LEN);
+	auto coeff = [&](FilterIndex index) {
+		return high ? getCoeff(index) : getMediumCoeff(index);
+	};
 
 	int min_idx = -maxFilterIndex.divAsInt(increment);
 	int max_idx = 1 + (maxFilterIndex - (increment - FilterIndex(floatIncr))).divAsInt(increment);
 	int idx_cnt = max_idx - min_idx + 1;
 	filterLen = (idx_cnt + 3) & ~3; // round up to multiple of 4
 	min_idx -= (narrow<int>(filterLen) - idx_cnt) / 2;
+	delay = -min_idx;
 	Table table(HALF_TAB_LEN * filterLen);
 	std::ranges::fill(std::span{table}, 0.0f);
 
@@ -362,7 +406,7 @@ ResampleCoeffs::Table ResampleCoeffs::calcTable(
 		int bufIndex = -coeffCount;
 		do {
 			tab[bufIndex - min_idx] =
-				float(getCoeff(filterIndex) * normFactor);
+				float(coeff(filterIndex) * normFactor);
 			filterIndex -= increment;
 			bufIndex += 1;
 		} while (filterIndex >= FilterIndex(0));
@@ -373,40 +417,80 @@ ResampleCoeffs::Table ResampleCoeffs::calcTable(
 		bufIndex = 1 + coeffCount;
 		do {
 			tab[bufIndex - min_idx] =
-				float(getCoeff(filterIndex) * normFactor);
+				float(coeff(filterIndex) * normFactor);
 			filterIndex -= increment;
 			bufIndex -= 1;
 		} while (filterIndex > FilterIndex(0));
+
+		if (!high) {
+			// The DC gain of the shorter filter deviates a bit more
+			// from 1 (and differs per row), correct for that. (Not
+			// done for the HIGH quality filter, to keep its output
+			// unchanged.)
+			auto row = std::span{tab, filterLen};
+			float sum = 0.0f;
+			for (auto c : row) sum += c;
+			for (auto& c : row) c /= sum;
+		}
 	}
 	return table;
 }
 
 static const std::array<int16_t, HALF_TAB_LEN> dummyPermute = {};
 
+ResampleFilter::ResampleFilter(double ratio_, Quality quality_, Impl impl_)
+	: permute(dummyPermute) // Any better way to do this? (that also works with debug-STL)
+	, ratio(ratio_)
+	, quality(quality_)
+	, impl(impl_)
+{
+	assert(isSupported(impl));
+	ResampleCoeffs::instance().getCoeffs(ratio, quality, permute, table, filterLen, delay);
+}
+
+ResampleFilter::~ResampleFilter()
+{
+	ResampleCoeffs::instance().releaseCoeffs(ratio, quality);
+}
+
+bool ResampleFilter::isSupported(Impl impl)
+{
+	switch (impl) {
+	case Impl::PORTABLE:
+		return true;
+	case Impl::AVX2_FMA:
+#ifdef RESAMPLE_HQ_AVX2
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+		return false;
+#endif
+	default:
+		UNREACHABLE;
+	}
+}
+
+ResampleFilter::Impl ResampleFilter::getBest()
+{
+	return isSupported(Impl::AVX2_FMA) ? Impl::AVX2_FMA : Impl::PORTABLE;
+}
+
 template<unsigned CHANNELS>
 ResampleHQ<CHANNELS>::ResampleHQ(
-		ResampledSoundDevice& input_, const DynamicClock& hostClock_)
+		ResampledSoundDevice& input_, const DynamicClock& hostClock_,
+		Quality quality)
 	: ResampleAlgo(input_)
 	, hostClock(hostClock_)
 	, ratio(float(hostClock.getPeriod().toDouble() / getEmuClock().getPeriod().toDouble()))
-	, permute(dummyPermute) // Any better way to do this? (that also works with debug-STL)
+	, filter(double(ratio), quality)
 {
-	ResampleCoeffs::instance().getCoeffs(double(ratio), permute, table, filterLen);
-
 	// fill buffer with 'enough' zero's
-	unsigned extra = filterLen + 1 + narrow_cast<int>(ratio) + 1;
+	unsigned extra = filter.getFilterLen() + 1 + narrow_cast<int>(ratio) + 1;
 	bufStart = 0;
 	bufEnd   = extra;
 	size_t initialSize = 4000; // buffer grows dynamically if this is too small
 	buffer.resize((initialSize + extra) * CHANNELS); // zero-initialized
 }
 
-template<unsigned CHANNELS>
-ResampleHQ<CHANNELS>::~ResampleHQ()
-{
-	ResampleCoeffs::instance().releaseCoeffs(double(ratio));
-}
-
 #ifdef __SSE2__
 
 static inline __m128 reverse(__m128 x)
@@ -542,23 +626,123 @@ static inline void calcSseStereo(const float* buf_, const float* tab_, size_t le
 
 #endif
 
+#ifdef RESAMPLE_HQ_AVX2
+
+// Same as calcSseMono(), but processes 8 elements at a time and uses fused
+// multiply-add instructions.
+template<bool REVERSE>
+[[gnu::target("avx2,fma")]] static void calcAvxMono(const float* buf, const float* tab, size_t len, float* out)
+{
+	assert((len % 4) == 0);
+	const __m256i rev = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+
+	__m256 a0 = _mm256_setzero_ps();
+	__m256 a1 = _mm256_setzero_ps();
+	size_t i = 0;
+	for (/**/; (i + 16) <= len; i += 16) {
+		__m256 t0, t1;
+		if constexpr (REVERSE) {
+			t0 = _mm256_permutevar8x32_ps(_mm256_loadu_ps(tab - i -  8), rev);
+			t1 = _mm256_permutevar8x32_ps(_mm256_loadu_ps(tab - i - 16), rev);
+		} else {
+			t0 = _mm256_loadu_ps(tab + i + 0);
+			t1 = _mm256_loadu_ps(tab + i + 8);
+		}
+		a0 = _mm256_fmadd_ps(_mm256_loadu_ps(buf + i + 0), t0, a0);
+		a1 = _mm256_fmadd_ps(_mm256_loadu_ps(buf + i + 8), t1, a1);
+	}
+	if ((i + 8) <= len) {
+		__m256 t0;
+		if constexpr (REVERSE) {
+			t0 = _mm256_permutevar8x32_ps(_mm256_loadu_ps(tab - i - 8), rev);
+		} else {
+			t0 = _mm256_loadu_ps(tab + i);
+		}
+		a0 = _mm256_fmadd_ps(_mm256_loadu_ps(buf + i), t0, a0);
+		i += 8;
+	}
+	__m256 a8 = _mm256_add_ps(a0, a1);
+	__m128 a = _mm_add_ps(_mm256_castps256_ps128(a8), _mm256_extractf128_ps(a8, 1));
+	if (i < len) {
+		assert((i + 4) == len);
+		__m128 t0;
+		if constexpr (REVERSE) {
+			t0 = reverse(_mm_loadu_ps(tab - i - 4));
+		} else {
+			t0 = _mm_loadu_ps(tab + i);
+		}
+		a = _mm_fmadd_ps(_mm_loadu_ps(buf + i), t0, a);
+	}
+
+	__m128 t = _mm_add_ps(a, _mm_movehl_ps(a, a));
+	__m128 s = _mm_add_ss(t, _mm_shuffle_ps(t, t, 1));
+	_mm_store_ss(out, s);
+}
+
+// Same as calcSseStereo(), but processes 4 (stereo) samples at a time and uses
+// fused multiply-add instructions. Each coefficient is duplicated for the left
+// and right channel.
+template<bool REVERSE>
+[[gnu::target("avx2,fma")]] static void calcAvxStereo(const float* buf, const float* tab, size_t len, float* out)
+{
+	assert((len % 4) == 0);
+	const __m256i dup = REVERSE ? _mm256_setr_epi32(3, 3, 2, 2, 1, 1, 0, 0)
+	                            : _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+
+	__m256 a0 = _mm256_setzero_ps();
+	__m256 a1 = _mm256_setzero_ps();
+	size_t i = 0;
+	for (/**/; (i + 8) <= len; i += 8) {
+		__m128 ta, tb;
+		if constexpr (REVERSE) {
+			ta = _mm_loadu_ps(tab - i - 4);
+			tb = _mm_loadu_ps(tab - i - 8);
+		} else {
+			ta = _mm_loadu_ps(tab + i + 0);
+			tb = _mm_loadu_ps(tab + i + 4);
+		}
+		__m256 t0 = _mm256_permutevar8x32_ps(_mm256_castps128_ps256(ta), dup);
+		__m256 t1 = _mm256_permutevar8x32_ps(_mm256_castps128_ps256(tb), dup);
+		a0 = _mm256_fmadd_ps(_mm256_loadu_ps(buf + 2 * i + 0), t0, a0);
+		a1 = _mm256_fmadd_ps(_mm256_loadu_ps(buf + 2 * i + 8), t1, a1);
+	}
+	if (i < len) {
+		assert((i + 4) == len);
+		__m128 ta = REVERSE ? _mm_loadu_ps(tab - i - 4) : _mm_loadu_ps(tab + i);
+		__m256 t0 = _mm256_permutevar8x32_ps(_mm256_castps128_ps256(ta), dup);
+		a0 = _mm256_fmadd_ps(_mm256_loadu_ps(buf + 2 * i), t0, a0);
+	}
+
+	__m256 a8 = _mm256_add_ps(a0, a1);
+	__m128 a = _mm_add_ps(_mm256_castps256_ps128(a8), _mm256_extractf128_ps(a8, 1));
+	__m128 s = _mm_add_ps(a, _mm_movehl_ps(a, a));
+	_mm_store_ss(&out[0], s);
+	_mm_store_ss(&out[1], shuffle<0x55>(s));
+}
+
+#endif
+
 template<unsigned CHANNELS>
-void ResampleHQ<CHANNELS>::calcOutput(
-	float pos, float* __restrict output)
+void ResampleFilter::calcOutput(const float* buf, float pos, float* output) const
 {
 	assert((filterLen & 3) == 0);
 
-	int bufIdx = int(pos) + bufStart;
-	assert((bufIdx + filterLen) <= bufEnd);
-	bufIdx *= CHANNELS;
-	const float* buf = &buffer[bufIdx];
-
 	auto t = size_t(lrintf(pos * TAB_LEN)) % TAB_LEN;
 	if (!(t & HALF_TAB_LEN)) {
 		// first half, begin of row 't'
 		t = permute[t];
 		const float* tab = &table[t * filterLen];
 
+#ifdef RESAMPLE_HQ_AVX2
+		if (impl == Impl::AVX2_FMA) {
+			if constexpr (CHANNELS == 1) {
+				calcAvxMono  <false>(buf, tab, filterLen, output);
+			} else {
+				calcAvxStereo<false>(buf, tab, filterLen, output);
+			}
+			return;
+		}
+#endif
 #ifdef __SSE2__
 		if constexpr (CHANNELS == 1) {
 			calcSseMono  <false>(buf, tab, filterLen, output);
@@ -588,6 +772,16 @@ void ResampleHQ<CHANNELS>::calcOutput(
 		t = permute[TAB_LEN - 1 - t];
 		const float* tab = &table[(t + 1) * filterLen];
 
+#ifdef RESAMPLE_HQ_AVX2
+		if (impl == Impl::AVX2_FMA) {
+			if constexpr (CHANNELS == 1) {
+				calcAvxMono  <true>(buf, tab, filterLen, output);
+			} else {
+				calcAvxStereo<true>(buf, tab, filterLen, output);
+			}
+			return;
+		}
+#endif
 #ifdef __SSE2__
 		if constexpr (CHANNELS == 1) {
 			calcSseMono  <true>(buf, tab, filterLen, output);
@@ -615,9 +809,22 @@ void ResampleHQ<CHANNELS>::calcOutput(
 	}
 }
 
+// Force template instantiation.
+template void ResampleFilter::calcOutput<1>(const float*, float, float*) const;
+template void ResampleFilter::calcOutput<2>(const float*, float, float*) const;
+
 template<unsigned CHANNELS>
-void ResampleHQ<CHANNELS>::prepareData(unsigned emuNum)
+bool ResampleHQ<CHANNELS>::prepareData(unsigned emuNum)
 {
+	small_buffer<float, 8192> tmpBufExtra(uninitialized_tag{}, emuNum * CHANNELS + 3); // typical ~5194 (PSG, samples=1024) but could be larger
+	bool silent = !input.generateInput(tmpBufExtra.data(), emuNum);
+	if (silent && (nonzeroSamples == 0)) {
+		// Fast path: the buffer only contains zeros and only more zeros
+		// would be appended. Then appending and dropping the same
+		// number of samples is the same as leaving the buffer as-is.
+		return false;
+	}
+
 	// Still enough free space at end of buffer?
 	unsigned free = unsigned(buffer.size() / CHANNELS) - bufEnd;
 	if (free < emuNum) {
@@ -642,9 +849,8 @@ void ResampleHQ<CHANNELS>::prepareData(unsigned emuNum)
 			buffer.resize(buffer.size() + missing * size_t(CHANNELS));
 		}
 	}
-	small_buffer<float, 8192> tmpBufExtra(uninitialized_tag{}, emuNum * CHANNELS + 3); // typical ~5194 (PSG, samples=1024) but could be larger
-	auto tmpBuf = subspan(tmpBufExtra, 0, emuNum * CHANNELS);
-	if (input.generateInput(tmpBufExtra.data(), emuNum)) {
+	if (!silent) {
+		auto tmpBuf = subspan(tmpBufExtra, 0, emuNum * CHANNELS);
 		copy_to_range(tmpBuf,
 		              subspan(buffer, bufEnd * CHANNELS));
 		bufEnd += emuNum;
@@ -656,6 +862,7 @@ void ResampleHQ<CHANNELS>::prepareData(unsigned emuNum)
 
 	assert(bufStart <= bufEnd);
 	assert(bufEnd <= (buffer.size() / CHANNELS));
+	return true;
 }
 
 template<unsigned CHANNELS>
@@ -664,8 +871,10 @@ bool ResampleHQ<CHANNELS>::generateOutputImpl(
 {
 	auto& emuClk = getEmuClock();
 	unsigned emuNum = emuClk.getTicksTill(time);
+	bool shift = true;
 	if (emuNum > 0) {
-		prepareData(emuNum);
+		shift = prepareData(emuNum);
+		if (!shift) input.countResampleSkipped();
 	}
 
 	bool notMuted = nonzeroSamples > 0;
@@ -675,18 +884,23 @@ bool ResampleHQ<CHANNELS>::generateOutputImpl(
 		assert(host1 > emuClk.getTime());
 		auto pos = narrow_cast<float>(emuClk.getTicksTillDouble(host1));
 		assert(pos <= (ratio + 2));
+		unsigned filterLen = filter.getFilterLen();
 		for (auto i : xrange(hostNum)) {
-			calcOutput(pos, &dataOut[i * CHANNELS]);
+			int bufIdx = int(pos) + bufStart;
+			assert((bufIdx + filterLen) <= bufEnd); (void)filterLen;
+			filter.calcOutput<CHANNELS>(&buffer[bufIdx * CHANNELS], pos, &dataOut[i * CHANNELS]);
 			pos += ratio;
 		}
 	}
 	emuClk += emuNum;
-	bufStart += emuNum;
-	nonzeroSamples = std::max<int>(0, nonzeroSamples - emuNum);
+	if (shift) {
+		bufStart += emuNum;
+		nonzeroSamples = std::max<int>(0, nonzeroSamples - emuNum);
+	}
 
 	assert(bufStart <= bufEnd);
 	unsigned available = bufEnd - bufStart;
-	unsigned extra = filterLen + 1 + narrow_cast<int>(ratio) + 1;
+	unsigned extra = filter.getFilterLen() + 1 + narrow_cast<int>(ratio) + 1;
 	assert(available == extra); (void)available; (void)extra;
 
 	return notMuted;
@@ -11,38 +11,99 @@ namespace openmsx {
 class DynamicClock;
 class ResampledSoundDevice;
 
-template<unsigned CHANNELS>
-class ResampleHQ final : public ResampleAlgo
+/** The polyphase (band limited sinc) filter used by ResampleHQ.
+  *
+  * The filter coefficients for each of the TAB_LEN phases are calculated once
+  * per (resample-ratio, quality) pair, and shared between all sound devices
+  * (and between mono and stereo devices).
+  *
+  * This is a separate class (instead of being part of ResampleHQ) so that it
+  * can be tested and benchmarked without a sound device.
+  */
+class ResampleFilter
 {
 public:
 	static constexpr size_t TAB_LEN = 4096;
 	static constexpr size_t HALF_TAB_LEN = TAB_LEN / 2;
 
+	/** HIGH uses the full filter (97dB SNR, 80% BW). MEDIUM uses a filter
+	  * of half the length (so roughly twice as fast), with a smaller
+	  * stop-band attenuation and a wider transition band.
+	  */
+	enum class Quality : uint8_t { HIGH, MEDIUM };
+
+	/** The portable implementation uses SSE2 when that's enabled at
+	  * compile time. The AVX2 one also uses fused multiply-add
+	  * instructions, so its results are slightly different (more precise).
+	  * It's only used when the host CPU supports it.
+	  */
+	enum class Impl : uint8_t { PORTABLE, AVX2_FMA };
+	[[nodiscard]] static bool isSupported(Impl impl);
+	[[nodiscard]] static Impl getBest();
+
+	ResampleFilter(double ratio, Quality quality, Impl impl = getBest());
+	ResampleFilter(const ResampleFilter&) = delete;
+	ResampleFilter(ResampleFilter&&) = delete;
+	ResampleFilter& operator=(const ResampleFilter&) = delete;
+	ResampleFilter& operator=(ResampleFilter&&) = delete;
+	~ResampleFilter();
+
+	/** Number of input samples used per output sample (multiple of 4). */
+	[[nodiscard]] unsigned getFilterLen() const { return filterLen; }
+
+	/** The filter is centered on input sample 'getDelay()' (plus the
+	  * fractional part of the position, see calcOutput()).
+	  */
+	[[nodiscard]] unsigned getDelay() const { return delay; }
+
+	/** Calculate one output sample.
+	  * @param buf Input samples [int(pos), int(pos) + filterLen), when
+	  *            stereo the samples are interleaved.
+	  * @param pos Position of the output sample, only the fractional part
+	  *            is used (the integer part only influences rounding).
+	  * @param output The result (one or two floats).
+	  */
+	template<unsigned CHANNELS>
+	void calcOutput(const float* buf, float pos, float* output) const;
+
+private:
+	std::span<const int16_t, HALF_TAB_LEN> permute;
+	const float* table;
+	const double ratio;
+	unsigned filterLen;
+	unsigned delay;
+	const Quality quality;
+	const Impl impl;
+};
+
+template<unsigned CHANNELS>
+class ResampleHQ final : public ResampleAlgo
+{
 public:
-	ResampleHQ(ResampledSoundDevice& input, const DynamicClock& hostClock);
+	using Quality = ResampleFilter::Quality;
+
+	ResampleHQ(ResampledSoundDevice& input, const DynamicClock& hostClock,
+	           Quality quality);
 	ResampleHQ(const ResampleHQ&) = delete;
 	ResampleHQ(ResampleHQ&&) = delete;
 	ResampleHQ& operator=(const ResampleHQ&) = delete;
 	ResampleHQ& operator=(ResampleHQ&&) = delete;
-	~ResampleHQ() override;
+	~ResampleHQ() override = default;
 
 	bool generateOutputImpl(float* dataOut, size_t num,
 	                        EmuTime time) override;
 
 private:
-	void calcOutput(float pos, float* output);
-	void prepareData(unsigned emuNum);
+	[[nodiscard]] bool prepareData(unsigned emuNum);
 
 private:
 	const DynamicClock& hostClock;
 	const float ratio;
+	const ResampleFilter filter;
 	unsigned bufStart;
 	unsigned bufEnd;
 	unsigned nonzeroSamples = 0;
-	unsigned filterLen;
 	std::vector<float> buffer;
-	float* table;
-	std::span<const int16_t, HALF_TAB_LEN> permute;
 };
 
 } // namespace openmsx
@@ -68,12 +68,17 @@ void ResampledSoundDevice::createResampler()
 	} else {
 		switch (resampleSetting.getEnum()) {
 		case ResampleType::HQ:
+		case ResampleType::MQ: {
+			auto quality = (resampleSetting.getEnum() == ResampleType::HQ)
+			             ? ResampleFilter::Quality::HIGH
+			             : ResampleFilter::Quality::MEDIUM;
 			if (!isStereo()) {
-				algo = std::make_unique<ResampleHQ<1>>(*this, hostClock);
+				algo = std::make_unique<ResampleHQ<1>>(*this, hostClock, quality);
 			} else {
-				algo = std::make_unique<ResampleHQ<2>>(*this, hostClock);
+				algo = std::make_unique<ResampleHQ<2>>(*this, hostClock, quality);
 			}
 			break;
+		}
 		case ResampleType::BLIP:
 			if (!isStereo()) {
 				algo = std::make_unique<ResampleBlip<1>>(*this, hostClock);
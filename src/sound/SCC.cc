@@ -99,6 +99,8 @@
 #include "SCC.hh"
 
 #include "DeviceConfig.hh"
+#include "MSXMotherBoard.hh"
+#include "VGMRecorder.hh"
 
 #include "cstd.hh"
 #include "enumerate.hh"
@@ -126,6 +128,7 @@ SCC::SCC(const std::string& name_, const DeviceConfig& config,
 	: ResampledSoundDevice(
 		config.getMotherBoard(), name_, calcDescription(mode), 5, INPUT_RATE, false)
 	, debuggable(config.getMotherBoard(), getName())
+	, vgmRecorder(config.getMotherBoard().getVGMRecorder())
 	, deformTimer(time)
 	, currentMode(mode)
 {
@@ -287,6 +290,9 @@ uint8_t SCC::getFreqVol(unsigned address) const
 
 void SCC::writeMem(uint8_t address, uint8_t value, EmuTime time)
 {
+	if (vgmRecorder.isRecording(VGMRecorder::Chip::SCC)) [[unlikely]] {
+		recordVGM(address, value, time);
+	}
 	updateStream(time);
 
 	switch (currentMode) {
@@ -339,6 +345,43 @@ void SCC::writeMem(uint8_t address, uint8_t value, EmuTime time)
 	}
 }
 
+void SCC::recordVGM(uint8_t address, uint8_t value, EmuTime time)
+{
+	// Translate to the 'ports' of the VGM format, see VGMRecorder::write().
+	auto write = [&](uint8_t port, uint8_t reg) {
+		vgmRecorder.write(VGMRecorder::Chip::SCC, port, reg, value, time);
+	};
+	auto freqVol = [&](uint8_t addr) {
+		addr &= 0x0F; // region is visible twice
+		if (addr < 0x0A) {
+			write(1, addr); // frequency
+		} else if (addr < 0x0F) {
+			write(2, addr - 0x0A); // volume
+		} else {
+			write(3, 0); // channel enable
+		}
+	};
+	switch (currentMode) {
+	case Mode::Real:
+		if      (address < 0x80) write(0, address);
+		else if (address < 0xA0) freqVol(address);
+		else if (address >= 0xE0) write(5, 0);
+		break;
+	case Mode::Compatible:
+		if      (address < 0x80) write(0, address);
+		else if (address < 0xA0) freqVol(address);
+		else if ((0xC0 <= address) && (address < 0xE0)) write(5, 0);
+		break;
+	case Mode::Plus:
+		if      (address < 0xA0) write(4, address);
+		else if (address < 0xC0) freqVol(address);
+		else if (address < 0xE0) write(5, 0);
+		break;
+	default:
+		UNREACHABLE;
+	}
+}
+
 float SCC::getAmplificationFactorImpl() const
 {
 	return 1.0f / 128.0f;
@@ -463,11 +506,34 @@ void SCC::setDeformRegHelper(uint8_t value)
 	}
 }
 
+bool SCC::isChannelSilent(unsigned channel) const
+{
+	return !(ch_enable & (1 << channel)) || (!volume[channel] && (out[channel] == 0.0f));
+}
+
+void SCC::skipChannel(unsigned channel, unsigned num)
+{
+	// Update phase counter.
+	unsigned newCount = count[channel] + num * incr[channel];
+	count[channel] = newCount % (period[channel] + 1);
+	pos[channel] = (pos[channel] + newCount / (period[channel] + 1)) % 32;
+	// Channel stays off until next waveform index.
+	out[channel] = 0.0f;
+}
+
+bool SCC::skipSilentChannels(unsigned num)
+{
+	if (!std::ranges::all_of(xrange(5), [&](unsigned i) { return isChannelSilent(i); })) {
+		return false;
+	}
+	for (auto i : xrange(5)) skipChannel(i, num);
+	return true;
+}
+
 void SCC::generateChannels(std::span<float*> bufs, unsigned num)
 {
-	unsigned enable = ch_enable;
-	for (unsigned i = 0; i < 5; ++i, enable >>= 1) {
-		if ((enable & 1) && (volume[i] || (out[i] != 0.0f))) {
+	for (auto i : xrange(5)) {
+		if (!isChannelSilent(i)) {
 			auto out2 = out[i];
 			unsigned count2 = count[i];
 			unsigned pos2 = pos[i];
@@ -489,12 +555,7 @@ void SCC::generateChannels(std::span<float*> bufs, unsigned num)
 			pos[i] = pos2;
 		} else {
 			bufs[i] = nullptr; // channel muted
-			// Update phase counter.
-			unsigned newCount = count[i] + num * incr[i];
-			count[i] = newCount % (period[i] + 1);
-			pos[i] = (pos[i] + newCount / (period[i] + 1)) % 32;
-			// Channel stays off until next waveform index.
-			out[i] = 0.0f;
+			skipChannel(i, num);
 		}
 	}
 }
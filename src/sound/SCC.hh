@@ -11,6 +11,8 @@
 
 namespace openmsx {
 
+class VGMRecorder;
+
 class SCC final : public ResampledSoundDevice
 {
 public:
@@ -38,6 +40,10 @@ private:
 	// SoundDevice
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
 	void generateChannels(std::span<float*> bufs, unsigned num) override;
+	[[nodiscard]] bool skipSilentChannels(unsigned num) override;
+
+	[[nodiscard]] bool isChannelSilent(unsigned channel) const;
+	void skipChannel(unsigned channel, unsigned num);
 
 	[[nodiscard]] uint8_t readWave(unsigned channel, unsigned address, EmuTime time) const;
 	void writeWave(unsigned channel, unsigned address, uint8_t value);
@@ -45,6 +51,7 @@ private:
 	void setDeformRegHelper(uint8_t value);
 	void setFreqVol(unsigned address, uint8_t value, EmuTime time);
 	[[nodiscard]] uint8_t getFreqVol(unsigned address) const;
+	void recordVGM(uint8_t address, uint8_t value, EmuTime time);
 
 private:
 	static constexpr int CLOCK_FREQ = 3579545;
@@ -55,6 +62,7 @@ private:
 		void write(unsigned address, uint8_t value, EmuTime time) override;
 	} debuggable;
 
+	VGMRecorder& vgmRecorder;
 	Clock<CLOCK_FREQ> deformTimer;
 	Mode currentMode;
 
@@ -19,6 +19,15 @@
 
 namespace openmsx {
 
+// The target latency (maximum number of queued samples) starts at 3
+// fragments, that was the (fixed) buffer size before it became adaptive. On
+// each buffer underrun it's increased by half a fragment. After ~10 seconds
+// without underruns it's decreased again by a quarter fragment.
+static constexpr unsigned INITIAL_LATENCY = 3; // in fragments
+static constexpr unsigned MIN_LATENCY = 2;
+static constexpr unsigned MAX_LATENCY = 8;
+static constexpr unsigned DECREASE_PERIOD = 10; // in seconds
+
 SDLSoundDriver::SDLSoundDriver(Reactor& reactor_,
                                unsigned wantedFreq, unsigned wantedSamples)
 	: reactor(reactor_)
@@ -41,7 +50,11 @@ SDLSoundDriver::SDLSoundDriver(Reactor& reactor_,
 	frequency = obtained.freq;
 	fragmentSize = obtained.samples;
 
-	mixBuffer.resize(3 * (obtained.size / sizeof(StereoFloat)) + 1);
+	auto deviceFragment = narrow<unsigned>(obtained.size / sizeof(StereoFloat));
+	minLatency = MIN_LATENCY * deviceFragment;
+	maxLatency = MAX_LATENCY * deviceFragment;
+	targetLatency = INITIAL_LATENCY * deviceFragment;
+	ringBuffer.emplace(maxLatency);
 	reInit();
 }
 
@@ -52,10 +65,10 @@ SDLSoundDriver::~SDLSoundDriver()
 
 void SDLSoundDriver::reInit()
 {
-	SDL_LockAudioDevice(deviceID);
-	readIdx  = 0;
-	writeIdx = 0;
-	SDL_UnlockAudioDevice(deviceID);
+	// Only called while the audio device is paused, so the audio thread
+	// is not active.
+	ringBuffer->clear();
+	started = false;
 }
 
 void SDLSoundDriver::mute()
@@ -93,81 +106,81 @@ void SDLSoundDriver::audioCallbackHelper(void* userdata, uint8_t* strm, int len)
 		                        len / (2 * sizeof(float))});
 }
 
-unsigned SDLSoundDriver::getBufferFilled() const
-{
-	int result = narrow_cast<int>(writeIdx - readIdx);
-	if (result < 0) result += narrow<int>(mixBuffer.size());
-	assert((0 <= result) && (narrow<unsigned>(result) < mixBuffer.size()));
-	return result;
-}
-
-unsigned SDLSoundDriver::getBufferFree() const
-{
-	// we can't distinguish completely filled from completely empty
-	// (in both cases readIx would be equal to writeIdx), so instead
-	// we define full as '(writeIdx + 1) == readIdx'.
-	auto result = narrow<unsigned>(mixBuffer.size() - 1 - getBufferFilled());
-	assert(narrow_cast<int>(result) >= 0);
-	assert(result < mixBuffer.size());
-	return result;
-}
-
 void SDLSoundDriver::audioCallback(std::span<StereoFloat> stream)
 {
-	auto len = stream.size();
-
-	size_t available = getBufferFilled();
-	if (auto num = std::min(len, available);
-	    (readIdx + num) < mixBuffer.size()) {
-		copy_to_range(mixBuffer.subspan(readIdx, num), stream);
-		readIdx += narrow<unsigned>(num);
-	} else {
-		auto len1 = mixBuffer.size() - readIdx;
-		copy_to_range(mixBuffer.subspan(readIdx, len1), stream);
-		auto len2 = num - len1;
-		copy_to_range(mixBuffer.first(len2), stream.subspan(len1));
-		readIdx = narrow<unsigned>(len2);
+	auto depth = ringBuffer->size();
+	auto num = ringBuffer->read(stream);
+	if (!started) {
+		// Don't count (or react on) the silence before the first data
+		// arrives after (re)starting the audio device.
+		if (num == 0) {
+			std::ranges::fill(stream, StereoFloat{});
+			return;
+		}
+		started = true;
 	}
-	auto missing = narrow_cast<ptrdiff_t>(len - available);
-	if (missing > 0) {
+	stats.callbacks.fetch_add(1, std::memory_order_relaxed);
+	stats.queueDepthSum.fetch_add(depth, std::memory_order_relaxed);
+
+	auto frag = narrow<unsigned>(stream.size());
+	auto target = targetLatency.load(std::memory_order_relaxed);
+	if (auto missing = stream.size() - num; missing > 0) {
 		// buffer underrun
-		std::ranges::fill(subspan(stream, available, missing), StereoFloat{});
+		std::ranges::fill(stream.subspan(num), StereoFloat{});
+		stats.underruns.fetch_add(1, std::memory_order_relaxed);
+		stats.underrunSamples.fetch_add(missing, std::memory_order_relaxed);
+		targetLatency.store(std::min(maxLatency, target + frag / 2), std::memory_order_relaxed);
+		callbacksSinceUnderrun = 0;
+	} else if (++callbacksSinceUnderrun >= DECREASE_PERIOD * frequency / frag) {
+		targetLatency.store(std::max(minLatency, target - std::min(target, frag / 4)), std::memory_order_relaxed);
+		callbacksSinceUnderrun = 0;
 	}
 }
 
 void SDLSoundDriver::uploadBuffer(std::span<const StereoFloat> buffer)
 {
-	SDL_LockAudioDevice(deviceID);
-	unsigned free = getBufferFree();
-	if (buffer.size() > free) {
-		auto* board = reactor.getMotherBoard();
-		if (board && !board->getMSXMixer().isSynchronousMode() && // when not recording
-		    reactor.getGlobalSettings().getThrottleManager().isThrottled()) {
-			do {
-				SDL_UnlockAudioDevice(deviceID);
-				Timer::sleep(5000); // 5ms
-				SDL_LockAudioDevice(deviceID);
-				board->getRealTime().resync();
-				free = getBufferFree();
-			} while (buffer.size() > free);
-		} else {
-			// drop excess samples
-			buffer = buffer.subspan(0, free);
-		}
-	}
-	assert(buffer.size() <= free);
-	if ((writeIdx + buffer.size()) < mixBuffer.size()) {
-		copy_to_range(buffer, mixBuffer.subspan(writeIdx));
-		writeIdx += narrow<unsigned>(buffer.size());
+	auto written = ringBuffer->write(buffer, targetLatency.load(std::memory_order_relaxed));
+	buffer = buffer.subspan(written);
+	if (buffer.empty()) return;
+
+	auto* board = reactor.getMotherBoard();
+	if (board && !board->getMSXMixer().isSynchronousMode() && // when not recording
+	    reactor.getGlobalSettings().getThrottleManager().isThrottled()) {
+		// wait till the audio device consumed enough samples (upload
+		// in pieces, the buffer can be larger than the target latency)
+		do {
+			Timer::sleep(5000); // 5ms
+			board->getRealTime().resync();
+			written = ringBuffer->write(buffer, targetLatency.load(std::memory_order_relaxed));
+			buffer = buffer.subspan(written);
+		} while (!buffer.empty());
 	} else {
-		auto len1 = mixBuffer.size() - writeIdx;
-		copy_to_range(buffer.subspan(0, len1), mixBuffer.subspan(writeIdx));
-		auto len2 = buffer.size() - len1;
-		copy_to_range(buffer.subspan(len1, len2), std::span{mixBuffer});
-		writeIdx = narrow<unsigned>(len2);
+		// drop excess samples
+		stats.overruns.fetch_add(1, std::memory_order_relaxed);
+		stats.droppedSamples.fetch_add(buffer.size(), std::memory_order_relaxed);
 	}
+}
 
-	SDL_UnlockAudioDevice(deviceID);
+SoundDriver::Stats SDLSoundDriver::getStats() const
+{
+	Stats result;
+	result.callbacks       = stats.callbacks.load(std::memory_order_relaxed);
+	result.underruns       = stats.underruns.load(std::memory_order_relaxed);
+	result.underrunSamples = stats.underrunSamples.load(std::memory_order_relaxed);
+	result.overruns        = stats.overruns.load(std::memory_order_relaxed);
+	result.droppedSamples  = stats.droppedSamples.load(std::memory_order_relaxed);
+	auto sum = stats.queueDepthSum.load(std::memory_order_relaxed);
+	result.meanQueueDepth  = result.callbacks ? double(sum) / double(result.callbacks) : 0.0;
+	result.targetLatency   = targetLatency.load(std::memory_order_relaxed);
+	return result;
+}
+
+void SDLSoundDriver::resetStats()
+{
+	for (auto* s : {&stats.callbacks, &stats.underruns, &stats.underrunSamples,
+	                &stats.overruns, &stats.droppedSamples, &stats.queueDepthSum}) {
+		s->store(0, std::memory_order_relaxed);
+	}
 }
 
 } // namespace openmsx
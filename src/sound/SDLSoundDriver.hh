@@ -5,10 +5,14 @@
 
 #include "SDLSurfacePtr.hh"
 
-#include "MemBuffer.hh"
+#include "SPSCRingBuffer.hh"
 
 #include <SDL.h>
 
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
 namespace openmsx {
 
 class Reactor;
@@ -31,20 +35,42 @@ public:
 
 	void uploadBuffer(std::span<const StereoFloat> buffer) override;
 
+	[[nodiscard]] Stats getStats() const override;
+	void resetStats() override;
+
 private:
 	void reInit();
-	[[nodiscard]] unsigned getBufferFilled() const;
-	[[nodiscard]] unsigned getBufferFree() const;
 	static void audioCallbackHelper(void* userdata, uint8_t* strm, int len);
 	void audioCallback(std::span<StereoFloat> stream);
 
 private:
 	Reactor& reactor;
 	SDL_AudioDeviceID deviceID;
-	MemBuffer<StereoFloat> mixBuffer;
 	unsigned frequency;
 	unsigned fragmentSize;
-	unsigned readIdx = 0, writeIdx = 0;
+
+	// Samples are passed from the emulation thread (producer) to the SDL
+	// audio thread (consumer) without locking.
+	std::optional<SPSCRingBuffer<StereoFloat>> ringBuffer;
+
+	// Adaptive target latency: the maximum number of queued samples, see
+	// audioCallback(). Written by the audio thread, read by the emulation
+	// thread.
+	std::atomic<unsigned> targetLatency;
+	unsigned minLatency;
+	unsigned maxLatency;
+	unsigned callbacksSinceUnderrun = 0; // only used by the audio thread
+	bool started = false; // only used by the audio thread, see reInit()
+
+	struct AtomicStats {
+		std::atomic<uint64_t> callbacks = 0;
+		std::atomic<uint64_t> underruns = 0;
+		std::atomic<uint64_t> underrunSamples = 0;
+		std::atomic<uint64_t> overruns = 0;
+		std::atomic<uint64_t> droppedSamples = 0;
+		std::atomic<uint64_t> queueDepthSum = 0;
+	} stats;
+
 	bool muted = true;
 	[[no_unique_address]] SDLSubSystemInitializer<SDL_INIT_AUDIO> audioInitializer;
 };
@@ -2,6 +2,7 @@
 
 #include "MSXMixer.hh"
 #include "Mixer.hh"
+#include "MixKernels.hh"
 
 #include "DeviceConfig.hh"
 #include "Filename.hh"
@@ -71,6 +72,11 @@ float SoundDevice::getAmplificationFactorImpl() const
 	return 1.0f / 32768.0f;
 }
 
+bool SoundDevice::skipSilentChannels(unsigned /*num*/)
+{
+	return false;
+}
+
 void SoundDevice::registerSound(const DeviceConfig& config)
 {
 	const auto& soundConfig = config.getChild("sound");
@@ -202,8 +208,7 @@ bool SoundDevice::mixChannels(float* dataOut, size_t samples)
 {
 	if (samples == 0) return true;
 	size_t outputStereo = isStereo() ? 2 : 1;
-
-	inplace_buffer<float*, MAX_CHANNELS> bufs(uninitialized_tag{}, numChannels);
+	++silenceStats.generated;
 
 	// TODO optimization: All channels with the same balance (according to
 	// channelBalance[]) could use the same buffer when balanceCenter is
@@ -214,6 +219,19 @@ bool SoundDevice::mixChannels(float* dataOut, size_t samples)
 		    || writer[channel]
 		    || !balanceCenter;
 	};
+
+	// Fast path: silent device. Only when the channels don't need to be
+	// kept separate (e.g. for recording), that's the common case anyway.
+	if (std::ranges::none_of(xrange(numChannels), needSeparateBuffer) &&
+	    skipSilentChannels(narrow<unsigned>(samples))) {
+		++silenceStats.skipped;
+		for (auto& cb : std::span{channelBuffers}.first(numChannels)) {
+			cb.stopIdx = 0; // no valid last data
+		}
+		return false;
+	}
+
+	inplace_buffer<float*, MAX_CHANNELS> bufs(uninitialized_tag{}, numChannels);
 	bool anySeparateChannel = false;
 	auto size = narrow<unsigned>(samples * stereo);
 	auto padded = (size + 3) & ~3; // round up to multiple of 4
@@ -298,13 +316,14 @@ bool SoundDevice::mixChannels(float* dataOut, size_t samples)
 	// remove muted channels (explicitly by user or by device itself)
 	bool anyUnmuted = false;
 	unsigned numMix = 0;
-	inplace_buffer<Balance, MAX_CHANNELS> mixBalance(uninitialized_tag{}, numChannels);
+	inplace_buffer<float, 2 * MAX_CHANNELS> mixBalance(uninitialized_tag{}, 2 * numChannels);
 	for (auto i : xrange(numChannels)) {
 		if (bufs[i] && !channelMuted[i]) {
 			anyUnmuted = true;
 			if (bufs[i] != dataOut) {
 				bufs[numMix] = bufs[i];
-				mixBalance[numMix] = channelBalance[i];
+				mixBalance[2 * numMix + 0] = channelBalance[i].left;
+				mixBalance[2 * numMix + 1] = channelBalance[i].right;
 				++numMix;
 			}
 		}
@@ -316,57 +335,14 @@ bool SoundDevice::mixChannels(float* dataOut, size_t samples)
 	}
 
 	// actually mix channels
+	const auto& kernels = MixKernels::get();
 	if (!balanceCenter) {
-		size_t i = 0;
-		do {
-			float left0  = 0.0f;
-			float right0 = 0.0f;
-			float left1  = 0.0f;
-			float right1 = 0.0f;
-			unsigned j = 0;
-			do {
-				left0  += bufs[j][i + 0] * mixBalance[j].left;
-				left1  += bufs[j][i + 1] * mixBalance[j].left;
-				right0 += bufs[j][i + 0] * mixBalance[j].right;
-				right1 += bufs[j][i + 1] * mixBalance[j].right;
-				j++;
-			} while (j < numMix);
-			dataOut[i * 2 + 0] = left0;
-			dataOut[i * 2 + 1] = right0;
-			dataOut[i * 2 + 2] = left1;
-			dataOut[i * 2 + 3] = right1;
-			i += 2;
-		} while (i < samples);
-
-		return true;
+		kernels.mixBalance(dataOut, bufs.data(), mixBalance.data(), numMix, samples);
+	} else {
+		// Currently this is only rarely used anymore (only when
+		// recording or muting individual sound chip channels).
+		kernels.sumChannels(dataOut, bufs.data(), numMix, samples * stereo);
 	}
-
-	// In the past we had ARM and x86-SSE2 optimized assembly routines for
-	// the stuff below. Currently this code is only rarely used anymore
-	// (only when recording or muting individual sound chip channels), so
-	// it's not worth the extra complexity anymore.
-	size_t num = samples * stereo;
-	size_t i = 0;
-	do {
-		auto out0 = dataOut[i + 0];
-		auto out1 = dataOut[i + 1];
-		auto out2 = dataOut[i + 2];
-		auto out3 = dataOut[i + 3];
-		unsigned j = 0;
-		do {
-			out0 += bufs[j][i + 0];
-			out1 += bufs[j][i + 1];
-			out2 += bufs[j][i + 2];
-			out3 += bufs[j][i + 3];
-			++j;
-		} while (j < numMix);
-		dataOut[i + 0] = out0;
-		dataOut[i + 1] = out1;
-		dataOut[i + 2] = out2;
-		dataOut[i + 3] = out3;
-		i += 4;
-	} while (i < num);
-
 	return true;
 }
 
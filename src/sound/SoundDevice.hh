@@ -6,6 +6,7 @@
 #include "static_string_view.hh"
 
 #include <array>
+#include <cstdint>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -132,6 +133,18 @@ public:
 		return getLastMonoBufferSize() * stereo;
 	}
 
+	/** Counters that show how often the fast path for silent devices was
+	  * taken (see skipSilentChannels()). Each counter counts sound
+	  * fragments (calls), not samples.
+	  */
+	struct SilenceStats {
+		uint64_t generated = 0; // calls to mixChannels()
+		uint64_t skipped = 0; // ... of which synthesis was skipped
+		uint64_t resampleSkipped = 0; // calls where resampling was skipped
+	};
+	[[nodiscard]] const SilenceStats& getSilenceStats() const { return silenceStats; }
+	void countResampleSkipped() { ++silenceStats.resampleSkipped; }
+
 protected:
 	/** Constructor.
 	  * @param mixer The Mixer object
@@ -183,6 +196,14 @@ public: // Will be called by Mixer:
 	 */
 	virtual void setOutputRate(unsigned hostSampleRate, double speed) = 0;
 
+	/** Does the emulated state (visible to the MSX) depend on generating
+	  * the sound of this device? For example the VLM5030 only updates its
+	  * BSY pin while generating samples. The mixer keeps generating (and
+	  * then discards) the output of such devices while seeking, see
+	  * MSXMixer::setSeeking(). The default implementation returns false.
+	  */
+	[[nodiscard]] virtual bool needsGenerateWhileSeeking() const { return false; }
+
 	/** Generate sample data
 	  * @param length The number of required samples
 	  * @param buffer This buffer should be filled
@@ -230,6 +251,20 @@ protected:
 	  */
 	virtual void generateChannels(std::span<float*> buffers, unsigned num) = 0;
 
+	/** Fast path for devices that are silent.
+	  * If the device can guarantee that all its channels only produce
+	  * silence during the next 'num' samples (e.g. all volumes are zero or
+	  * all keys are off), it should advance its internal state by 'num'
+	  * samples (without synthesizing them) and return true. Otherwise it
+	  * must return false without changing any state, generateChannels()
+	  * is then called as usual.
+	  * Returning true has the same effect as setting all buffer pointers
+	  * to nullptr in generateChannels(), but it also allows to skip the
+	  * mixing (and possibly the resampling) of the channels.
+	  * The default implementation always returns false.
+	  */
+	[[nodiscard]] virtual bool skipSilentChannels(unsigned num);
+
 	/** Calls generateChannels() and combines the output to a single
 	  * channel.
 	  * @param dataOut Output buffer, must be big enough to hold
@@ -268,6 +303,7 @@ private:
 	std::array<Balance,  MAX_CHANNELS> channelBalance;
 	std::array<bool, MAX_CHANNELS> channelMuted;
 	bool balanceCenter = true;
+	SilenceStats silenceStats;
 
 	// When channel data needs to be collected separately (e.g. because
 	// we're recording the channel, or because we want to present it in the
@@ -2,6 +2,8 @@
 #define SOUNDDRIVER_HH
 
 #include "Mixer.hh"
+
+#include <cstdint>
 #include <span>
 
 namespace openmsx {
@@ -31,6 +33,22 @@ public:
 
 	virtual void uploadBuffer(std::span<const StereoFloat> buffer) = 0;
 
+	/** Statistics about the buffer between the emulation and the audio
+	  * device, see the 'sound_driver_stats' command. Sample counts are in
+	  * (stereo) samples.
+	  */
+	struct Stats {
+		uint64_t callbacks = 0; // number of times the device requested data
+		uint64_t underruns = 0; // ... of which not enough data was available
+		uint64_t underrunSamples = 0; // total number of missing samples
+		uint64_t overruns = 0; // uploads that didn't (completely) fit
+		uint64_t droppedSamples = 0; // total number of samples that didn't fit
+		double meanQueueDepth = 0.0; // at the start of each callback
+		unsigned targetLatency = 0; // current maximum queue depth
+	};
+	[[nodiscard]] virtual Stats getStats() const { return {}; }
+	virtual void resetStats() {}
+
 protected:
 	SoundDriver() = default;
 };
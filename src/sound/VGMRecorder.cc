@@ -0,0 +1,344 @@
+#include "VGMRecorder.hh"
+
+#include "CommandException.hh"
+#include "FileContext.hh"
+#include "FileOperations.hh"
+#include "MSXCliComm.hh"
+#include "MSXException.hh"
+#include "MSXMotherBoard.hh"
+#include "TclObject.hh"
+#include "TrackedRam.hh"
+
+#include "StringOp.hh"
+#include "endian.hh"
+#include "join.hh"
+#include "narrow.hh"
+#include "outer.hh"
+#include "unreachable.hh"
+#include "xrange.hh"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <string_view>
+
+namespace openmsx {
+
+using namespace std::literals;
+
+static constexpr unsigned SAMPLE_RATE = 44100; // fixed by the VGM format
+static constexpr size_t HEADER_SIZE = 0x100;
+static constexpr size_t FLUSH_SIZE = 64 * 1024;
+
+// Names used in the 'vgm_recorder start' command (the same as in the old
+// Tcl script), in the order of the Chip enum.
+static constexpr std::array<std::string_view, size_t(VGMRecorder::Chip::NUM)> chipNames = {
+	"PSG", "MSX-Music", "SFG", "MSX-Audio", "MoonSound", "OPL3", "SCC",
+};
+
+VGMRecorder::VGMRecorder(MSXMotherBoard& motherBoard_)
+	: motherBoard(motherBoard_)
+	, cmd(motherBoard.getCommandController())
+{
+}
+
+VGMRecorder::~VGMRecorder()
+{
+	if (chips) {
+		try {
+			stop();
+		} catch (MSXException&) {
+			// ignore, can't throw from destructor
+		}
+	}
+	assert(sampleRams.empty());
+}
+
+void VGMRecorder::registerSampleRam(Chip chip, const TrackedRam& ram)
+{
+	sampleRams.emplace_back(chip, &ram);
+}
+
+void VGMRecorder::unregisterSampleRam(const TrackedRam& ram)
+{
+	std::erase_if(sampleRams, [&](const auto& p) { return p.second == &ram; });
+}
+
+void VGMRecorder::start(std::string filename_, unsigned chipMask)
+{
+	assert(!chips);
+	assert(chipMask);
+	file.emplace(filename_, "wb");
+	filename = std::move(filename_);
+
+	// the header is only written when the recording stops
+	std::array<uint8_t, HEADER_SIZE> header = {};
+	file->write(header);
+
+	buffer.clear();
+	dataSize = 0;
+	ticks = 0;
+	numWrites = 0;
+	sccPlusUsed = false;
+
+	// Store the content of the sample memory. Like the VGM specification,
+	// only support this for the first chip of each type.
+	auto storeRam = [&](Chip chip, uint8_t type) {
+		if (!(chipMask & (1 << unsigned(chip)))) return;
+		auto it = std::ranges::find(sampleRams, chip, &std::pair<Chip, const TrackedRam*>::first);
+		if (it == sampleRams.end()) return;
+		const auto& ram = *it->second;
+		auto size = narrow<uint32_t>(ram.size());
+		if (size == 0) return;
+		buffer.insert(buffer.end(), {0x67, 0x66, type});
+		for (uint32_t v : {size + 8, size, uint32_t(0)}) { // block size, ROM size, start address
+			Endian::L32 l(v);
+			auto* p = reinterpret_cast<const uint8_t*>(&l);
+			buffer.insert(buffer.end(), p, p + 4);
+		}
+		buffer.insert(buffer.end(), ram.begin(), ram.end());
+	};
+	storeRam(Chip::Y8950,   0x88);
+	storeRam(Chip::YMF278B, 0x87);
+	if (chipMask & (1 << unsigned(Chip::YMF278B))) {
+		// enable OPL3 and OPL4 mode, in case the software already did
+		// that before the recording started
+		buffer.insert(buffer.end(), {0xD0, 0x01, 0x05, 0x03});
+	}
+
+	chips = chipMask;
+}
+
+void VGMRecorder::stop()
+{
+	assert(chips);
+	if (numWrites) writeWait(lastWrite);
+	buffer.push_back(0x66); // end of sound data
+	try {
+		flushBuffer();
+		writeHeader();
+	} catch (MSXException& e) {
+		// don't leave a truncated file (with a bogus header) behind
+		abort();
+		throw MSXException("VGM recording aborted, error while writing: ",
+		                   e.getMessage());
+	}
+	file.reset();
+	chips = 0;
+}
+
+void VGMRecorder::abort()
+{
+	assert(chips);
+	file.reset();
+	FileOperations::unlink(filename);
+	chips = 0;
+}
+
+void VGMRecorder::status(TclObject& result) const
+{
+	TclObject chipList;
+	for (auto i : xrange(size_t(Chip::NUM))) {
+		if (chips & (1 << i)) chipList.addListElement(chipNames[i]);
+	}
+	result.addDictKeyValues("recording", chips != 0,
+	                        "filename", filename,
+	                        "chips", chipList,
+	                        "writes", numWrites,
+	                        "start_time", startTime.toDouble(),
+	                        "last_write", lastWrite.toDouble());
+}
+
+void VGMRecorder::insertMarker()
+{
+	assert(chips);
+	if (numWrites == 0) return; // recording didn't start yet
+	// A (useless) Pokey write, this is easy to find back with the VGM
+	// tools, e.g. to mark the loop point of a song.
+	buffer.insert(buffer.end(), {0xBB, 0xBB, 0xBB});
+}
+
+void VGMRecorder::write(Chip chip, uint8_t port, uint8_t reg, uint8_t value, EmuTime time)
+{
+	assert(isRecording(chip));
+	if (numWrites++ == 0) {
+		// Only start counting time at the first write, this avoids
+		// silence at the start of the recording.
+		startTime = time;
+		motherBoard.getMSXCliComm().printInfo(
+			"VGM recording started, data was written to one of the "
+			"sound chips recording for.");
+	}
+	lastWrite = time;
+	writeWait(time);
+
+	switch (chip) {
+	case Chip::AY8910:  buffer.insert(buffer.end(), {0xA0, reg, value}); break;
+	case Chip::YM2413:  buffer.insert(buffer.end(), {0x51, reg, value}); break;
+	case Chip::YM2151:  buffer.insert(buffer.end(), {0x54, reg, value}); break;
+	case Chip::Y8950:   buffer.insert(buffer.end(), {0x5C, reg, value}); break;
+	case Chip::YMF262:
+		assert(port < 2);
+		buffer.insert(buffer.end(), {uint8_t(0x5E + port), reg, value});
+		break;
+	case Chip::YMF278B: buffer.insert(buffer.end(), {0xD0, port, reg, value}); break;
+	case Chip::SCC:
+		if (port == 4) sccPlusUsed = true;
+		buffer.insert(buffer.end(), {0xD2, port, reg, value});
+		break;
+	default:
+		UNREACHABLE;
+	}
+
+	if (buffer.size() >= FLUSH_SIZE) [[unlikely]] {
+		try {
+			flushBuffer();
+		} catch (MSXException& e) {
+			// don't let the sound chip emulation fail
+			// don't leave a truncated file (with a bogus header) behind
+			abort();
+			motherBoard.getMSXCliComm().printWarning(
+				"VGM recording aborted, error while writing: ", e.getMessage(),
+				". The partially written file '", filename, "' was deleted.");
+		}
+	}
+}
+
+void VGMRecorder::writeWait(EmuTime time)
+{
+	// Time can go backwards, e.g. after 'reverse goback'. Then simply
+	// don't wait.
+	if (time < startTime) return;
+	auto newTicks = (time - startTime).getTicksAt(SAMPLE_RATE);
+	while (ticks < newTicks) {
+		auto step = std::min(newTicks - ticks, 0xFFFFu);
+		if (step <= 16) {
+			buffer.push_back(uint8_t(0x70 + step - 1));
+		} else {
+			buffer.insert(buffer.end(), {0x61, uint8_t(step & 0xFF), uint8_t(step >> 8)});
+		}
+		ticks += step;
+	}
+}
+
+void VGMRecorder::flushBuffer()
+{
+	file->write(std::span{buffer});
+	dataSize += buffer.size();
+	buffer.clear();
+}
+
+void VGMRecorder::writeHeader()
+{
+	// Version 1.61, fields are indexed by their offset.
+	std::array<Endian::L32, HEADER_SIZE / 4> header = {};
+	auto set = [&](unsigned offset, uint32_t value) { header[offset / 4] = value; };
+	auto clock = [&](Chip chip, unsigned offset, uint32_t freq) {
+		if (chips & (1 << unsigned(chip))) set(offset, freq);
+	};
+	header[0] = 0x206D6756; // "Vgm " in little endian
+	set(0x04, narrow<uint32_t>(HEADER_SIZE + dataSize - 4)); // EOF offset
+	set(0x08, 0x161); // version
+	set(0x18, ticks); // total number of samples
+	set(0x34, narrow<uint32_t>(HEADER_SIZE - 0x34)); // data offset
+	clock(Chip::YM2413,  0x10,  3579545);
+	clock(Chip::YM2151,  0x30,  3579545);
+	clock(Chip::Y8950,   0x58,  3579545);
+	clock(Chip::YMF262,  0x5C, 14318182);
+	clock(Chip::YMF278B, 0x60, 33868800);
+	clock(Chip::AY8910,  0x74,  1789773);
+	// bit 31 selects the SCC+ (K052539) instead of the SCC (K051649)
+	clock(Chip::SCC,     0x9C,  1789773 | (sccPlusUsed ? 0x8000'0000 : 0));
+
+	file->seek(0);
+	file->write(std::span{header.data(), header.size()});
+}
+
+
+// class VGMRecorder::Cmd
+
+VGMRecorder::Cmd::Cmd(CommandController& controller)
+	: Command(controller, "vgm_recorder")
+{
+}
+
+void VGMRecorder::Cmd::execute(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	auto& recorder = OUTER(VGMRecorder, cmd);
+	auto checkRecording = [&](bool expected) {
+		if ((recorder.chips != 0) != expected) {
+			throw CommandException(expected ? "Not recording."
+			                                : "Already recording.");
+		}
+	};
+	executeSubCommand(tokens[1].getString(),
+		"start", [&]{
+			checkNumArgs(tokens, AtLeast{4}, Prefix{2}, "filename chip ?chip ...?");
+			checkRecording(false);
+			unsigned mask = 0;
+			for (const auto& t : tokens.subspan(3)) {
+				auto name = t.getString();
+				auto it = std::ranges::find_if(chipNames, [&](auto n) {
+					return StringOp::casecmp()(n, name);
+				});
+				if (it == chipNames.end()) {
+					throw CommandException(
+						"Unknown sound chip '", name, "', must be one of: ",
+						join(chipNames, ", "), '.');
+				}
+				mask |= 1 << (it - chipNames.begin());
+			}
+			recorder.start(FileOperations::expandTilde(std::string(tokens[2].getString())), mask);
+		},
+		"stop", [&]{
+			checkNumArgs(tokens, 2, "");
+			checkRecording(true);
+			recorder.stop();
+			result = recorder.filename;
+		},
+		"abort", [&]{
+			checkNumArgs(tokens, 2, "");
+			checkRecording(true);
+			recorder.abort();
+		},
+		"marker", [&]{
+			checkNumArgs(tokens, 2, "");
+			checkRecording(true);
+			recorder.insertMarker();
+		},
+		"status", [&]{
+			checkNumArgs(tokens, 2, "");
+			recorder.status(result);
+		});
+}
+
+std::string VGMRecorder::Cmd::help(std::span<const TclObject> /*tokens*/) const
+{
+	return "Low level interface to record the sound chip register writes to a VGM file,\n"
+	       "normally the 'vgm_rec' command is used instead.\n"
+	       "  vgm_recorder start <filename> <chip> ...   start recording, chip is one of\n"
+	       "                                             PSG, MSX-Music, SFG, MSX-Audio,\n"
+	       "                                             MoonSound, OPL3, SCC\n"
+	       "  vgm_recorder stop                          stop and write the file\n"
+	       "  vgm_recorder abort                         stop without writing a file\n"
+	       "  vgm_recorder marker                        insert a marker (e.g. loop point)\n"
+	       "  vgm_recorder status                        returns a dict with status info\n"
+	       "Time only starts counting at the first write to one of the recorded chips.\n";
+}
+
+void VGMRecorder::Cmd::tabCompletion(std::vector<std::string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static constexpr std::array subCommands = {
+			"start"sv, "stop"sv, "abort"sv, "marker"sv, "status"sv,
+		};
+		completeString(tokens, subCommands);
+	} else if ((tokens.size() == 3) && (tokens[1] == "start")) {
+		completeFileName(tokens, userFileContext());
+	} else if ((tokens.size() > 3) && (tokens[1] == "start")) {
+		completeString(tokens, chipNames, false); // case insensitive
+	}
+}
+
+} // namespace openmsx
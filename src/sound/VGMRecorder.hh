@@ -0,0 +1,107 @@
+#ifndef VGMRECORDER_HH
+#define VGMRECORDER_HH
+
+#include "Command.hh"
+#include "EmuTime.hh"
+#include "File.hh"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace openmsx {
+
+class MSXMotherBoard;
+class TrackedRam;
+
+/** Records the register writes of the sound chips of a machine to a VGM file.
+  *
+  * The sound chips report their register writes directly (no watchpoints, no
+  * Tcl callbacks). When not recording (or not recording that type of chip),
+  * this costs a single test in the register write path of the chip. All
+  * instances of the same type of chip are recorded as a single chip.
+  *
+  * The 'vgm_rec' script (share/scripts/_vgmrecorder.tcl) offers the user
+  * interface on top of this.
+  */
+class VGMRecorder
+{
+public:
+	enum class Chip : uint8_t {
+		AY8910,  // PSG
+		YM2413,  // MSX-MUSIC
+		YM2151,  // SFG
+		Y8950,   // MSX-AUDIO
+		YMF278B, // MoonSound, both the FM (YMF262) and the wave part
+		YMF262,  // OPL3, when not part of a MoonSound
+		SCC,
+		NUM
+	};
+
+	explicit VGMRecorder(MSXMotherBoard& motherBoard);
+	VGMRecorder(const VGMRecorder&) = delete;
+	VGMRecorder(VGMRecorder&&) = delete;
+	VGMRecorder& operator=(const VGMRecorder&) = delete;
+	VGMRecorder& operator=(VGMRecorder&&) = delete;
+	~VGMRecorder();
+
+	[[nodiscard]] bool isRecording(Chip chip) const {
+		return (chips >> unsigned(chip)) & 1;
+	}
+
+	/** Record a register write. Only call this when isRecording(chip).
+	  * The meaning of 'port' depends on the chip (see VGM specification):
+	  *  - YMF262:  register set (0 or 1)
+	  *  - YMF278B: 0/1 FM register set, 2 wave part
+	  *  - SCC:     0 waveform, 1 frequency, 2 volume, 3 key on/off,
+	  *             4 waveform (SCC+), 5 deformation register
+	  *  - other chips: ignored, should be 0
+	  */
+	void write(Chip chip, uint8_t port, uint8_t reg, uint8_t value, EmuTime time);
+
+	/** Chips that have sample memory register it, so that its content
+	  * can be stored at the start of a recording.
+	  */
+	void registerSampleRam(Chip chip, const TrackedRam& ram);
+	void unregisterSampleRam(const TrackedRam& ram);
+
+private:
+	void start(std::string filename, unsigned chipMask);
+	void stop();
+	void abort();
+	void status(TclObject& result) const;
+	void insertMarker();
+
+	void writeWait(EmuTime time);
+	void writeHeader();
+	void flushBuffer();
+
+private:
+	MSXMotherBoard& motherBoard;
+
+	struct Cmd final : Command {
+		explicit Cmd(CommandController& controller);
+		void execute(std::span<const TclObject> tokens, TclObject& result) override;
+		[[nodiscard]] std::string help(std::span<const TclObject> tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} cmd;
+
+	std::vector<std::pair<Chip, const TrackedRam*>> sampleRams;
+
+	std::optional<File> file;
+	std::string filename;
+	std::vector<uint8_t> buffer; // not yet written VGM commands
+	size_t dataSize = 0; // size of the VGM commands (both written and buffered)
+	EmuTime startTime = EmuTime::zero(); // time of the first write
+	EmuTime lastWrite = EmuTime::zero();
+	uint32_t ticks = 0; // in 44100Hz samples, since startTime
+	unsigned chips = 0; // bitmask (1 << Chip), only non-zero while recording
+	unsigned numWrites = 0;
+	bool sccPlusUsed = false;
+};
+
+} // namespace openmsx
+
+#endif
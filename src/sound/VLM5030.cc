@@ -224,6 +224,12 @@ int VLM5030::parseFrame()
 	return FR_SIZE;
 }
 
+bool VLM5030::skipSilentChannels(unsigned /*num*/)
+{
+	// When idle there's no state to advance (see generateChannels()).
+	return phase == Phase::IDLE;
+}
+
 // decode and buffering data
 void VLM5030::generateChannels(std::span<float*> bufs, unsigned num)
 {
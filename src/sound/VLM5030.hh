@@ -52,6 +52,8 @@ private:
 
 	// SoundDevice
 	void generateChannels(std::span<float*> bufs, unsigned num) override;
+	[[nodiscard]] bool needsGenerateWhileSeeking() const override { return true; }
+	[[nodiscard]] bool skipSilentChannels(unsigned num) override;
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
 
 	void setupParameter(uint8_t param);
@@ -11,6 +11,7 @@
 
 #include "DeviceConfig.hh"
 #include "MSXMotherBoard.hh"
+#include "VGMRecorder.hh"
 
 #include "Math.hh"
 #include "cstd.hh"
@@ -488,6 +489,7 @@ Y8950::Y8950(const std::string& name_, const DeviceConfig& config,
              unsigned sampleRam, EmuTime time, MSXAudio& audio)
 	: ResampledSoundDevice(config.getMotherBoard(), name_, "MSX-AUDIO", 9 + 5 + 1, INPUT_RATE, false)
 	, motherBoard(config.getMotherBoard())
+	, vgmRecorder(motherBoard.getVGMRecorder())
 	, periphery(audio.createPeriphery(getName()))
 	, adpcm(*this, config, name_, sampleRam)
 	, connector(motherBoard.getPluggingController())
@@ -811,6 +813,13 @@ bool Y8950::checkMuteHelper()
 	return adpcm.isMuted();
 }
 
+bool Y8950::skipSilentChannels(unsigned /*num*/)
+{
+	// Same as the muted case in generateChannels(), also there the
+	// internal state isn't updated.
+	return checkMuteHelper();
+}
+
 void Y8950::generateChannels(std::span<float*> bufs, unsigned num)
 {
 	// TODO implement per-channel mute (instead of all-or-nothing)
@@ -914,6 +923,10 @@ void Y8950::writeReg(uint8_t rg, uint8_t data, EmuTime time)
 		-1, -1, -1, -1, -1, -1, -1, -1
 	};
 
+	if (vgmRecorder.isRecording(VGMRecorder::Chip::Y8950)) [[unlikely]] {
+		vgmRecorder.write(VGMRecorder::Chip::Y8950, 0, rg, data, time);
+	}
+
 	// TODO only for registers that influence sound
 	// TODO also ADPCM
 	//if (rg >= 0x20) {
@@ -23,6 +23,7 @@ namespace openmsx {
 class MSXAudio;
 class DeviceConfig;
 class Y8950Periphery;
+class VGMRecorder;
 
 class Y8950 final : private ResampledSoundDevice, private EmuTimerCallback
 {
@@ -80,6 +81,7 @@ private:
 	// SoundDevice
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
 	void generateChannels(std::span<float*> bufs, unsigned num) override;
+	[[nodiscard]] bool skipSilentChannels(unsigned num) override;
 
 	void keyOn_BD();
 	void keyOn_SD();
@@ -204,6 +206,7 @@ private:
 	};
 
 	MSXMotherBoard& motherBoard;
+	VGMRecorder& vgmRecorder;
 	Y8950Periphery& periphery;
 	Y8950Adpcm adpcm;
 	Y8950KeyboardConnector connector;
@@ -15,6 +15,7 @@
 #include "Clock.hh"
 #include "DeviceConfig.hh"
 #include "MSXMotherBoard.hh"
+#include "VGMRecorder.hh"
 #include "serialize.hh"
 
 #include "Math.hh"
@@ -54,10 +55,17 @@ Y8950Adpcm::Y8950Adpcm(Y8950& y8950_, const DeviceConfig& config,
                        const std::string& name, unsigned sampleRam)
 	: Schedulable(config.getScheduler())
 	, y8950(y8950_)
+	, vgmRecorder(config.getMotherBoard().getVGMRecorder())
 	, ram(config, name + " RAM", "Y8950 sample RAM", sampleRam)
 	, clock(config.getMotherBoard().getCurrentTime())
 {
 	clearRam();
+	vgmRecorder.registerSampleRam(VGMRecorder::Chip::Y8950, ram);
+}
+
+Y8950Adpcm::~Y8950Adpcm()
+{
+	vgmRecorder.unregisterSampleRam(ram);
 }
 
 void Y8950Adpcm::clearRam()
@@ -11,6 +11,7 @@
 namespace openmsx {
 
 class DeviceConfig;
+class VGMRecorder;
 class Y8950;
 
 class Y8950Adpcm final : public Schedulable
@@ -18,6 +19,7 @@ class Y8950Adpcm final : public Schedulable
 public:
 	Y8950Adpcm(Y8950& y8950, const DeviceConfig& config,
 	           const std::string& name, unsigned sampleRam);
+	~Y8950Adpcm();
 
 	void clearRam();
 	void reset(EmuTime time);
@@ -62,6 +64,7 @@ private:
 
 private:
 	Y8950& y8950;
+	VGMRecorder& vgmRecorder;
 	TrackedRam ram;
 
 	// copy/pasted from Y8950.hh
@@ -7,6 +7,8 @@
 #include "YM2151.hh"
 
 #include "DeviceConfig.hh"
+#include "MSXMotherBoard.hh"
+#include "VGMRecorder.hh"
 #include "serialize.hh"
 
 #include "Math.hh"
@@ -651,6 +653,9 @@ void YM2151::refreshEG(std::span<YM2151Operator, 4> op)
 
 void YM2151::writeReg(uint8_t r, uint8_t v, EmuTime time)
 {
+	if (vgmRecorder.isRecording(VGMRecorder::Chip::YM2151)) [[unlikely]] {
+		vgmRecorder.write(VGMRecorder::Chip::YM2151, 0, r, v, time);
+	}
 	updateStream(time);
 
 	YM2151Operator& op = oper[(r & 0x07) * 4 + ((r & 0x18) >> 3)];
@@ -876,6 +881,7 @@ YM2151::YM2151(const std::string& name_, static_string_view desc,
                const DeviceConfig& config, EmuTime time, Variant variant_)
 	: ResampledSoundDevice(config.getMotherBoard(), name_, desc, 8, INPUT_RATE, true)
 	, irq(config.getMotherBoard(), getName() + ".IRQ")
+	, vgmRecorder(config.getMotherBoard().getVGMRecorder())
 	, timer1(EmuTimer::createOPM_1(config.getScheduler(), *this))
 	, timer2(variant_ == Variant::YM2164 ? EmuTimer::createOPP_2(config.getScheduler(), *this)
 					     : EmuTimer::createOPM_2(config.getScheduler(), *this))
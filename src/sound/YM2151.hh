@@ -48,6 +48,7 @@
 namespace openmsx {
 
 class DeviceConfig;
+class VGMRecorder;
 
 class YM2151 final : public ResampledSoundDevice, private EmuTimerCallback
 {
@@ -153,6 +154,7 @@ private:
 	[[nodiscard]] bool checkMuteHelper();
 
 	IRQHelper irq;
+	VGMRecorder& vgmRecorder;
 
 	// Timers (see EmuTimer class for details about timing)
 	const std::unique_ptr<EmuTimer> timer1;
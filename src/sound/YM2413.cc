@@ -7,6 +7,8 @@
 
 #include "DeviceConfig.hh"
 #include "MSXException.hh"
+#include "MSXMotherBoard.hh"
+#include "VGMRecorder.hh"
 #include "serialize.hh"
 
 #include "cstd.hh"
@@ -70,6 +72,7 @@ static constexpr auto INPUT_RATE = unsigned(cstd::round(YM2413Core::CLOCK_FREQ /
 YM2413::YM2413(const std::string& name_, const DeviceConfig& config)
 	: ResampledSoundDevice(config.getMotherBoard(), name_, "MSX-MUSIC", 9 + 5, INPUT_RATE, false)
 	, core(createCore(config))
+	, vgmRecorder(config.getMotherBoard().getVGMRecorder())
 	, debuggable(config.getMotherBoard(), getName())
 {
 	registerSound(config);
@@ -88,6 +91,13 @@ void YM2413::reset(EmuTime time)
 
 void YM2413::writePort(bool port, uint8_t value, EmuTime time)
 {
+	if (!port) {
+		// Also when not recording, a recording can start in between
+		// the address and the data write.
+		vgmRegister = value;
+	} else if (vgmRecorder.isRecording(VGMRecorder::Chip::YM2413)) [[unlikely]] {
+		vgmRecorder.write(VGMRecorder::Chip::YM2413, 0, vgmRegister, value, time);
+	}
 	updateStream(time);
 
 	auto [integral, fractional] = getEmuClock().getTicksTillAsIntFloat(time);
@@ -101,6 +111,9 @@ void YM2413::writePort(bool port, uint8_t value, EmuTime time)
 
 void YM2413::pokeReg(uint8_t reg, uint8_t value, EmuTime time)
 {
+	if (vgmRecorder.isRecording(VGMRecorder::Chip::YM2413)) [[unlikely]] {
+		vgmRecorder.write(VGMRecorder::Chip::YM2413, 0, reg, value, time);
+	}
 	updateStream(time);
 	core->pokeReg(reg, value);
 }
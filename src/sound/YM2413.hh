@@ -13,6 +13,7 @@
 
 namespace openmsx {
 
+class VGMRecorder;
 class YM2413Core;
 
 class YM2413 final : public ResampledSoundDevice
@@ -37,6 +38,8 @@ private:
 
 private:
 	const std::unique_ptr<YM2413Core> core;
+	VGMRecorder& vgmRecorder;
+	uint8_t vgmRegister = 0; // last written address, for VGM recording
 
 	struct Debuggable final : SimpleDebuggable {
 		Debuggable(MSXMotherBoard& motherBoard, const std::string& name);
@@ -41,6 +41,7 @@
 
 #include "DeviceConfig.hh"
 #include "MSXMotherBoard.hh"
+#include "VGMRecorder.hh"
 #include "serialize.hh"
 
 #include "Math.hh"
@@ -1043,6 +1044,11 @@ void YMF262::writeReg(unsigned r, uint8_t v, EmuTime time)
 }
 void YMF262::writeReg512(unsigned r, uint8_t v, EmuTime time)
 {
+	// In a MoonSound, this is the FM part of the YMF278B.
+	if (auto chip = isYMF278 ? VGMRecorder::Chip::YMF278B : VGMRecorder::Chip::YMF262;
+	    vgmRecorder.isRecording(chip)) [[unlikely]] {
+		vgmRecorder.write(chip, uint8_t(r >> 8), uint8_t(r & 0xFF), v, time);
+	}
 	updateStream(time); // TODO optimize only for regs that directly influence sound
 	writeRegDirect(r, v, time);
 }
@@ -1448,6 +1454,7 @@ YMF262::YMF262(const std::string& name_,
 	         ? EmuTimer::createOPL4_2(config.getScheduler(), *this)
 	         : EmuTimer::createOPL3_2(config.getScheduler(), *this))
 	, irq(config.getMotherBoard(), getName() + ".IRQ")
+	, vgmRecorder(config.getMotherBoard().getVGMRecorder())
 	, isYMF278(isYMF278_)
 {
 	// For debugging: print out tables to be able to compare before/after
@@ -20,6 +20,7 @@
 namespace openmsx {
 
 class DeviceConfig;
+class VGMRecorder;
 
 class YMF262 final : private ResampledSoundDevice, private EmuTimerCallback
 {
@@ -200,6 +201,7 @@ private:
 	const std::unique_ptr<EmuTimer> timer2; // 323.1us OPL4  (321.8us OPL3)
 
 	IRQHelper irq;
+	VGMRecorder& vgmRecorder;
 
 	std::array<int, 18> chanOut = {};      // 18 channels
 
@@ -34,6 +34,7 @@
 #include "DeviceConfig.hh"
 #include "MSXException.hh"
 #include "MSXMotherBoard.hh"
+#include "VGMRecorder.hh"
 #include "serialize.hh"
 
 #include "enumerate.hh"
@@ -580,6 +581,9 @@ void YMF278::keyOnHelper(YMF278::Slot& slot) const
 
 void YMF278::writeReg(uint8_t reg, uint8_t data, EmuTime time)
 {
+	if (vgmRecorder.isRecording(VGMRecorder::Chip::YMF278B)) [[unlikely]] {
+		vgmRecorder.write(VGMRecorder::Chip::YMF278B, 2, reg, data, time); // wave part
+	}
 	updateStream(time); // TODO optimize only for regs that directly influence sound
 	writeRegDirect(reg, data, time);
 }
@@ -797,6 +801,7 @@ YMF278::YMF278(const std::string& name_, size_t ramSize, DeviceConfig& config,
 	: ResampledSoundDevice(config.getMotherBoard(), name_, "OPL4 wave-part",
 	                       24, INPUT_RATE, true)
 	, motherBoard(config.getMotherBoard())
+	, vgmRecorder(motherBoard.getVGMRecorder())
 	, debugRegisters(motherBoard, getName())
 	, debugMemory   (motherBoard, getName())
 	, rom(getName() + " ROM", "rom", config)
@@ -814,10 +819,12 @@ YMF278::YMF278(const std::string& name_, size_t ramSize, DeviceConfig& config,
 
 	registerSound(config);
 	reset(motherBoard.getCurrentTime()); // must come after registerSound() because of call to setSoftwareVolume() via setMixLevel()
+	vgmRecorder.registerSampleRam(VGMRecorder::Chip::YMF278B, ram);
 }
 
 YMF278::~YMF278()
 {
+	vgmRecorder.unregisterSampleRam(ram);
 	unregisterSound();
 }
 
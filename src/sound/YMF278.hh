@@ -20,6 +20,7 @@
 namespace openmsx {
 
 class DeviceConfig;
+class VGMRecorder;
 
 class YMF278 final : public ResampledSoundDevice
 {
@@ -117,6 +118,7 @@ private:
 	void keyOnHelper(Slot& slot) const;
 
 	MSXMotherBoard& motherBoard;
+	VGMRecorder& vgmRecorder;
 
 	struct DebugRegisters final : SimpleDebuggable {
 		DebugRegisters(MSXMotherBoard& motherBoard, const std::string& name);
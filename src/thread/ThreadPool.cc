@@ -0,0 +1,67 @@
+#include "ThreadPool.hh"
+
+#include "xrange.hh"
+
+#include <cassert>
+
+namespace openmsx {
+
+ThreadPool::ThreadPool(unsigned numThreads)
+{
+	assert(numThreads > 0);
+	threads.reserve(numThreads);
+	repeat(numThreads, [&] {
+		threads.emplace_back([this]() { run(); });
+	});
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::scoped_lock lock(mutex);
+		stopping = true;
+	}
+	condition.notify_all();
+	for (auto& t : threads) {
+		t.join();
+	}
+	assert(tasks.empty());
+}
+
+unsigned ThreadPool::getDefaultNumThreads()
+{
+	unsigned hw = std::thread::hardware_concurrency(); // can be 0 (unknown)
+	return (hw > 1) ? (hw - 1) : 1;
+}
+
+std::future<void> ThreadPool::enqueue(std::function<void()> task)
+{
+	std::packaged_task<void()> packaged(std::move(task));
+	auto result = packaged.get_future();
+	{
+		std::scoped_lock lock(mutex);
+		assert(!stopping);
+		tasks.push_back(std::move(packaged));
+	}
+	condition.notify_one();
+	return result;
+}
+
+void ThreadPool::run()
+{
+	while (true) {
+		std::packaged_task<void()> task;
+		{
+			std::unique_lock lock(mutex);
+			condition.wait(lock, [&] { return stopping || !tasks.empty(); });
+			// Even when stopping, first drain the queue: someone may
+			// still be waiting on the corresponding future.
+			if (tasks.empty()) return;
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		task();
+	}
+}
+
+} // namespace openmsx
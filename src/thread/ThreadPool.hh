@@ -0,0 +1,62 @@
+#ifndef THREADPOOL_HH
+#define THREADPOOL_HH
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace openmsx {
+
+/** A fixed set of worker threads that execute submitted tasks.
+  * Tasks are started in the order they were submitted, but with more than
+  * one worker there's no guarantee about the order in which they finish.
+  * Tasks must not access emulation state: they should only operate on data
+  * that was handed over to them (e.g. via a shared_ptr) when they were
+  * submitted. The only exception is when the main thread blocks until the
+  * tasks are finished, and the tasks don't share state with each other (like
+  * in MSXMixer::generate()).
+  */
+class ThreadPool
+{
+public:
+	/** Start the given number of worker threads (at least 1). */
+	explicit ThreadPool(unsigned numThreads);
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool(ThreadPool&&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	ThreadPool& operator=(ThreadPool&&) = delete;
+
+	/** Blocks until all pending tasks have finished. */
+	~ThreadPool();
+
+	/** A reasonable number of workers for this host: one less than the
+	  * number of hardware threads (the main thread is still busy with
+	  * emulation), but at least 1.
+	  */
+	[[nodiscard]] static unsigned getDefaultNumThreads();
+
+	[[nodiscard]] unsigned getNumThreads() const { return unsigned(threads.size()); }
+
+	/** Queue a task for execution on one of the worker threads.
+	  * The returned future becomes ready when the task has finished.
+	  */
+	std::future<void> enqueue(std::function<void()> task);
+
+private:
+	void run();
+
+private:
+	std::vector<std::thread> threads;
+	std::deque<std::packaged_task<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool stopping = false;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,140 @@
+#include "catch.hpp"
+#include "BitmapConverter.hh"
+
+#include "xrange.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <string_view>
+#include <vector>
+
+using namespace openmsx;
+using Pixel = BitmapConverter::Pixel;
+using Impl = BitmapConverter::Impl;
+
+namespace {
+
+struct Mode {
+	std::string_view name;
+	uint8_t reg0;
+	uint8_t reg25;
+	bool planar;
+	unsigned width;
+};
+
+constexpr std::array modes = {
+	Mode{"graphic4",     0x06, 0x00, false, 256},
+	Mode{"graphic5",     0x08, 0x00, false, 512},
+	Mode{"graphic6",     0x0A, 0x00, true,  512},
+	Mode{"graphic7",     0x0E, 0x00, true,  256},
+	Mode{"graphic7-yjk", 0x0E, 0x08, true,  256},
+	Mode{"graphic7-yae", 0x0E, 0x18, true,  256},
+};
+
+constexpr std::array allImpls = {Impl::PORTABLE, Impl::AVX2};
+
+std::string_view getName(Impl impl)
+{
+	return impl == Impl::PORTABLE ? "portable" : "avx2";
+}
+
+// Random palettes and VRAM contents (deterministic), and a converter per
+// implementation using them.
+struct Setup {
+	Setup()
+	{
+		std::mt19937 rng(1234);
+		auto fill = [&](auto& range) {
+			std::ranges::generate(range, [&] { return Pixel(rng()); });
+		};
+		fill(palette16);
+		fill(palette256);
+		fill(palette32768);
+		std::ranges::generate(vram, [&] { return uint8_t(rng()); });
+	}
+
+	void convert(BitmapConverter& converter, const Mode& m, unsigned line, std::span<Pixel> buf) const
+	{
+		converter.setDisplayMode(DisplayMode(m.reg0, 0, m.reg25));
+		const auto* p = &vram[(line % 256) * 256];
+		if (m.planar) {
+			converter.convertLinePlanar(buf, std::span<const uint8_t, 128>(p, 128),
+			                                 std::span<const uint8_t, 128>(p + 128, 128));
+		} else {
+			converter.convertLine(buf, std::span<const uint8_t, 128>(p, 128));
+		}
+	}
+
+	std::array<Pixel, 16 * 2> palette16;
+	std::array<Pixel, 256> palette256;
+	std::vector<Pixel> palette32768 = std::vector<Pixel>(32768);
+	std::vector<uint8_t> vram = std::vector<uint8_t>(256 * 256);
+};
+
+} // namespace
+
+TEST_CASE("BitmapConverter: implementations")
+{
+	CHECK(BitmapConverter::isSupported(Impl::PORTABLE));
+	CHECK(BitmapConverter::isSupported(BitmapConverter::getBest()));
+
+	Setup s;
+	std::span<const Pixel, 32768> pal32768(s.palette32768.data(), 32768);
+	BitmapConverter ref(s.palette16, s.palette256, pal32768, Impl::PORTABLE);
+	for (auto impl : allImpls) {
+		if (!BitmapConverter::isSupported(impl)) continue;
+		BitmapConverter converter(s.palette16, s.palette256, pal32768, impl);
+		for (const auto& m : modes) {
+			INFO("impl: " << getName(impl) << "  mode: " << m.name);
+			for (auto line : xrange(256u)) {
+				// the pixels past 'width' must not be touched
+				std::array<Pixel, 512 + 1> expected; expected.fill(0x12345678);
+				std::array<Pixel, 512 + 1> actual;   actual  .fill(0x12345678);
+				s.convert(ref,       m, line, expected);
+				s.convert(converter, m, line, actual);
+				if (expected != actual) {
+					FAIL("mismatch on line " << line);
+				}
+			}
+
+			// palette changes are picked up
+			s.palette16[3] ^= 0xFFFFFF;
+			s.palette16[16 + 1] ^= 0xFFFFFF;
+			ref.palette16Changed();
+			converter.palette16Changed();
+			std::array<Pixel, 512> expected; expected.fill(0x12345678);
+			std::array<Pixel, 512> actual;   actual  .fill(0x12345678);
+			s.convert(ref,       m, 7, expected);
+			s.convert(converter, m, 7, actual);
+			CHECK(expected == actual);
+		}
+	}
+}
+
+TEST_CASE("BitmapConverter: graphic4")
+{
+	// One VRAM byte contains two pixels, the high nibble is the left one.
+	std::array<Pixel, 16 * 2> palette16;
+	for (auto i : xrange(32)) palette16[i] = 0x01010101 * Pixel(i);
+	std::array<Pixel, 256> palette256 = {};
+	std::vector<Pixel> palette32768(32768);
+	std::span<const Pixel, 32768> pal32768(palette32768.data(), 32768);
+
+	std::array<uint8_t, 128> vram;
+	for (auto i : xrange(128)) vram[i] = uint8_t(i * 0x11 + 1);
+
+	for (auto impl : allImpls) {
+		if (!BitmapConverter::isSupported(impl)) continue;
+		INFO("impl: " << getName(impl));
+		BitmapConverter converter(palette16, palette256, pal32768, impl);
+		converter.setDisplayMode(DisplayMode(0x06, 0, 0));
+		std::array<Pixel, 256> buf;
+		converter.convertLine(buf, vram);
+		for (auto i : xrange(128)) {
+			CHECK(buf[2 * i + 0] == palette16[vram[i] >> 4]);
+			CHECK(buf[2 * i + 1] == palette16[vram[i] & 15]);
+		}
+	}
+}
@@ -0,0 +1,284 @@
+#include "catch.hpp"
+#include "CompiledCondition.hh"
+
+#include "CommandException.hh"
+#include "Interpreter.hh"
+#include "TclObject.hh"
+
+#include "strCat.hh"
+#include "xrange.hh"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <random>
+#include <string>
+
+using namespace openmsx;
+
+namespace {
+
+struct FakeContext final : CompiledCondition::Context {
+	uint8_t readReg(unsigned index) override { return regs[index]; }
+	uint8_t peek(uint16_t address) override { return mem[address]; }
+	std::pair<int, int> getSelectedSlot(unsigned page) override { return slots[page]; }
+
+	std::array<uint8_t, 28> regs = {};
+	std::array<uint8_t, 0x10000> mem = {};
+	std::array<std::pair<int, int>, 4> slots = {};
+};
+
+int64_t eval(std::string_view expression, FakeContext& context)
+{
+	auto cond = CompiledCondition::compile(expression);
+	REQUIRE(cond);
+	return cond->evaluate(context);
+}
+
+} // namespace
+
+TEST_CASE("CompiledCondition: unsupported")
+{
+	for (auto* expr : {
+		"", "1 +", "(1", "1)", "1.5", "1e3", "2 ** 3", "012", "0x", "0b2",
+		"\"a\" eq \"b\"", "{1}", "abs(-1)", "$a", "${wp_last_address}",
+		"99999999999999999999", "[reg QQ]", "[reg]", "[reg A B]",
+		"[peek]", "[peek -1]", "[peek 1 vram]", "[peek \"1\"]", "[peek 0x10+1]",
+		"[debug read memory 0]", "[pc_in_slot 4]", "[pc_in_slot 1 2 3]",
+		"[reg A]; [reg B]", "1 = 1", "1 ? 2", "1 === 1",
+		// might overflow 64 bits
+		"1 << 64", "1 << 63", "1 << [reg A]", "[reg HL] * 0x1000000000000",
+		"0x7FFFFFFFFFFFFFFF + [reg A]", "-0x7FFFFFFFFFFFFFFF - 2",
+		"-(-0x7FFFFFFFFFFFFFFF - 1)", "(-0x7FFFFFFFFFFFFFFF - 1) / -1",
+		// in Tcl the result is "true" or 0
+		"[pc_in_slot 1] + 1", "[pc_in_slot 1] == 1", "-[pc_in_slot 1]",
+		"[peek [pc_in_slot 1]]", "(1 ? [watch_in_slot 1] : 0) & 1",
+	}) {
+		INFO(expr);
+		CHECK(!CompiledCondition::compile(expr));
+	}
+}
+
+TEST_CASE("CompiledCondition: evaluate")
+{
+	FakeContext c;
+	for (auto i : xrange(28)) c.regs[i] = uint8_t(i + 1);
+	c.mem[0x1234] = 0x56;
+	c.mem[0x1235] = 0x78;
+	c.mem[0xFFFF] = 0x9A;
+
+	SECTION("literals and operators") {
+		CHECK(eval("42", c) == 42);
+		CHECK(eval("0x10 + 0o10 + 0b10 + 0", c) == 26);
+		CHECK(eval("1 + 2 * 3", c) == 7);
+		CHECK(eval("(1 + 2) * 3", c) == 9);
+		CHECK(eval("-7 / 2", c) == -4); // rounds down, like Tcl
+		CHECK(eval("7 / -2", c) == -4);
+		CHECK(eval("-7 % 2", c) == 1);  // sign of the divisor
+		CHECK(eval("7 % -2", c) == -1);
+		CHECK(eval("1 << 4 | 1", c) == 17);
+		CHECK(eval("-16 >> 2", c) == -4);
+		CHECK(eval("~0 ^ 5 & 3", c) == ~1);
+		CHECK(eval("!0 + !7 + - -3 + +1", c) == 5);
+		CHECK(eval("3 < 4 && 4 <= 4 && 5 > 4 && 4 >= 5", c) == 0);
+		CHECK(eval("0 || 7", c) == 1);
+		CHECK(eval("1 == 1 != 0", c) == 1);
+		CHECK(eval("0 ? 1 : 2 ? 3 : 4", c) == 3);
+		CHECK(eval("1 ? 0 ? 5 : 6 : 7", c) == 6);
+		CHECK_THROWS_AS(eval("1 / (2 - 2)", c), CommandException);
+		CHECK_THROWS_AS(eval("1 % 0", c), CommandException);
+		CHECK_THROWS_AS(eval("1 << -1", c), CommandException);
+	}
+	SECTION("no overflow") {
+		CHECK(eval("1 << 62", c) == int64_t(1) << 62);
+		CHECK(eval("0 << 100", c) == 0);
+		CHECK(eval("1 >> 100", c) == 0);
+		CHECK(eval("[reg HL] * 0x100000000", c) == int64_t(0x0708) << 32);
+		CHECK(eval("-0x7FFFFFFFFFFFFFFF - 1", c) == std::numeric_limits<int64_t>::min());
+		CHECK(eval("(-0x7FFFFFFFFFFFFFFF - 1) % -1", c) == 0);
+		CHECK(eval("([reg A] & 0xF) << 59", c) == int64_t(1) << 59);
+	}
+	SECTION("short-circuit") {
+		// the right hand side is not evaluated (it would throw)
+		CHECK(eval("0 && 1 / 0", c) == 0);
+		CHECK(eval("1 || 1 / 0", c) == 1);
+		CHECK(eval("1 ? 2 : 1 / 0", c) == 2);
+		CHECK(eval("0 ? 1 / 0 : 3", c) == 3);
+	}
+	SECTION("registers") {
+		CHECK(eval("[reg A]", c) == 1);
+		CHECK(eval("[reg l2]", c) == 16);
+		CHECK(eval("[reg IFF]", c) == 28);
+		CHECK(eval("[reg HL]", c) == 0x0708);
+		CHECK(eval("[ reg  pc ]", c) == 0x1516);
+		CHECK(eval("[reg A] == 1 && [reg B] != 1", c) == 1);
+	}
+	SECTION("memory") {
+		CHECK(eval("[peek 0x1234]", c) == 0x56);
+		CHECK(eval("[peek_u8 0x1234 memory]", c) == 0x56);
+		CHECK(eval("[peek16 0x1234]", c) == 0x7856);
+		CHECK(eval("[peek_u16 0x1234 memory]", c) == 0x7856);
+		c.regs[6] = 0x12; c.regs[7] = 0x34; // HL
+		CHECK(eval("[peek [reg HL]] + 1", c) == 0x57);
+		CHECK(eval("[peek 0xFFFF]", c) == 0x9A);
+		CHECK_THROWS_AS(eval("[peek16 0xFFFF]", c), CommandException);
+	}
+	SECTION("watchpoint variables") {
+		CHECK_THROWS_AS(eval("$wp_last_address", c), CommandException);
+		c.wpLastAddress = 0x1234;
+		c.wpLastValue = 3;
+		CHECK(eval("$wp_last_address == 0x1234 && $::wp_last_value == 3", c) == 1);
+	}
+	SECTION("slots") {
+		c.slots = {{{0, -1}, {3, 1}, {3, 2}, {1, -1}}};
+		c.regs[20] = 0x40; // PC = 0x4000
+		CHECK(eval("[pc_in_slot 3]", c) == 1);
+		CHECK(eval("[pc_in_slot 3 1]", c) == 1);
+		CHECK(eval("[pc_in_slot 3 2]", c) == 0);
+		CHECK(eval("[pc_in_slot X 1]", c) == 1);
+		CHECK(eval("[pc_in_slot 0]", c) == 0);
+		c.regs[20] = 0xC0; // not expanded: any secondary slot matches
+		CHECK(eval("[pc_in_slot 1 3]", c) == 1);
+		c.wpLastAddress = 0x8000;
+		CHECK(eval("[watch_in_slot 3 2]", c) == 1);
+		CHECK(eval("[watch_in_slot 3 1]", c) == 0);
+		// used as a boolean
+		CHECK(eval("![pc_in_slot 1] || [pc_in_slot 0 1]", c) == 0);
+		CHECK(eval("[pc_in_slot 1] && [reg A] ? [pc_in_slot 1] : 0", c) == 1);
+	}
+}
+
+namespace {
+
+// Generates random expressions in the supported subset. Mostly with small
+// values, but sometimes with large values or shifts, which might overflow 64
+// bits (then Tcl switches to big integers). Also with [pc_in_slot ..], which
+// in Tcl gives "true" or 0.
+class ExpressionGenerator
+{
+public:
+	explicit ExpressionGenerator(unsigned seed) : rng(seed) {}
+
+	std::string generate(int depth) {
+		if ((depth == 0) || (random(4) == 0)) return leaf();
+		switch (random(8)) {
+		case 0: {
+			static constexpr std::array ops = {"-", "+", "~", "!"};
+			return strCat(ops[random(ops.size())], '(', generate(depth - 1), ')');
+		}
+		case 1:
+			return strCat('(', generate(depth - 1), " ? ", generate(depth - 1),
+			              " : ", generate(depth - 1), ')');
+		case 2: {
+			static constexpr std::array ops = {"<<", ">>"};
+			auto shift = (random(8) == 0) ? 60 + random(8) : random(4);
+			return strCat('(', generate(depth - 1), ' ', ops[random(ops.size())],
+			              ' ', shift, ')');
+		}
+		default: {
+			static constexpr std::array ops = {
+				"*", "/", "%", "+", "-", "<", ">", "<=", ">=", "==", "!=",
+				"&", "^", "|", "&&", "||"};
+			return strCat('(', generate(depth - 1), ' ', ops[random(ops.size())],
+			              ' ', generate(depth - 1), ')');
+		}
+		}
+	}
+
+private:
+	std::string leaf() {
+		static constexpr std::array regs = {"A", "b", "C", "IXh", "R"};
+		static constexpr std::array large = {
+			"0x1000000000000", "0x7FFFFFFFFFFFFFFF", "4611686018427387904"};
+		switch (random(9)) {
+		case 0: return strCat("[reg ", regs[random(regs.size())], ']');
+		case 1: return strCat("[peek ", random(100), ']');
+		case 2: return strCat("[peek [reg ", regs[random(regs.size())], "]]");
+		case 3: return "$wp_last_address";
+		case 4: return strCat("0x", hex_string<2>(random(100)));
+		case 5: return (random(4) == 0) ? large[random(large.size())]
+		                                : strCat(random(100));
+		case 6: return strCat("[pc_in_slot ", random(4), ']');
+		case 7: return strCat("[pc_in_slot ", random(4), ' ', random(4), ']');
+		default: return strCat(random(100));
+		}
+	}
+
+	unsigned random(size_t n) { return unsigned(rng() % n); }
+
+	std::mt19937 rng;
+};
+
+} // namespace
+
+TEST_CASE("CompiledCondition: compare with Tcl")
+{
+	// Evaluate the same random expressions compiled and in Tcl. The Tcl
+	// procs below mimic the ones from the startup scripts, on the state
+	// of the FakeContext. Expressions that don't compile are evaluated by
+	// Tcl in openMSX, so there's nothing to compare for those.
+	Interpreter interp;
+	FakeContext c;
+	std::mt19937 rng(4321);
+	for (auto& r : c.regs) r = uint8_t(rng() % 100);
+	for (auto& m : c.mem) m = uint8_t(rng() % 100);
+	c.wpLastAddress = 17;
+	c.regs[20] = 0x80; // PC = 0x80xx
+	c.slots = {{{0, -1}, {3, 1}, {3, 2}, {1, -1}}};
+
+	TclObject regs;
+	for (auto [name, index] : {std::pair{"A", 0}, {"B", 2}, {"C", 3}, {"IXH", 16}, {"R", 25}}) {
+		regs.addListElement(name, int(c.regs[index]));
+	}
+	TclObject mem;
+	for (auto i : xrange(100)) mem.addListElement(int(c.mem[i]));
+	interp.setVariable(TclObject("regs"), regs);
+	interp.setVariable(TclObject("mem"), mem);
+	interp.setVariable(TclObject("wp_last_address"), TclObject(int(*c.wpLastAddress)));
+	interp.setVariable(TclObject("slots"), TclObject("{0 X} {3 1} {3 2} {1 X}"));
+	interp.execute("proc reg {name} {dict get $::regs [string toupper $name]}");
+	interp.execute("proc peek {addr} {lindex $::mem $addr}");
+	interp.execute(
+		"proc pc_in_slot {ps {ss X}} {\n"
+		"  lassign [lindex $::slots 2] pc_ps pc_ss\n"
+		"  if {($ps ne \"X\") && ($pc_ps != $ps)} {return 0}\n"
+		"  if {($ss ne \"X\") && ($pc_ss ne \"X\") && ($pc_ss != $ss)} {return 0}\n"
+		"  return true\n"
+		"}");
+
+	ExpressionGenerator generator(1234);
+	int compared = 0;
+	int notCompiled = 0;
+	for (auto i : xrange(2000)) {
+		auto expr = generator.generate(1 + i % 3);
+		INFO(expr);
+		auto cond = CompiledCondition::compile(expr);
+		if (!cond) {
+			++notCompiled;
+			continue;
+		}
+
+		std::optional<TclObject> tclResult;
+		try {
+			tclResult = TclObject(expr).eval(interp);
+		} catch (CommandException&) {
+			// e.g. divide by zero
+		}
+		if (tclResult) {
+			INFO(tclResult->getString());
+			if (auto value = tclResult->getOptionalInt64()) {
+				CHECK(cond->evaluate(c) == *value);
+			} else {
+				// e.g. '0 ? 1 : [pc_in_slot 3]', not a big integer
+				REQUIRE(tclResult->getString() == "true");
+				CHECK(cond->evaluate(c) == 1);
+			}
+			++compared;
+		} else {
+			CHECK_THROWS_AS(cond->evaluate(c), CommandException);
+		}
+	}
+	CHECK(compared > 1000);
+	CHECK(notCompiled > 0);
+}
@@ -0,0 +1,149 @@
+#include "catch.hpp"
+
+#include "DeltaBlock.hh"
+
+#include "xrange.hh"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+using DeltaEncoder::ISA;
+
+// Compare all (on this host) supported encoders with the portable scalar one.
+// Also check that applying the delta to the old buffer gives the new buffer.
+static void check(const std::vector<uint8_t>& oldBuf, std::vector<uint8_t> newBuf)
+{
+	REQUIRE(oldBuf.size() == newBuf.size());
+	auto newCopy = newBuf;
+	auto expected = DeltaEncoder::calc(ISA::SCALAR, newBuf, oldBuf.data());
+	CHECK(newBuf == newCopy); // sentinels must be restored
+
+	for (auto isa : {ISA::SSE2, ISA::AVX2, ISA::NEON}) {
+		if (!DeltaEncoder::isSupported(isa)) continue;
+		auto delta = DeltaEncoder::calc(isa, newBuf, oldBuf.data());
+		CHECK(delta == expected);
+		CHECK(newBuf == newCopy);
+	}
+
+	auto buf = oldBuf;
+	DeltaEncoder::apply(buf, expected);
+	CHECK(buf == newBuf);
+}
+
+TEST_CASE("DeltaEncoder: small")
+{
+	check({}, {});
+	check({1}, {1});
+	check({1}, {2});
+	check({1, 2, 3}, {1, 5, 3});
+	check({1, 2, 3, 4, 5, 6, 7, 8}, {9, 2, 3, 4, 5, 6, 7, 9});
+	check({1, 2, 3, 4, 5, 6, 7, 8}, {9, 9, 3, 9, 9, 9, 7, 8});
+}
+
+TEST_CASE("DeltaEncoder: random")
+{
+	std::mt19937 gen(1234); // fixed seed: reproducible failures
+	auto randByte = [&] { return uint8_t(gen()); };
+
+	// Random sizes, including ones that are not a multiple of the vector
+	// size, and random mutations: single bytes, short and long runs.
+	repeat(200, [&] {
+		auto size = std::uniform_int_distribution<size_t>(0, 5000)(gen);
+		std::vector<uint8_t> oldBuf(size);
+		std::ranges::generate(oldBuf, randByte);
+		auto newBuf = oldBuf;
+		if (size != 0) {
+			auto numChanges = std::uniform_int_distribution<size_t>(0, 50)(gen);
+			repeat(numChanges, [&] {
+				auto pos = std::uniform_int_distribution<size_t>(0, size - 1)(gen);
+				auto len = std::uniform_int_distribution<size_t>(1, 70)(gen);
+				for (auto j : xrange(pos, std::min(pos + len, size))) {
+					newBuf[j] = randByte();
+				}
+			});
+		}
+		check(oldBuf, newBuf);
+	});
+
+	// Completely different buffers.
+	std::vector<uint8_t> a(4096), b(4096);
+	std::ranges::generate(a, randByte);
+	std::ranges::generate(b, randByte);
+	check(a, b);
+}
+
+TEST_CASE("DeltaEncoder: real-world-like")
+{
+	std::mt19937 gen(5678);
+
+	// Mostly zero-filled RAM with a program and a stack area, where a few
+	// variables and the stack change between two snapshots.
+	std::vector<uint8_t> ram(64 * 1024, 0);
+	for (auto i : xrange(0x4000, 0x6000)) ram[i] = uint8_t(gen());
+	for (auto i : xrange(0xf000, 0xf380)) ram[i] = uint8_t(i);
+	auto ram2 = ram;
+	for (auto i : xrange(0xc000, 0xc010)) ram2[i] = uint8_t(i * 3 + 1);
+	ram2[0xf100] ^= 0x40;
+	ram2[0xf101] ^= 0x01;
+	for (auto i : xrange(0xf370, 0xf380)) ram2[i] = uint8_t(gen());
+	check(ram, ram2);
+	check(ram, ram); // no changes at all
+
+	// VRAM: repeating tile patterns with a scrolled name table.
+	std::vector<uint8_t> vram(128 * 1024);
+	for (auto i : xrange(vram.size())) vram[i] = uint8_t((i * 7) ^ (i >> 8));
+	auto vram2 = vram;
+	auto nameTable = std::span{vram2}.subspan(0x1800, 0x300);
+	std::ranges::rotate(nameTable, nameTable.begin() + 1);
+	check(vram, vram2);
+
+	// Sample RAM where a whole block got overwritten.
+	std::vector<uint8_t> samples(256 * 1024);
+	std::ranges::generate(samples, [&] { return uint8_t(gen() & 0x0f); });
+	auto samples2 = samples;
+	std::ranges::generate(std::span{samples2}.subspan(10000, 30000), [&] { return uint8_t(gen()); });
+	check(samples, samples2);
+}
+
+TEST_CASE("DeltaBlock")
+{
+	// Chain of snapshots through LastDeltaBlocks, both with immediate and
+	// with deferred work, must reproduce every snapshot.
+	std::mt19937 gen(42);
+	for (bool defer : {false, true}) {
+		LastDeltaBlocks lastBlocks;
+		lastBlocks.setDeferWork(defer);
+		std::vector<uint8_t> mem(20000);
+		// compressible content, so that blocks actually get compressed
+		std::ranges::generate(mem, [&] { return uint8_t((gen() % 8) ? 0 : gen()); });
+
+		std::vector<std::pair<std::shared_ptr<DeltaBlock>, std::vector<uint8_t>>> snapshots;
+		repeat(30, [&] {
+			auto numChanges = std::uniform_int_distribution<size_t>(0, 500)(gen);
+			repeat(numChanges, [&] {
+				mem[std::uniform_int_distribution<size_t>(0, mem.size() - 1)(gen)] = uint8_t(gen());
+			});
+			snapshots.emplace_back(lastBlocks.createNew(mem.data(), mem), mem);
+			for (auto& job : lastBlocks.takeDeferredWork()) job();
+		});
+		for (const auto& [block, expected] : snapshots) {
+			std::vector<uint8_t> buf(expected.size());
+			block->apply(buf);
+			CHECK(buf == expected);
+		}
+
+		// Recompress the reference blocks that are no longer in use,
+		// snapshots must still be the same.
+		for (const auto& [block, expected] : snapshots) {
+			block->getReference().recompress();
+		}
+		for (const auto& [block, expected] : snapshots) {
+			CHECK(block->getRawSize() == expected.size());
+			std::vector<uint8_t> buf(expected.size());
+			block->apply(buf);
+			CHECK(buf == expected);
+		}
+	}
+}
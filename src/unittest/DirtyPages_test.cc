@@ -0,0 +1,41 @@
+#include "catch.hpp"
+
+#include "DirtyPages.hh"
+
+using namespace openmsx;
+
+TEST_CASE("DirtyPages")
+{
+	static constexpr auto P = DirtyPages::PAGE_SIZE;
+	DirtyPages dirty(100 * P + 10); // partial last page
+
+	// initially everything is dirty
+	CHECK(dirty.isDirty(0, 1));
+	CHECK(dirty.isDirty(100 * P, 10));
+
+	dirty.clear();
+	CHECK(!dirty.isDirty(0, 100 * P + 10));
+	CHECK(!dirty.isDirty(0, 0));
+
+	dirty.markDirty(5 * P + 3);
+	CHECK(dirty.isDirty(5 * P, P));
+	CHECK(dirty.isDirty(5 * P + P - 1, 1));
+	CHECK(dirty.isDirty(0, 6 * P));
+	CHECK(!dirty.isDirty(0, 5 * P));
+	CHECK(!dirty.isDirty(6 * P, 94 * P + 10));
+
+	// range crossing a 64-page word boundary
+	dirty.clear();
+	dirty.markDirty(63 * P + 1, 2 * P);
+	CHECK(!dirty.isDirty(62 * P, P));
+	CHECK(dirty.isDirty(63 * P, 1));
+	CHECK(dirty.isDirty(64 * P, 1));
+	CHECK(dirty.isDirty(65 * P, 1));
+	CHECK(!dirty.isDirty(66 * P, P));
+
+	dirty.markDirty(100 * P + 9);
+	CHECK(dirty.isDirty(100 * P, 10));
+
+	dirty.markAllDirty();
+	CHECK(dirty.isDirty(30 * P, 1));
+}
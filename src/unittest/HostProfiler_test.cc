@@ -0,0 +1,78 @@
+#include "catch.hpp"
+
+#include "HostProfiler.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+using namespace openmsx;
+
+static const HostProfiler::Entry* findEntry(std::string_view name)
+{
+	auto entries = HostProfiler::getEntries();
+	auto it = std::ranges::find(entries, name, &HostProfiler::Entry::name);
+	return (it != entries.end()) ? &*it : nullptr;
+}
+
+static void busyWait(std::chrono::microseconds duration)
+{
+	auto end = std::chrono::steady_clock::now() + duration;
+	while (std::chrono::steady_clock::now() < end) {}
+}
+
+TEST_CASE("HostProfiler")
+{
+	using Cat = HostProfiler::Category;
+	REQUIRE(!HostProfiler::isEnabled());
+
+	// disabled -> no entries are created
+	int calls = 0;
+	HostProfiler::profile(Cat::CPU, "test-disabled", [&] { ++calls; });
+	CHECK(calls == 1);
+	CHECK(findEntry("test-disabled") == nullptr);
+
+	HostProfiler::setEnabled(true);
+	HostProfiler::reset();
+	for (int i = 0; i < 3; ++i) {
+		HostProfiler::profile(Cat::CPU, "test-outer", [&] {
+			busyWait(std::chrono::microseconds(200));
+			HostProfiler::profile(Cat::SYNC_POINT, &i, [](const void*) {
+				return std::string("test-inner");
+			}, [&] {
+				busyWait(std::chrono::microseconds(300));
+			});
+		});
+	}
+	// the result of 'f' is passed through
+	CHECK(HostProfiler::profile(Cat::CPU, "test-result", [] { return 42; }) == 42);
+	HostProfiler::setEnabled(false);
+
+	const auto* outer = findEntry("test-outer");
+	const auto* inner = findEntry("test-inner");
+	REQUIRE(outer);
+	REQUIRE(inner);
+	CHECK(outer->category == Cat::CPU);
+	CHECK(inner->category == Cat::SYNC_POINT);
+	CHECK(outer->calls == 3);
+	CHECK(inner->calls == 3); // same key -> same entry
+
+	// nested time is included in 'total', but not in 'self'
+	CHECK(inner->self == inner->total);
+	CHECK(outer->total >= inner->total);
+	CHECK(outer->self + inner->total == outer->total);
+	CHECK(inner->total >= std::chrono::microseconds(900));
+	CHECK(outer->self >= std::chrono::microseconds(600));
+	CHECK(HostProfiler::getElapsed() >= outer->total);
+
+	// reset keeps the entries but clears the statistics
+	HostProfiler::reset();
+	CHECK(findEntry("test-outer")->calls == 0);
+	CHECK(findEntry("test-outer")->total == HostProfiler::Duration{});
+	CHECK(HostProfiler::getElapsed() == HostProfiler::Duration{});
+}
+
+TEST_CASE("HostProfiler::getTypeName")
+{
+	CHECK(HostProfiler::getTypeName(typeid(HostProfileScope)) == "HostProfileScope");
+}
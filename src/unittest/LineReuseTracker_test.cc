@@ -0,0 +1,88 @@
+#include "catch.hpp"
+#include "LineReuseTracker.hh"
+
+#include "xrange.hh"
+
+using namespace openmsx;
+
+namespace {
+
+constexpr int NUM_LINES = 32;
+using Tracker = LineReuseTracker<NUM_LINES>;
+
+// Like PixelRenderer::drawDisplay(): absolute line 'y' shows display line
+// 'y + scroll'. Lines that can be reused are copied, others are drawn. In
+// both cases they're marked as drawn for the next frame.
+// Returns the number of reused lines.
+int renderLines(Tracker& tracker, int fromY, int limitY, int scroll = 0)
+{
+	int reused = 0;
+	for (auto y : xrange(fromY, limitY)) {
+		int displayY = (y + scroll) & 255;
+		if (tracker.canReuse(y, displayY)) ++reused;
+		tracker.setDrawn(y, displayY);
+	}
+	return reused;
+}
+
+int renderFrame(Tracker& tracker, int scroll = 0)
+{
+	tracker.nextFrame();
+	return renderLines(tracker, 0, NUM_LINES, scroll);
+}
+
+} // namespace
+
+TEST_CASE("LineReuseTracker: unchanged frames")
+{
+	Tracker tracker;
+	CHECK(renderFrame(tracker) == 0); // nothing to reuse yet
+	CHECK(renderFrame(tracker) == NUM_LINES);
+	CHECK(renderFrame(tracker) == NUM_LINES);
+
+	// different display line on the same absolute line
+	CHECK(renderFrame(tracker, 1) == 0);
+	CHECK(renderFrame(tracker, 1) == NUM_LINES);
+
+	tracker.reset();
+	CHECK(renderFrame(tracker, 1) == 0);
+}
+
+TEST_CASE("LineReuseTracker: change of some display lines")
+{
+	Tracker tracker;
+	renderFrame(tracker);
+	renderFrame(tracker);
+
+	tracker.markDirty(8, 4);
+	CHECK(renderFrame(tracker) == NUM_LINES - 4);
+	CHECK(renderFrame(tracker) == NUM_LINES);
+
+	// wraps at 256, display lines 254, 255, 0, 1
+	tracker.markDirty(254, 4);
+	CHECK(renderFrame(tracker) == NUM_LINES - 2);
+}
+
+TEST_CASE("LineReuseTracker: sprite magnification change between frames")
+{
+	// PixelRenderer::updateSpriteSizeMag() marks all lines dirty (sprites
+	// can be anywhere). The same goes for the sprite attribute and
+	// pattern table base addresses.
+	Tracker tracker;
+	renderFrame(tracker);
+	CHECK(renderFrame(tracker) == NUM_LINES);
+
+	// change in between two frames: nothing can be reused
+	tracker.markAllDirty();
+	CHECK(renderFrame(tracker) == 0);
+	CHECK(renderFrame(tracker) == NUM_LINES);
+
+	// change halfway a frame: the lines above it were drawn with the old
+	// magnification, so they must be drawn again in the next frame
+	tracker.nextFrame();
+	CHECK(renderLines(tracker, 0, NUM_LINES / 2) == NUM_LINES / 2);
+	tracker.markAllDirty();
+	CHECK(renderLines(tracker, NUM_LINES / 2, NUM_LINES) == 0);
+	CHECK(renderFrame(tracker) == NUM_LINES / 2);
+	CHECK(renderFrame(tracker) == NUM_LINES);
+}
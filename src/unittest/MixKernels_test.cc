@@ -0,0 +1,125 @@
+#include "catch.hpp"
+
+#include "MixKernels.hh"
+
+#include "xrange.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <string_view>
+#include <vector>
+
+using namespace openmsx;
+using MixKernels::ISA;
+
+static constexpr std::array allISAs = {ISA::SCALAR, ISA::SSE2, ISA::AVX2, ISA::NEON};
+
+static std::string_view getName(ISA isa)
+{
+	static constexpr std::array<std::string_view, 4> names = {"scalar", "sse2", "avx2", "neon"};
+	return names[size_t(isa)];
+}
+
+// Random samples in the range [-1, 1], plus padding (see MixKernels.hh).
+static std::vector<float> randomBuffer(size_t size, std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+	std::vector<float> result(size + 8);
+	std::ranges::generate(result, [&] { return dist(rng); });
+	return result;
+}
+
+// All implementations perform the same operations, but the compiler may or
+// may not contract a multiply and add into a single (more precise) instruction.
+static void checkEqual(const std::vector<float>& expected, const std::vector<float>& actual, size_t n)
+{
+	REQUIRE(actual.size() >= n);
+	for (auto i : xrange(n)) {
+		CHECK(std::abs(expected[i] - actual[i]) <= 1e-6f);
+	}
+}
+
+// Run 'func(kernels, buf)' on a copy of 'input' for all supported instruction
+// sets, and compare the first 'n' elements with the scalar version.
+template<typename Func>
+static void compare(const std::vector<float>& input, size_t n, Func func)
+{
+	auto expected = input;
+	func(MixKernels::get(ISA::SCALAR), expected);
+	for (auto isa : allISAs) {
+		if (!MixKernels::isSupported(isa)) continue;
+		INFO("isa: " << getName(isa) << "  n: " << n);
+		auto actual = input;
+		func(MixKernels::get(isa), actual);
+		checkEqual(expected, actual, n);
+	}
+}
+
+TEST_CASE("MixKernels")
+{
+	CHECK(MixKernels::isSupported(ISA::SCALAR));
+	CHECK(MixKernels::isSupported(MixKernels::getBest()));
+
+	std::mt19937 rng(42); // deterministic
+	for (size_t n : {1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 100, 512, 513}) {
+		auto in  = randomBuffer(2 * n, rng);
+		auto acc = randomBuffer(2 * n, rng);
+
+		compare(acc, n, [&](const auto& k, auto& buf) {
+			k.mul(buf.data(), n, 0.7f);
+		});
+		compare(acc, n, [&](const auto& k, auto& buf) {
+			k.mulAcc(buf.data(), in.data(), n, -0.3f);
+		});
+		compare(acc, 2 * n, [&](const auto& k, auto& buf) {
+			k.mulExpand(buf.data(), n, 0.25f, 0.8f);
+		});
+		compare(acc, 2 * n, [&](const auto& k, auto& buf) {
+			k.mulExpandAcc(buf.data(), in.data(), n, 0.25f, 0.8f);
+		});
+		compare(acc, 2 * n, [&](const auto& k, auto& buf) {
+			k.mulMix2(buf.data(), n, 0.9f, 0.1f, 0.2f, 0.6f);
+		});
+		compare(acc, 2 * n, [&](const auto& k, auto& buf) {
+			k.mulMix2Acc(buf.data(), in.data(), n, 0.9f, 0.1f, 0.2f, 0.6f);
+		});
+
+		for (size_t num : {1, 2, 5}) {
+			std::vector<std::vector<float>> channels;
+			std::vector<const float*> bufs;
+			channels.reserve(num);
+			repeat(num, [&] {
+				channels.push_back(randomBuffer(2 * n, rng));
+				bufs.push_back(channels.back().data());
+			});
+			auto balance = randomBuffer(2 * num, rng);
+			compare(acc, n, [&](const auto& k, auto& buf) {
+				k.sumChannels(buf.data(), bufs.data(), num, n);
+			});
+			compare(acc, 2 * n, [&](const auto& k, auto& buf) {
+				k.mixBalance(buf.data(), bufs.data(), balance.data(), num, n);
+			});
+		}
+	}
+}
+
+TEST_CASE("MixKernels: mulExpand in-place")
+{
+	// mono input in the first half of the buffer, stereo result fills it
+	for (size_t n : {1, 3, 4, 5, 8, 13}) {
+		std::vector<float> buf(2 * n + 8);
+		for (auto i : xrange(n)) buf[i] = float(i + 1);
+		for (auto isa : allISAs) {
+			if (!MixKernels::isSupported(isa)) continue;
+			INFO("isa: " << getName(isa) << "  n: " << n);
+			auto b = buf;
+			MixKernels::get(isa).mulExpand(b.data(), n, 1.0f, -2.0f);
+			for (auto i : xrange(n)) {
+				CHECK(b[2 * i + 0] ==  float(i + 1));
+				CHECK(b[2 * i + 1] == -2.0f * float(i + 1));
+			}
+		}
+	}
+}
@@ -0,0 +1,129 @@
+#include "catch.hpp"
+
+#include "ResampleHQ.hh"
+
+#include "Math.hh"
+#include "xrange.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <string_view>
+#include <vector>
+
+using namespace openmsx;
+using Quality = ResampleFilter::Quality;
+using Impl = ResampleFilter::Impl;
+
+static constexpr std::array allQualities = {Quality::HIGH, Quality::MEDIUM};
+static constexpr std::array allImpls = {Impl::PORTABLE, Impl::AVX2_FMA};
+
+// input-rate / output-rate
+static constexpr std::array ratios = {
+	3579545.0 / 2 / 16 / 44100, // PSG -> 44.1kHz
+	44100.0 / 48000,            // e.g. a 44.1kHz sample player -> 48kHz
+	48000.0 / 44100,
+	0.5,
+};
+
+static std::string_view getName(Quality quality)
+{
+	return quality == Quality::HIGH ? "high" : "medium";
+}
+static std::string_view getName(Impl impl)
+{
+	return impl == Impl::PORTABLE ? "portable" : "avx2-fma";
+}
+
+// Calculate 'num' (mono or stereo) output samples at positions 'start',
+// 'start + step', ... Input sample 'i' is 'input[i * CHANNELS]'.
+template<unsigned CHANNELS>
+static std::vector<float> resample(const ResampleFilter& filter, const std::vector<float>& input,
+                                   double start, double step, size_t num)
+{
+	std::vector<float> result(num * CHANNELS);
+	for (auto i : xrange(num)) {
+		auto pos = float(start + double(i) * step);
+		assert(size_t(pos) + filter.getFilterLen() <= input.size() / CHANNELS);
+		filter.calcOutput<CHANNELS>(&input[size_t(pos) * CHANNELS], pos, &result[i * CHANNELS]);
+	}
+	return result;
+}
+
+TEST_CASE("ResampleFilter: implementations")
+{
+	CHECK(ResampleFilter::isSupported(Impl::PORTABLE));
+	CHECK(ResampleFilter::isSupported(ResampleFilter::getBest()));
+
+	std::mt19937 rng(42); // deterministic
+	std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+	std::vector<float> input(2 * 2000);
+	std::ranges::generate(input, [&] { return dist(rng); });
+
+	for (auto ratio : ratios) {
+		for (auto quality : allQualities) {
+			ResampleFilter ref(ratio, quality, Impl::PORTABLE);
+			auto expected1 = resample<1>(ref, input, 0.0, ratio, 500);
+			auto expected2 = resample<2>(ref, input, 0.0, ratio, 500);
+			for (auto impl : allImpls) {
+				if (!ResampleFilter::isSupported(impl)) continue;
+				INFO("ratio: " << ratio << "  quality: " << getName(quality) << "  impl: " << getName(impl));
+				ResampleFilter filter(ratio, quality, impl);
+				REQUIRE(filter.getFilterLen() == ref.getFilterLen());
+				REQUIRE(filter.getDelay() == ref.getDelay());
+				auto actual1 = resample<1>(filter, input, 0.0, ratio, 500);
+				auto actual2 = resample<2>(filter, input, 0.0, ratio, 500);
+				// only the summation order and the (fused) multiply-add
+				// rounding may differ
+				for (auto i : xrange(expected1.size())) {
+					CHECK(std::abs(expected1[i] - actual1[i]) <= 1e-5f);
+				}
+				for (auto i : xrange(expected2.size())) {
+					CHECK(std::abs(expected2[i] - actual2[i]) <= 1e-5f);
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE("ResampleFilter: quality")
+{
+	// Resample a sine wave and compare with the exact result. For ratios > 1
+	// the filter cut-off frequency lies (slightly below) the output Nyquist
+	// frequency, otherwise at the input Nyquist frequency.
+	auto check = [](double ratio, double freq, double maxErrHigh, double maxErrMedium) {
+		// 'freq' is relative to the output sample rate (1.0 = sample rate)
+		double w = 2 * Math::pi * freq / ratio; // per input sample
+		std::vector<float> input(3000);
+		for (auto i : xrange(input.size())) input[i] = float(sin(w * double(i)));
+
+		double maxErrs[2];
+		for (auto q : xrange(2)) {
+			ResampleFilter filter(ratio, allQualities[q], Impl::PORTABLE);
+			double start = 0.3;
+			size_t num = 400;
+			auto output = resample<1>(filter, input, start, ratio, num);
+			double maxErr = 0.0;
+			for (auto i : xrange(num)) {
+				double pos = double(float(start + double(i) * ratio));
+				double expected = sin(w * (pos + double(filter.getDelay())));
+				maxErr = std::max(maxErr, std::abs(expected - double(output[i])));
+			}
+			maxErrs[q] = maxErr;
+		}
+		INFO("ratio: " << ratio << "  freq: " << freq);
+		CHECK(maxErrs[0] <= maxErrHigh);
+		CHECK(maxErrs[1] <= maxErrMedium);
+	};
+	// The bounds are the measured errors, rounded up. The error of the
+	// medium quality filter only becomes (much) larger close to the cut-off
+	// frequency.
+	//   ratio                   freq   high    medium
+	check(3579545.0 / 32 / 44100, 0.01, 2e-5,  2e-5);
+	check(3579545.0 / 32 / 44100, 0.1,  1e-4,  1e-4);
+	check(3579545.0 / 32 / 44100, 0.3,  3e-4,  2e-2);
+	check(44100.0 / 48000,        0.01, 3e-5,  3e-5);
+	check(44100.0 / 48000,        0.2,  5e-4,  5e-4);
+	check(0.5,                    0.1,  3e-4,  3e-4);
+}
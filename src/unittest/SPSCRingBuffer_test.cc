@@ -0,0 +1,88 @@
+#include "catch.hpp"
+#include "SPSCRingBuffer.hh"
+
+#include "xrange.hh"
+
+#include <array>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+using namespace openmsx;
+
+TEST_CASE("SPSCRingBuffer: single thread")
+{
+	SPSCRingBuffer<int> buf(6);
+	CHECK(buf.capacity() == 8); // rounded up to power of 2
+	CHECK(buf.size() == 0);
+
+	std::array<int, 5> in = {1, 2, 3, 4, 5};
+	CHECK(buf.write(in) == 5);
+	CHECK(buf.size() == 5);
+	CHECK(buf.write(in) == 3); // only partially fits
+	CHECK(buf.size() == 8);
+	CHECK(buf.write(in) == 0);
+
+	std::array<int, 6> out = {};
+	CHECK(buf.read(out) == 6);
+	CHECK(out == std::array{1, 2, 3, 4, 5, 1});
+	CHECK(buf.size() == 2);
+
+	// wraps around the end of the storage
+	CHECK(buf.write(in) == 5);
+	CHECK(buf.read(out) == 6);
+	CHECK(out == std::array{2, 3, 1, 2, 3, 4});
+	CHECK(buf.read(out) == 1);
+	CHECK(out[0] == 5);
+	CHECK(buf.read(out) == 0);
+
+	// limit the fill level
+	CHECK(buf.write(in, 3) == 3);
+	CHECK(buf.write(in, 3) == 0);
+	CHECK(buf.write(in, 4) == 1);
+	CHECK(buf.size() == 4);
+
+	buf.clear();
+	CHECK(buf.size() == 0);
+	CHECK(buf.read(out) == 0);
+}
+
+TEST_CASE("SPSCRingBuffer: two threads")
+{
+	// Pass a sequence of numbers through a small buffer in chunks of
+	// different sizes, the consumer must receive them in order.
+	static constexpr unsigned N = 200'000;
+	SPSCRingBuffer<unsigned> buf(64);
+
+	std::thread producer([&] {
+		std::vector<unsigned> chunk;
+		unsigned next = 0;
+		unsigned size = 1;
+		while (next < N) {
+			chunk.resize(std::min(size, N - next));
+			std::iota(chunk.begin(), chunk.end(), next);
+			std::span<const unsigned> todo = chunk;
+			while (!todo.empty()) {
+				todo = todo.subspan(buf.write(todo));
+			}
+			next += unsigned(chunk.size());
+			size = (size % 37) + 1;
+		}
+	});
+
+	std::vector<unsigned> received;
+	received.reserve(N);
+	std::array<unsigned, 23> out;
+	while (received.size() < N) {
+		auto num = buf.read(out);
+		received.insert(received.end(), out.begin(), out.begin() + num);
+	}
+	producer.join();
+
+	CHECK(buf.size() == 0);
+	bool inOrder = true;
+	for (auto i : xrange(N)) {
+		if (received[i] != i) inOrder = false;
+	}
+	CHECK(inOrder);
+}
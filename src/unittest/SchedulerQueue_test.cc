@@ -0,0 +1,225 @@
+#include "catch.hpp"
+
+#include "SchedulerHeap.hh"
+#include "SchedulerQueue.hh"
+
+#include "xrange.hh"
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace openmsx;
+
+// A simplified sync point: a (device, time) pair.
+struct SP {
+	uint64_t time = 0;
+	unsigned device = 0;
+};
+
+struct LessSP {
+	bool operator()(const SP& x, const SP& y) const { return x.time < y.time; }
+};
+
+// Gives SchedulerQueue and SchedulerHeap the same interface (the one used by
+// the Scheduler).
+struct SortedQueue {
+	SchedulerQueue<SP> q;
+
+	void insert(const SP& sp) {
+		q.insert(sp,
+		         [](SP& s) { s.time = std::numeric_limits<uint64_t>::max(); },
+		         LessSP{});
+	}
+	[[nodiscard]] const SP& front() const { return q.front(); }
+	void removeFront() { q.remove_front(); }
+	bool remove(unsigned device) {
+		return q.remove([&](const SP& s) { return s.device == device; });
+	}
+	[[nodiscard]] bool empty() const { return q.empty(); }
+};
+
+struct HeapQueue {
+	SchedulerHeap<SP, LessSP> q;
+
+	void insert(const SP& sp) { q.insert(sp); }
+	[[nodiscard]] const SP& front() const { return q.front(); }
+	void removeFront() { q.remove_front(); }
+	bool remove(unsigned device) {
+		return q.remove([&](const SP& s) { return s.device == device; });
+	}
+	[[nodiscard]] bool empty() const { return q.empty(); }
+};
+
+// A trace of scheduler operations.
+struct Op {
+	enum Type : uint8_t { INSERT, REMOVE, EXECUTE };
+	Type type;
+	unsigned device;
+	uint64_t time; // only for INSERT
+};
+using Trace = std::vector<Op>;
+
+// Generate a trace that resembles the sync point activity of a running
+// machine: 'numDevices' devices that each periodically reschedule themselves
+// (with widely varying periods, like the VDP line interrupts, PSG/FM timers,
+// FDC, RS232, MIDI, ...). And occasionally a device gets reprogrammed: its
+// pending sync point is removed and a new one is set (like what happens
+// when the CPU writes to a device).
+static Trace generateTrace(unsigned numDevices, unsigned numSteps)
+{
+	std::mt19937 rng(numDevices); // deterministic
+	std::vector<uint64_t> periods(numDevices);
+	std::uniform_int_distribution<uint64_t> periodDist(100, 100'000);
+	for (auto& p : periods) p = periodDist(rng);
+
+	HeapQueue q; // to know which device executes next
+	Trace trace;
+	for (auto d : xrange(numDevices)) {
+		trace.push_back({Op::INSERT, d, periods[d]});
+		q.insert({periods[d], d});
+	}
+	std::uniform_int_distribution<unsigned> deviceDist(0, numDevices - 1);
+	std::uniform_int_distribution<unsigned> percent(0, 99);
+	repeat(numSteps, [&] {
+		auto sp = q.front();
+		q.removeFront();
+		trace.push_back({Op::EXECUTE, sp.device, 0});
+		auto next = sp.time + periods[sp.device];
+		trace.push_back({Op::INSERT, sp.device, next});
+		q.insert({next, sp.device});
+
+		if (percent(rng) < 20) {
+			auto d = deviceDist(rng);
+			trace.push_back({Op::REMOVE, d, 0});
+			REQUIRE(q.remove(d));
+			auto t = sp.time + periods[d] / 2;
+			trace.push_back({Op::INSERT, d, t});
+			q.insert({t, d});
+		}
+	});
+	return trace;
+}
+
+// Replay a trace, returns a checksum of the execution order.
+template<typename Queue>
+static uint64_t replay(const Trace& trace)
+{
+	Queue q;
+	uint64_t result = 0;
+	for (const auto& op : trace) {
+		switch (op.type) {
+		case Op::INSERT:
+			q.insert({op.time, op.device});
+			break;
+		case Op::REMOVE:
+			q.remove(op.device);
+			break;
+		case Op::EXECUTE:
+			result = result * 31 + q.front().device;
+			q.removeFront();
+			break;
+		}
+	}
+	return result;
+}
+
+template<typename Queue>
+static void checkOrder()
+{
+	Queue q;
+	CHECK(q.empty());
+	// equal times must be returned in insertion order
+	q.insert({20, 0});
+	q.insert({10, 1});
+	q.insert({20, 2});
+	q.insert({10, 3});
+	q.insert({30, 4});
+	q.insert({20, 5});
+	CHECK(q.remove(2));
+	CHECK(!q.remove(2));
+	for (unsigned expected : {1, 3, 0, 5, 4}) {
+		REQUIRE(!q.empty());
+		CHECK(q.front().device == expected);
+		q.removeFront();
+	}
+	CHECK(q.empty());
+}
+
+TEST_CASE("SchedulerQueue: order")
+{
+	checkOrder<SortedQueue>();
+	checkOrder<HeapQueue>();
+}
+
+// remove() must remove the earliest matching element (this matters when a
+// device has multiple sync points)
+template<typename Queue>
+static void checkRemoveEarliest()
+{
+	Queue q;
+	q.insert({50, 0});
+	q.insert({40, 1});
+	q.insert({30, 0});
+	q.insert({60, 2});
+	q.insert({20, 0});
+	q.insert({10, 3});
+	q.insert({40, 0});
+	CHECK(q.remove(0)); // removes {20, 0}
+	CHECK(q.remove(0)); // removes {30, 0}
+	for (auto [time, device] : {std::pair{10, 3}, {40, 1}, {40, 0}, {50, 0}, {60, 2}}) {
+		REQUIRE(!q.empty());
+		CHECK(q.front().time == uint64_t(time));
+		CHECK(q.front().device == unsigned(device));
+		q.removeFront();
+	}
+	CHECK(q.empty());
+}
+
+TEST_CASE("SchedulerQueue: remove earliest")
+{
+	checkRemoveEarliest<SortedQueue>();
+	checkRemoveEarliest<HeapQueue>();
+}
+
+TEST_CASE("SchedulerHeap: sorted_if")
+{
+	// equal times must be returned in insertion order, not in heap order
+	SchedulerHeap<SP, LessSP> q;
+	for (auto i : xrange(20u)) q.insert({(i * 7) % 4, i});
+	auto sorted = q.sorted_if([](const SP& s) { return (s.device % 3) != 0; });
+	REQUIRE(sorted.size() == 13);
+	for (auto i : xrange(size_t(1), sorted.size())) {
+		const auto& prev = sorted[i - 1];
+		const auto& curr = sorted[i];
+		CHECK(curr.device % 3 != 0);
+		CHECK(((prev.time < curr.time) ||
+		       ((prev.time == curr.time) && (prev.device < curr.device))));
+	}
+}
+
+TEST_CASE("SchedulerHeap: remove_all")
+{
+	SchedulerHeap<SP, LessSP> q;
+	for (auto i : xrange(20u)) q.insert({i % 7, i % 3});
+	q.remove_all([](const SP& s) { return s.device == 1; });
+	CHECK(q.size() == 13);
+	uint64_t prev = 0;
+	while (!q.empty()) {
+		CHECK(q.front().device != 1);
+		CHECK(q.front().time >= prev);
+		prev = q.front().time;
+		q.remove_front();
+	}
+}
+
+TEST_CASE("SchedulerQueue: replay trace")
+{
+	// both implementations must execute the sync points in the same order
+	for (unsigned numDevices : {1, 5, 16, 64}) {
+		auto trace = generateTrace(numDevices, 10'000);
+		CHECK(replay<SortedQueue>(trace) == replay<HeapQueue>(trace));
+	}
+}
@@ -0,0 +1,129 @@
+#include "catch.hpp"
+#include "SpriteLineMasks.hh"
+
+#include "xrange.hh"
+
+#include <array>
+#include <cstdint>
+#include <random>
+
+using namespace openmsx;
+
+namespace {
+
+// The sprite attribute state that's relevant for SpriteLineMasks.
+struct Attributes {
+	std::array<uint8_t, 32> ys = {};
+	unsigned count = 0;
+	unsigned magSize = 8;
+};
+
+// Straightforward calculation, this follows the (old) SpriteChecker code
+// that scanned the sprite attribute table for each check.
+uint32_t calcMask(const Attributes& a, int displayLine)
+{
+	uint32_t result = 0;
+	for (auto sprite : xrange(a.count)) {
+		auto spriteLine = unsigned((displayLine - a.ys[sprite]) & 0xFF);
+		if (spriteLine < a.magSize) result |= uint32_t(1) << sprite;
+	}
+	return result;
+}
+
+bool allLinesMatch(const SpriteLineMasks& masks, const Attributes& a)
+{
+	for (auto line : xrange(256)) {
+		if (masks.getMask(line) != calcMask(a, line)) return false;
+	}
+	return true;
+}
+
+} // namespace
+
+TEST_CASE("SpriteLineMasks: basic")
+{
+	SpriteLineMasks masks;
+	CHECK(masks.getMagSize() == 0);
+	for (auto line : xrange(256)) CHECK(masks.getMask(line) == 0);
+
+	Attributes a;
+	a.ys[0] = 10;
+	a.ys[1] = 250; // wraps around
+	a.ys[2] = 10;
+	a.count = 2;   // sprite 2 is not active
+	masks.update(a.ys, a.count, a.magSize);
+	CHECK(masks.getMagSize() == 8);
+	CHECK(masks.getMask(9) == 0);
+	CHECK(masks.getMask(10) == 0b01);
+	CHECK(masks.getMask(17) == 0b01);
+	CHECK(masks.getMask(18) == 0);
+	CHECK(masks.getMask(250) == 0b10);
+	CHECK(masks.getMask(1) == 0b10);
+	CHECK(masks.getMask(2) == 0);
+	CHECK(masks.getMask(-5) == 0b10); // taken modulo 256
+	CHECK(masks.getY(1) == 250);
+
+	// move one sprite, activate another
+	a.ys[0] = 12;
+	a.count = 3;
+	masks.update(a.ys, a.count, a.magSize);
+	CHECK(masks.getMask(10) == 0b100);
+	CHECK(masks.getMask(12) == 0b101);
+	CHECK(masks.getMask(19) == 0b001);
+	CHECK(allLinesMatch(masks, a));
+
+	// change the size
+	a.magSize = 32;
+	masks.update(a.ys, a.count, a.magSize);
+	CHECK(masks.getMask(41) == 0b101);
+	CHECK(masks.getMask(44) == 0);
+	CHECK(allLinesMatch(masks, a));
+}
+
+TEST_CASE("SpriteLineMasks: random traces")
+{
+	// Apply random sequences of changes to the sprite attributes (like a
+	// game would do when moving sprites around) and after each update
+	// compare all lines with the straightforward calculation.
+	static constexpr std::array magSizes = {8u, 16u, 32u};
+	std::mt19937 rng(1234); // deterministic
+	auto random = [&](unsigned n) { return unsigned(rng() % n); };
+
+	for (auto trace : xrange(50)) {
+		SpriteLineMasks masks;
+		Attributes a;
+		a.count = random(33);
+		a.magSize = magSizes[random(3)];
+		for (auto& y : a.ys) y = uint8_t(rng());
+
+		bool ok = true;
+		for (auto step : xrange(200)) {
+			// Possibly several changes between two updates.
+			for (auto n = random(4); n--; /**/) {
+				switch (random(8)) {
+				case 0: // terminator moves
+					a.count = random(33);
+					break;
+				case 1: // other size or magnification
+					a.magSize = magSizes[random(3)];
+					break;
+				case 2: // rewrite the whole table
+					for (auto& y : a.ys) y = uint8_t(rng());
+					break;
+				default: { // small move of one sprite
+					auto& y = a.ys[random(32)];
+					y = uint8_t(y + random(7) - 3);
+					break;
+				}
+				}
+			}
+			masks.update(a.ys, a.count, a.magSize);
+			if (!allLinesMatch(masks, a)) {
+				INFO("trace " << trace << " step " << step);
+				ok = false;
+				break;
+			}
+		}
+		CHECK(ok);
+	}
+}
@@ -2,6 +2,9 @@
 
 #include "lz4.hh"
 #include "ranges.hh"
+#include "unreachable.hh"
+
+#include <zlib.h>
 
 #include <algorithm>
 #include <bit>
@@ -13,6 +16,14 @@
 #endif
 #ifdef __SSE2__
 #include <emmintrin.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define DELTA_BLOCK_AVX2
+#endif
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define DELTA_BLOCK_NEON
 #endif
 
 namespace openmsx {
@@ -46,8 +57,18 @@ static void storeUleb(std::vector<uint8_t>& result, size_t value)
 }
 
 
-// --- Helper functions to compare {4,8,16} bytes at aligned memory locations ---
+// --- Instruction set specific scan functions ---
+
+// calcDelta() below spends nearly all of its time in two scan functions:
+// - mismatch(): like std::mismatch(), find the first position where the two
+//   buffers differ (or the end of the buffers).
+// - match(): the opposite, find the first position where the two buffers have
+//   equal bytes (or the end).
+// There are several implementations of these functions, they all return the
+// exact same result. calcDelta() is instantiated for each of them, and the
+// fastest one supported by the host CPU is selected at run-time.
 
+// Helper functions to compare {4,8} bytes at aligned memory locations.
 template<int N> bool comp(const uint8_t* p, const uint8_t* q);
 
 template<> bool comp<4>(const uint8_t* p, const uint8_t* q)
@@ -62,118 +83,216 @@ template<> bool comp<8>(const uint8_t* p, const uint8_t* q)
 	       *std::bit_cast<const uint64_t*>(q);
 }
 
-#ifdef __SSE2__
-template<> bool comp<16>(const uint8_t* p, const uint8_t* q)
+// Portable implementation, works word-at-a-time.
+struct ScanScalar
 {
-	// Tests show that (on my machine) using 1 128-bit load is faster than
-	// 2 64-bit loads. Even though the actual comparison is slightly more
-	// complicated with SSE instructions.
-	__m128i a = _mm_loadu_si128(std::bit_cast<const __m128i*>(p));
-	__m128i b = _mm_loadu_si128(std::bit_cast<const __m128i*>(q));
-	__m128i d = _mm_cmpeq_epi8(a, b);
-	return _mm_movemask_epi8(d) == 0xffff;
-}
-#endif
+	// Compared to std::mismatch() this implementation is faster because:
+	// - We make use of sentinels. This requires to temporarily change the
+	//   content of the buffer. So it won't work with read-only-memory.
+	// - We compare words-at-a-time instead of byte-at-a-time.
+	static std::pair<const uint8_t*, const uint8_t*> mismatch(
+		const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end)
+	{
+		assert((p_end - p) == (q_end - q));
 
+		constexpr ptrdiff_t WORD_SIZE = sizeof(void*);
 
-// --- Optimized mismatch function ---
+		// Region too small or
+		// both buffers are differently aligned.
+		if (((p_end - p) < (2 * WORD_SIZE)) ||
+		    ((std::bit_cast<uintptr_t>(p) & (WORD_SIZE - 1)) !=
+		     (std::bit_cast<uintptr_t>(q) & (WORD_SIZE - 1)))) [[unlikely]] {
+			goto end;
+		}
 
-// This is much like the function std::mismatch(). You pass in two buffers,
-// the corresponding elements of both buffers are compared and the first
-// position where the elements no longer match is returned.
-//
-// Compared to the std::mismatch() this implementation is faster because:
-// - We make use of sentinels. This requires to temporarily change the content
-//   of the buffer. So it won't work with read-only-memory.
-// - We compare words-at-a-time instead of byte-at-a-time.
-static std::pair<const uint8_t*, const uint8_t*> scan_mismatch(
-	const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end)
-{
-	assert((p_end - p) == (q_end - q));
+		// Align to WORD_SIZE boundary. No need for end-of-buffer checks.
+		if (std::bit_cast<uintptr_t>(p) & (WORD_SIZE - 1)) [[unlikely]] {
+			do {
+				if (*p != *q) return {p, q};
+				p += 1; q += 1;
+			} while (std::bit_cast<uintptr_t>(p) & (WORD_SIZE - 1));
+		}
 
-	// When SSE is available, work with 16-byte words, otherwise 4 or 8
-	// bytes. This routine also benefits from AVX2 instructions. Though not
-	// all x86_64 CPUs have AVX2 (all have SSE2), so using them requires
-	// extra run-time checks and that's not worth it at this point.
-	constexpr ptrdiff_t WORD_SIZE =
-#ifdef __SSE2__
-		sizeof(__m128i);
-#else
-		sizeof(void*);
-#endif
+		// Fast path. Compare words-at-a-time.
+		{
+			// Place a sentinel in the last full word. This ensures
+			// we'll find a mismatch within the buffer, and so we
+			// can omit the end-of-buffer checks.
+			auto* sentinel = &const_cast<uint8_t*>(p_end)[-WORD_SIZE];
+			auto save = *sentinel;
+			*sentinel = ~q_end[-WORD_SIZE];
+
+			while (comp<WORD_SIZE>(p, q)) {
+				p += WORD_SIZE; q += WORD_SIZE;
+			}
+
+			// Restore sentinel.
+			*sentinel = save;
+		}
 
-	// Region too small or
-	// both buffers are differently aligned.
-	if (((p_end - p) < (2 * WORD_SIZE)) ||
-	    ((std::bit_cast<uintptr_t>(p) & (WORD_SIZE - 1)) !=
-	     (std::bit_cast<uintptr_t>(q) & (WORD_SIZE - 1)))) [[unlikely]] {
-		goto end;
+		// Slow path. This handles:
+		// - Small or differently aligned buffers.
+		// - The bytes at and after the (restored) sentinel.
+	end:	return std::mismatch(p, p_end, q);
 	}
 
-	// Align to WORD_SIZE boundary. No need for end-of-buffer checks.
-	if (std::bit_cast<uintptr_t>(p) & (WORD_SIZE - 1)) [[unlikely]] {
-		do {
-			if (*p != *q) return {p, q};
-			p += 1; q += 1;
-		} while (std::bit_cast<uintptr_t>(p) & (WORD_SIZE - 1));
+	// Like mismatch(), this places a temporary sentinel in the buffer.
+	//
+	// Unlike mismatch() it's less obvious how to perform this function
+	// word-at-a-time (it's possible with some bit hacks). Though luckily
+	// this function is also less performance critical.
+	static std::pair<const uint8_t*, const uint8_t*> match(
+		const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end)
+	{
+		assert((p_end - p) == (q_end - q));
+
+		// Code below is functionally equivalent to:
+		//   while ((p != p_end) && (*p != *q)) { ++p; ++q; }
+		//   return {p, q};
+
+		if (p == p_end) return {p, q};
+
+		auto* p_last = const_cast<uint8_t*>(p_end - 1);
+		auto save = *p_last;
+		*p_last = q_end[-1]; // make p_end[-1] == q_end[-1]
+
+		while (*p != *q) { ++p; ++q; }
+
+		*p_last = save;
+		if ((p == p_last) && (*p != *q)) { ++p; ++q; }
+		return {p, q};
 	}
+};
 
-	// Fast path. Compare words-at-a-time.
+// The SIMD implementations don't need sentinels nor equally aligned buffers:
+// they compare a full vector at a time using unaligned loads, turn the result
+// into a bitmask and locate the first (mis)matching byte in that mask.
+#ifdef __SSE2__
+struct ScanSSE2
+{
+	static constexpr ptrdiff_t VEC_SIZE = sizeof(__m128i);
+
+	[[nodiscard]] static unsigned equalMask(const uint8_t* p, const uint8_t* q)
 	{
-		// Place a sentinel in the last full word. This ensures we'll
-		// find a mismatch within the buffer, and so we can omit the
-		// end-of-buffer checks.
-		auto* sentinel = &const_cast<uint8_t*>(p_end)[-WORD_SIZE];
-		auto save = *sentinel;
-		*sentinel = ~q_end[-WORD_SIZE];
-
-		while (comp<WORD_SIZE>(p, q)) {
-			p += WORD_SIZE; q += WORD_SIZE;
-		}
+		__m128i a = _mm_loadu_si128(std::bit_cast<const __m128i*>(p));
+		__m128i b = _mm_loadu_si128(std::bit_cast<const __m128i*>(q));
+		return unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)));
+	}
 
-		// Restore sentinel.
-		*sentinel = save;
+	static std::pair<const uint8_t*, const uint8_t*> mismatch(
+		const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* /*q_end*/)
+	{
+		while ((p_end - p) >= VEC_SIZE) {
+			if (auto m = equalMask(p, q) ^ 0xffff) {
+				auto i = std::countr_zero(m);
+				return {p + i, q + i};
+			}
+			p += VEC_SIZE; q += VEC_SIZE;
+		}
+		return std::mismatch(p, p_end, q);
 	}
 
-	// Slow path. This handles:
-	// - Small or differently aligned buffers.
-	// - The bytes at and after the (restored) sentinel.
-end:	return std::mismatch(p, p_end, q);
-}
+	static std::pair<const uint8_t*, const uint8_t*> match(
+		const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* /*q_end*/)
+	{
+		while ((p_end - p) >= VEC_SIZE) {
+			if (auto m = equalMask(p, q)) {
+				auto i = std::countr_zero(m);
+				return {p + i, q + i};
+			}
+			p += VEC_SIZE; q += VEC_SIZE;
+		}
+		while ((p != p_end) && (*p != *q)) { ++p; ++q; }
+		return {p, q};
+	}
+};
+#endif
 
+// Not all x86_64 CPUs have AVX2, so these functions are compiled for that
+// instruction set separately, and only called after a run-time check.
+#ifdef DELTA_BLOCK_AVX2
+struct ScanAVX2
+{
+	static constexpr ptrdiff_t VEC_SIZE = sizeof(__m256i);
 
-// --- Optimized scan_match function ---
+	[[nodiscard]] [[gnu::target("avx2")]] static unsigned equalMask(const uint8_t* p, const uint8_t* q)
+	{
+		__m256i a = _mm256_loadu_si256(std::bit_cast<const __m256i*>(p));
+		__m256i b = _mm256_loadu_si256(std::bit_cast<const __m256i*>(q));
+		return unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+	}
 
-// Like scan_mismatch() above, but searches two buffers for the first
-// corresponding equal (instead of not-equal) bytes.
-//
-// Like scan_mismatch(), this places a temporary sentinel in the buffer, so the
-// buffer cannot be read-only memory.
-//
-// Unlike scan_mismatch() it's less obvious how to perform this function
-// word-at-a-time (it's possible with some bit hacks). Though luckily this
-// function is also less performance critical.
-[[nodiscard]] static constexpr std::pair<const uint8_t*, const uint8_t*> scan_match(
-	const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end)
-{
-	assert((p_end - p) == (q_end - q));
+	[[gnu::target("avx2")]] static std::pair<const uint8_t*, const uint8_t*> mismatch(
+		const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end)
+	{
+		while ((p_end - p) >= VEC_SIZE) {
+			if (auto m = ~equalMask(p, q)) {
+				auto i = std::countr_zero(m);
+				return {p + i, q + i};
+			}
+			p += VEC_SIZE; q += VEC_SIZE;
+		}
+		return ScanSSE2::mismatch(p, p_end, q, q_end);
+	}
 
-	// Code below is functionally equivalent to:
-	//   while ((p != p_end) && (*p != *q)) { ++p; ++q; }
-	//   return {p, q};
+	[[gnu::target("avx2")]] static std::pair<const uint8_t*, const uint8_t*> match(
+		const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end)
+	{
+		while ((p_end - p) >= VEC_SIZE) {
+			if (auto m = equalMask(p, q)) {
+				auto i = std::countr_zero(m);
+				return {p + i, q + i};
+			}
+			p += VEC_SIZE; q += VEC_SIZE;
+		}
+		return ScanSSE2::match(p, p_end, q, q_end);
+	}
+};
+#endif
 
-	if (p == p_end) return {p, q};
+#ifdef DELTA_BLOCK_NEON
+struct ScanNEON
+{
+	static constexpr ptrdiff_t VEC_SIZE = sizeof(uint8x16_t);
 
-	auto* p_last = const_cast<uint8_t*>(p_end - 1);
-	auto save = *p_last;
-	*p_last = q_end[-1]; // make p_end[-1] == q_end[-1]
+	// NEON has no movemask instruction. Instead narrow each 0x00/0xff
+	// comparison byte to a nibble, that gives a 64-bit mask with 4 bits
+	// per byte.
+	[[nodiscard]] static uint64_t equalMask(const uint8_t* p, const uint8_t* q)
+	{
+		uint8x16_t eq = vceqq_u8(vld1q_u8(p), vld1q_u8(q));
+		uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+		return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+	}
 
-	while (*p != *q) { ++p; ++q; }
+	static std::pair<const uint8_t*, const uint8_t*> mismatch(
+		const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* /*q_end*/)
+	{
+		while ((p_end - p) >= VEC_SIZE) {
+			if (auto m = ~equalMask(p, q)) {
+				auto i = std::countr_zero(m) / 4;
+				return {p + i, q + i};
+			}
+			p += VEC_SIZE; q += VEC_SIZE;
+		}
+		return std::mismatch(p, p_end, q);
+	}
 
-	*p_last = save;
-	if ((p == p_last) && (*p != *q)) { ++p; ++q; }
-	return {p, q};
-}
+	static std::pair<const uint8_t*, const uint8_t*> match(
+		const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* /*q_end*/)
+	{
+		while ((p_end - p) >= VEC_SIZE) {
+			if (auto m = equalMask(p, q)) {
+				auto i = std::countr_zero(m) / 4;
+				return {p + i, q + i};
+			}
+			p += VEC_SIZE; q += VEC_SIZE;
+		}
+		while ((p != p_end) && (*p != *q)) { ++p; ++q; }
+		return {p, q};
+	}
+};
+#endif
 
 
 // --- delta (de)compression routines ---
@@ -184,38 +303,42 @@ end:	return std::mismatch(p, p_end, q);
 //   n2 number of bytes are different, and here are the bytes
 //   n3 number of bytes are equal
 //   ...
-[[nodiscard]] static std::vector<uint8_t> calcDelta(
-	const uint8_t* oldBuf, std::span<const uint8_t> newBuf)
+// The scan functions may temporarily place sentinels in 'newBuf', the
+// reference buffer 'oldBuf' is only read. So several deltas against the same
+// reference can be calculated concurrently.
+template<typename Scan>
+[[nodiscard]] static std::vector<uint8_t> calcDeltaImpl(
+	std::span<uint8_t> newBuf, const uint8_t* oldBuf)
 {
 	std::vector<uint8_t> result;
 
-	const auto* p = oldBuf;
-	const auto* q = newBuf.data();
+	const auto* p = newBuf.data();
+	const auto* q = oldBuf;
 	auto size = newBuf.size();
 	const auto* p_end = p + size;
 	const auto* q_end = q + size;
 
 	// scan equal bytes (possibly zero)
-	const auto* q1 = q;
-	std::tie(p, q) = scan_mismatch(p, p_end, q, q_end);
-	auto n1 = q - q1;
+	const auto* p1 = p;
+	std::tie(p, q) = Scan::mismatch(p, p_end, q, q_end);
+	auto n1 = p - p1;
 	storeUleb(result, n1);
 
-	while (q != q_end) {
+	while (p != p_end) {
 		assert(*p != *q);
 
-		const auto* q2 = q;
+		const auto* p2 = p;
 	different:
-		std::tie(p, q) = scan_match(p + 1, p_end, q + 1, q_end);
-		auto n2 = q - q2;
+		std::tie(p, q) = Scan::match(p + 1, p_end, q + 1, q_end);
+		auto n2 = p - p2;
 
-		const auto* q3 = q;
-		std::tie(p, q) = scan_mismatch(p, p_end, q, q_end);
-		auto n3 = q - q3;
-		if ((q != q_end) && (n3 <= 2)) goto different;
+		const auto* p3 = p;
+		std::tie(p, q) = Scan::mismatch(p, p_end, q, q_end);
+		auto n3 = p - p3;
+		if ((p != p_end) && (n3 <= 2)) goto different;
 
 		storeUleb(result, n2);
-		result.insert(result.end(), q2, q3);
+		result.insert(result.end(), p2, p3);
 
 		if (n3 != 0) storeUleb(result, n3);
 	}
@@ -224,8 +347,71 @@ end:	return std::mismatch(p, p_end, q);
 	return result;
 }
 
+namespace DeltaEncoder {
+
+bool isSupported(ISA isa)
+{
+	switch (isa) {
+	case ISA::SCALAR:
+		return true;
+	case ISA::SSE2:
+#ifdef __SSE2__
+		return true;
+#else
+		return false;
+#endif
+	case ISA::AVX2:
+#ifdef DELTA_BLOCK_AVX2
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	case ISA::NEON:
+#ifdef DELTA_BLOCK_NEON
+		return true;
+#else
+		return false;
+#endif
+	default:
+		UNREACHABLE;
+	}
+}
+
+ISA getBest()
+{
+	for (auto isa : {ISA::AVX2, ISA::SSE2, ISA::NEON}) {
+		if (isSupported(isa)) return isa;
+	}
+	return ISA::SCALAR;
+}
+
+std::vector<uint8_t> calc(ISA isa, std::span<uint8_t> newBuf, const uint8_t* oldBuf)
+{
+	assert(isSupported(isa));
+	switch (isa) {
+	case ISA::SCALAR:
+		return calcDeltaImpl<ScanScalar>(newBuf, oldBuf);
+#ifdef __SSE2__
+	case ISA::SSE2:
+		return calcDeltaImpl<ScanSSE2>(newBuf, oldBuf);
+#endif
+#ifdef DELTA_BLOCK_AVX2
+	case ISA::AVX2:
+		return calcDeltaImpl<ScanAVX2>(newBuf, oldBuf);
+#endif
+#ifdef DELTA_BLOCK_NEON
+	case ISA::NEON:
+		return calcDeltaImpl<ScanNEON>(newBuf, oldBuf);
+#endif
+	default:
+		UNREACHABLE;
+	}
+}
+
+} // namespace DeltaEncoder
+
 // Apply a previously calculated 'delta' to 'oldBuf' to get 'newbuf'.
-static void applyDeltaInPlace(std::span<uint8_t> buf, std::span<const uint8_t> delta)
+void DeltaEncoder::apply(std::span<uint8_t> buf, std::span<const uint8_t> delta)
 {
 	while (!buf.empty()) {
 		auto n1 = loadUleb(delta);
@@ -255,7 +441,8 @@ DeltaBlock::~DeltaBlock()
 // class DeltaBlockCopy
 
 DeltaBlockCopy::DeltaBlockCopy(std::span<const uint8_t> data)
-	: block(data.size())
+	: DeltaBlock(data.size())
+	, block(data.size())
 {
 #ifdef DEBUG
 	sha1 = SHA1::calc(data);
@@ -272,7 +459,12 @@ DeltaBlockCopy::DeltaBlockCopy(std::span<const uint8_t> data)
 
 void DeltaBlockCopy::apply(std::span<uint8_t> dst) const
 {
-	if (compressed()) {
+	if (zlibCompressed) {
+		auto dstLen = uLongf(dst.size());
+		[[maybe_unused]] int r = uncompress(dst.data(), &dstLen, block.data(), uLong(compressedSize));
+		assert(r == Z_OK);
+		assert(dstLen == dst.size());
+	} else if (compressed()) {
 		LZ4::decompress(block.data(), dst.data(), int(compressedSize), int(dst.size()));
 	} else {
 		copy_to_range(std::span{block.data(), dst.size()}, dst);
@@ -312,6 +504,30 @@ void DeltaBlockCopy::compress(size_t size)
 #endif
 }
 
+void DeltaBlockCopy::recompress()
+{
+	if (!canRecompress()) return;
+	recompressed = true; // also when not beneficial: don't try again
+
+	auto size = getRawSize();
+	MemBuffer<uint8_t> raw(size);
+	apply(raw);
+
+	auto dstLen = compressBound(uLong(size));
+	MemBuffer<uint8_t> buf2(dstLen);
+	if ((compress2(buf2.data(), &dstLen, raw.data(), uLong(size), 6) != Z_OK) ||
+	    (dstLen >= compressedSize)) {
+		return;
+	}
+	compressedSize = dstLen;
+	zlibCompressed = true;
+	std::swap(block, buf2);
+	block.resize(compressedSize); // shrink to fit
+#ifdef DEBUG
+	apply(raw); // checks sha1
+#endif
+}
+
 const uint8_t* DeltaBlockCopy::getData()
 {
 	assert(!compressed());
@@ -324,16 +540,28 @@ const uint8_t* DeltaBlockCopy::getData()
 DeltaBlockDiff::DeltaBlockDiff(
 		std::shared_ptr<DeltaBlockCopy> prev_,
 		std::span<const uint8_t> data)
-	: prev(std::move(prev_))
-	, delta(calcDelta(prev->getData(), data))
+	: DeltaBlock(data.size())
+	, prev(std::move(prev_))
+	, newData(data.size())
 {
+	copy_to_range(data, std::span{newData});
+}
+
+void DeltaBlockDiff::calcDelta()
+{
+	if (calculated()) return;
+
+	static const auto isa = DeltaEncoder::getBest();
+	delta = DeltaEncoder::calc(isa, newData, prev->getData());
+	assert(calculated());
 #ifdef DEBUG
-	sha1 = SHA1::calc(data);
+	sha1 = SHA1::calc(newData);
 
-	MemBuffer<uint8_t> buf(data.size());
-	apply({buf.data(), data.size()});
-	assert(std::ranges::equal(std::span{buf.data(), data.size()}, data));
+	MemBuffer<uint8_t> buf(newData.size());
+	apply(buf);
+	assert(std::ranges::equal(buf, newData));
 #endif
+	newData = MemBuffer<uint8_t>(); // no longer needed
 #if STATISTICS
 	allocSize = delta.size();
 	globalAllocSize += allocSize;
@@ -344,8 +572,9 @@ DeltaBlockDiff::DeltaBlockDiff(
 
 void DeltaBlockDiff::apply(std::span<uint8_t> dst) const
 {
+	assert(calculated());
 	prev->apply(dst);
-	applyDeltaInPlace(dst, delta);
+	DeltaEncoder::apply(dst, delta);
 #ifdef DEBUG
 	assert(SHA1::calc(dst) == sha1);
 #endif
@@ -353,6 +582,7 @@ void DeltaBlockDiff::apply(std::span<uint8_t> dst) const
 
 size_t DeltaBlockDiff::getDeltaSize() const
 {
+	assert(calculated());
 	return delta.size();
 }
 
@@ -372,12 +602,17 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
 	assert(it->id   == id);
 	assert(it->size == size);
 
+	if (it->unaccounted) {
+		it->accSize += it->unaccounted->getDeltaSize();
+		it->unaccounted.reset();
+	}
+
 	auto ref = it->ref.lock();
 	if (it->accSize >= size || !ref) {
 		if (ref) {
 			// We will switch to a new DeltaBlockCopy object. So
 			// now is a good time to compress the old one.
-			ref->compress(size);
+			execute([ref, size] { ref->compress(size); });
 		}
 		// Heuristic: create a new block when too many small
 		// differences have accumulated.
@@ -391,7 +626,8 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
 		// Reference remains unchanged.
 		auto b = std::make_shared<DeltaBlockDiff>(ref, data);
 		it->last = b;
-		it->accSize += b->getDeltaSize();
+		it->unaccounted = b;
+		execute([b] { b->calcDelta(); });
 		return b;
 	}
 }
@@ -424,6 +660,7 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNullDiff(
 
 void LastDeltaBlocks::clear()
 {
+	assert(deferredWork.empty());
 	for (const Info& info : infos) {
 		if (auto ref = info.ref.lock()) {
 			ref->compress(info.size);
@@ -432,4 +669,18 @@ void LastDeltaBlocks::clear()
 	infos.clear();
 }
 
+std::vector<std::function<void()>> LastDeltaBlocks::takeDeferredWork()
+{
+	return std::exchange(deferredWork, {});
+}
+
+void LastDeltaBlocks::execute(std::function<void()> job)
+{
+	if (deferWork) {
+		deferredWork.push_back(std::move(job));
+	} else {
+		job();
+	}
+}
+
 } // namespace openmsx
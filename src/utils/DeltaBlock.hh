@@ -6,6 +6,7 @@
 #include "MemBuffer.hh"
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <span>
 #include <vector>
@@ -15,6 +16,30 @@
 
 namespace openmsx {
 
+/** Calculate and apply the 'delta' between two equally sized buffers.
+  * The delta encoder has several instruction set specific implementations,
+  * they all produce the exact same output. Normally the best one supported by
+  * the host CPU is used, the others are only exposed for unittests and
+  * benchmarks.
+  */
+namespace DeltaEncoder {
+	enum class ISA : uint8_t { SCALAR, SSE2, AVX2, NEON };
+
+	[[nodiscard]] bool isSupported(ISA isa);
+	[[nodiscard]] ISA getBest();
+
+	/** Note: 'newBuf' is temporarily modified (but restored before this
+	  * function returns), 'oldBuf' must have the same size as 'newBuf'.
+	  */
+	[[nodiscard]] std::vector<uint8_t> calc(
+		ISA isa, std::span<uint8_t> newBuf, const uint8_t* oldBuf);
+
+	/** Apply a delta obtained from calc() to the old buffer (in-place). */
+	void apply(std::span<uint8_t> buf, std::span<const uint8_t> delta);
+}
+
+class DeltaBlockCopy;
+
 class DeltaBlock
 {
 public:
@@ -25,8 +50,20 @@ public:
 #endif
 	virtual void apply(std::span<uint8_t> dst) const = 0;
 
+	/** Size of the data represented by this block. */
+	[[nodiscard]] size_t getRawSize() const { return rawSize; }
+	/** Memory used by this block itself (so excluding the reference
+	  * block it is based on).
+	  */
+	[[nodiscard]] virtual size_t getMemorySize() const = 0;
+	/** The DeltaBlockCopy this block is based on (itself for a copy). */
+	[[nodiscard]] virtual DeltaBlockCopy& getReference() = 0;
+
 protected:
-	DeltaBlock() = default;
+	explicit DeltaBlock(size_t rawSize_) : rawSize(rawSize_) {}
+
+private:
+	size_t rawSize;
 
 #ifdef DEBUG
 public:
@@ -46,28 +83,49 @@ class DeltaBlockCopy final : public DeltaBlock
 public:
 	explicit DeltaBlockCopy(std::span<const uint8_t> data);
 	void apply(std::span<uint8_t> dst) const override;
+	[[nodiscard]] size_t getMemorySize() const override { return block.size(); }
+	[[nodiscard]] DeltaBlockCopy& getReference() override { return *this; }
 	void compress(size_t size);
 	[[nodiscard]] const uint8_t* getData();
 
+	/** Blocks that are compressed (with the fast LZ4 algorithm) are no
+	  * longer used as reference for new deltas. Such blocks can later be
+	  * recompressed with the slower zlib algorithm for a better ratio.
+	  */
+	[[nodiscard]] bool canRecompress() const { return compressed() && !recompressed; }
+	void recompress();
+
 private:
 	[[nodiscard]] bool compressed() const { return compressedSize != 0; }
 
 	MemBuffer<uint8_t> block;
 	size_t compressedSize = 0;
+	bool zlibCompressed = false;
+	bool recompressed = false;
 };
 
 
 class DeltaBlockDiff final : public DeltaBlock
 {
 public:
+	/** Only makes a copy of 'data', the actual delta is calculated later
+	  * by calcDelta(). That (more expensive) step can be executed on a
+	  * worker thread.
+	  */
 	DeltaBlockDiff(std::shared_ptr<DeltaBlockCopy> prev_,
 	               std::span<const uint8_t> data);
 	void apply(std::span<uint8_t> dst) const override;
+	[[nodiscard]] size_t getMemorySize() const override { return newData.size() + delta.size(); }
+	[[nodiscard]] DeltaBlockCopy& getReference() override { return *prev; }
+	void calcDelta();
 	[[nodiscard]] size_t getDeltaSize() const;
 
 private:
+	[[nodiscard]] bool calculated() const { return !delta.empty(); }
+
 	const std::shared_ptr<DeltaBlockCopy> prev;
-	const std::vector<uint8_t> delta; // TODO could be tweaked to use OutputBuffer
+	MemBuffer<uint8_t> newData; // only valid until calcDelta() has run
+	std::vector<uint8_t> delta; // TODO could be tweaked to use OutputBuffer
 };
 
 
@@ -80,7 +138,21 @@ public:
 		const void* id, std::span<const uint8_t> data);
 	void clear();
 
+	/** By default the expensive part of creating new blocks (calculating
+	  * deltas and compressing reference blocks that are no longer used as
+	  * reference) is executed immediately. When deferred, that work is
+	  * instead collected and must be retrieved via takeDeferredWork(). The
+	  * returned jobs only touch the blocks themselves, so they can run in
+	  * parallel on worker threads. But they must all have finished before
+	  * the next call to createNew(), createNullDiff() or clear(), and
+	  * before the created blocks are applied.
+	  */
+	void setDeferWork(bool defer) { deferWork = defer; }
+	[[nodiscard]] std::vector<std::function<void()>> takeDeferredWork();
+
 private:
+	void execute(std::function<void()> job);
+
 	struct Info {
 		Info(const void* id_, size_t size_)
 			: id(id_), size(size_) {}
@@ -89,10 +161,15 @@ private:
 		size_t size;
 		std::weak_ptr<DeltaBlockCopy> ref;
 		std::weak_ptr<DeltaBlock> last;
+		// most recent diff, not yet included in 'accSize' because its
+		// delta might not have been calculated yet
+		std::shared_ptr<DeltaBlockDiff> unaccounted;
 		size_t accSize = 0;
 	};
 
 	std::vector<Info> infos;
+	std::vector<std::function<void()>> deferredWork;
+	bool deferWork = false;
 };
 
 } // namespace openmsx
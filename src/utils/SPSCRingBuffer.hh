@@ -0,0 +1,112 @@
+#ifndef SPSCRINGBUFFER_HH
+#define SPSCRINGBUFFER_HH
+
+#include "MemBuffer.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <type_traits>
+
+namespace openmsx {
+
+/** A ring buffer that can be used by one producer thread and one consumer
+  * thread at the same time, without locking.
+  *
+  * The read and write positions are free-running counters (never wrapped),
+  * the capacity is a power of two, so the number of elements in the buffer
+  * is simply the difference between both counters. Each counter is only
+  * modified by one thread (release), and read by the other (acquire).
+  *
+  * Only for trivially copyable element types.
+  */
+template<typename T>
+class SPSCRingBuffer
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+	/** The actual capacity is 'minCapacity' rounded up to a power of 2. */
+	explicit SPSCRingBuffer(size_t minCapacity)
+		: buffer(std::bit_ceil(std::max<size_t>(minCapacity, 1)))
+		, mask(buffer.size() - 1)
+	{
+	}
+
+	[[nodiscard]] size_t capacity() const { return buffer.size(); }
+
+	/** Number of elements in the buffer. Can be called from both threads,
+	  * but when the other thread is active the result is only a snapshot.
+	  */
+	[[nodiscard]] size_t size() const
+	{
+		auto r = readIdx.load(std::memory_order_acquire);
+		auto w = writeIdx.load(std::memory_order_acquire);
+		return w - r;
+	}
+
+	/** Producer: append (a prefix of) 'data'. Elements are only added as
+	  * long as the buffer contains less than 'maxFill' elements (and of
+	  * course as long as they fit).
+	  * @result The number of elements that were added.
+	  */
+	size_t write(std::span<const T> data, size_t maxFill = std::numeric_limits<size_t>::max())
+	{
+		auto w = writeIdx.load(std::memory_order_relaxed);
+		auto r = readIdx.load(std::memory_order_acquire);
+		size_t filled = w - r;
+		assert(filled <= capacity());
+		size_t limit = std::min(maxFill, capacity());
+		size_t num = (filled < limit) ? std::min(data.size(), limit - filled) : 0;
+
+		size_t pos = w & mask;
+		size_t len1 = std::min(num, capacity() - pos);
+		std::ranges::copy(data.first(len1), &buffer[pos]);
+		std::ranges::copy(data.subspan(len1, num - len1), &buffer[0]);
+
+		writeIdx.store(w + num, std::memory_order_release);
+		return num;
+	}
+
+	/** Consumer: remove elements from the buffer and store them in 'out'.
+	  * @result The number of elements that were read, this can be less
+	  *         than the size of 'out'.
+	  */
+	size_t read(std::span<T> out)
+	{
+		auto r = readIdx.load(std::memory_order_relaxed);
+		auto w = writeIdx.load(std::memory_order_acquire);
+		size_t num = std::min(out.size(), w - r);
+
+		size_t pos = r & mask;
+		size_t len1 = std::min(num, capacity() - pos);
+		std::copy_n(&buffer[pos], len1, out.data());
+		std::copy_n(&buffer[0], num - len1, out.data() + len1);
+
+		readIdx.store(r + num, std::memory_order_release);
+		return num;
+	}
+
+	/** Remove all elements. Neither the producer nor the consumer may be
+	  * active while this is called.
+	  */
+	void clear()
+	{
+		readIdx.store(writeIdx.load());
+	}
+
+private:
+	MemBuffer<T> buffer;
+	const size_t mask;
+	// On separate cache lines, to avoid false sharing between both threads.
+	alignas(64) std::atomic<size_t> writeIdx = 0; // only modified by the producer
+	alignas(64) std::atomic<size_t> readIdx = 0; // only modified by the consumer
+};
+
+} // namespace openmsx
+
+#endif
@@ -43,7 +43,8 @@ AviRecorder::~AviRecorder()
 }
 
 void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
-                        bool recordStereo, const std::string& filename)
+                        bool recordStereo, unsigned searchThreads,
+                        const std::string& filename)
 {
 	stop();
 	MSXMotherBoard* motherBoard = reactor.getMotherBoard();
@@ -80,13 +81,15 @@ void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
 		}
 		// any source is fine because they all have the same bpp
 		warnedFps = false;
+		warnedDroppedFrames = false;
 		duration = EmuDuration::infinity();
 		prevTime = EmuTime::infinity();
 
 		try {
 			aviWriter = std::make_unique<AviWriter>(
 				filename, frameWidth, frameHeight,
-				(recordAudio && stereo) ? 2 : 1, sampleRate);
+				(recordAudio && stereo) ? 2 : 1, sampleRate,
+				searchThreads);
 		} catch (MSXException& e) {
 			throw CommandException("Can't start recording: ",
 			                       e.getMessage());
@@ -196,7 +199,14 @@ void AviRecorder::addImage(const FrameSource* frame, EmuTime time)
 	if (mixer) {
 		mixer->updateStream(time);
 	}
-	aviWriter->addFrame(frame, audioBuf);
+	if (!aviWriter->addFrame(frame, audioBuf) && !warnedDroppedFrames) {
+		warnedDroppedFrames = true;
+		reactor.getCliComm().printWarning(
+			"The video encoder can't keep up, some frames are "
+			"dropped (repeated) in the avi recording. You can "
+			"try the -threads option of the record command. "
+			"'record status' shows the number of dropped frames.");
+	}
 	audioBuf.clear();
 }
 
@@ -215,6 +225,7 @@ void AviRecorder::processStart(Interpreter& interp, std::span<const TclObject> t
 	bool recordStereo = false;
 	bool doubleSize   = false;
 	bool tripleSize   = false;
+	int threads       = 0;
 	std::array info = {
 		valueArg("-prefix", prefix),
 		flagArg("-audioonly", audioOnly),
@@ -223,6 +234,7 @@ void AviRecorder::processStart(Interpreter& interp, std::span<const TclObject> t
 		flagArg("-stereo",    recordStereo),
 		flagArg("-doublesize", doubleSize),
 		flagArg("-triplesize", tripleSize),
+		valueArg("-threads", threads),
 	};
 	auto arguments = parseTclArgs(interp, tokens.subspan(2), info);
 
@@ -238,6 +250,9 @@ void AviRecorder::processStart(Interpreter& interp, std::span<const TclObject> t
 	if (videoOnly && (recordStereo || recordMono)) {
 		throw CommandException("Can't have both -videoonly and -stereo or -mono.");
 	}
+	if ((threads < 0) || (threads > 64)) {
+		throw CommandException("Number of threads must be in range [0..64].");
+	}
 	std::string_view filenameArg;
 	switch (arguments.size()) {
 	case 0:
@@ -269,7 +284,8 @@ void AviRecorder::processStart(Interpreter& interp, std::span<const TclObject> t
 	if (aviWriter || wavWriter) {
 		result = "Already recording.";
 	} else {
-		start(recordAudio, recordVideo, recordMono, recordStereo, filename);
+		start(recordAudio, recordVideo, recordMono, recordStereo,
+		      unsigned(threads), filename);
 		result = tmpStrCat("Recording to ", filename);
 	}
 }
@@ -297,6 +313,9 @@ bool AviRecorder::isRecording() const
 void AviRecorder::status(std::span<const TclObject> /*tokens*/, TclObject& result) const
 {
 	result.addDictKeyValue("status", isRecording() ? "recording"sv : "idle"sv);
+	if (aviWriter) {
+		result.addDictKeyValue("dropped_frames", aviWriter->getDroppedFrames());
+	}
 }
 
 // class AviRecorder::Cmd
@@ -335,6 +354,8 @@ std::string AviRecorder::Cmd::help(std::span<const TclObject> /*tokens*/) const
 	       "\n"
 	       "The start subcommand also accepts an optional -audioonly, -videoonly, "
 	       " -mono, -stereo, -doublesize, -triplesize flag.\n"
+	       "With '-threads <n>' the motion search of the video encoder is "
+	       "split over n extra threads (default 0).\n"
 	       "Videos are recorded in a 320x240 size by default, at 640x480 when the "
 	       "-doublesize flag is used and at 960x720 when the -triplesize flag is used.";
 }
@@ -351,7 +372,7 @@ void AviRecorder::Cmd::tabCompletion(std::vector<std::string>& tokens) const
 		static constexpr std::array options = {
 			"-prefix"sv, "-videoonly"sv, "-audioonly"sv,
 			"-doublesize"sv, "-triplesize"sv,
-			"-mono"sv, "-stereo"sv,
+			"-mono"sv, "-stereo"sv, "-threads"sv,
 		};
 		completeFileName(tokens, userFileContext(), options);
 	}
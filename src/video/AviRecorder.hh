@@ -43,7 +43,8 @@ public:
 
 private:
 	void start(bool recordAudio, bool recordVideo, bool recordMono,
-		   bool recordStereo, const std::string& filename);
+		   bool recordStereo, unsigned searchThreads,
+		   const std::string& filename);
 	void status(std::span<const TclObject> tokens, TclObject& result) const;
 
 	void processStart (Interpreter& interp, std::span<const TclObject> tokens, TclObject& result);
@@ -71,6 +72,7 @@ private:
 	unsigned frameWidth;
 	unsigned frameHeight = 0;
 	bool warnedFps;
+	bool warnedDroppedFrames;
 	bool warnedSampleRate;
 	bool warnedStereo;
 	bool stereo;
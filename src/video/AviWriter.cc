@@ -4,6 +4,7 @@
 
 #include "FileOperations.hh"
 #include "MSXException.hh"
+#include "ThreadPool.hh"
 #include "Version.hh"
 
 #include "cstdiop.hh" // for snprintf
@@ -19,20 +20,23 @@
 #include <cstring>
 #include <ctime>
 #include <limits>
+#include <memory>
 
 namespace openmsx {
 
 static constexpr unsigned AVI_HEADER_SIZE = 500;
 
 AviWriter::AviWriter(const std::string& filename_, unsigned width_,
-                     unsigned height_, unsigned channels_, unsigned freq_)
+                     unsigned height_, unsigned channels_, unsigned freq_,
+                     unsigned searchThreads)
 	: file(filename_, "wb")
 	, filename(filename_)
-	, codec(width_, height_)
+	, codec(width_, height_, searchThreads)
 	, width(width_)
 	, height(height_)
 	, channels(channels_)
 	, audioRate(freq_)
+	, encoderThread(std::make_unique<ThreadPool>(1))
 {
 	std::array<uint8_t, AVI_HEADER_SIZE> dummy = {};
 	file.write(dummy);
@@ -42,6 +46,8 @@ AviWriter::AviWriter(const std::string& filename_, unsigned width_,
 
 AviWriter::~AviWriter()
 {
+	encoderThread.reset(); // finish pending frames
+
 	if (written == 0) {
 		// no data written yet (a recording less than one video frame)
 		file.close(); // close file (needed for windows?)
@@ -274,22 +280,66 @@ void AviWriter::addAviChunk(std::span<const char, 4> tag, std::span<const uint8_
 	index[idxSize + 3] = size32;
 }
 
-void AviWriter::addFrame(const FrameSource* video, std::span<const int16_t> audio)
+bool AviWriter::addFrame(const FrameSource* video, std::span<const int16_t> audio)
 {
-	bool keyFrame = (frames++ % 300 == 0);
-	auto buffer = codec.compressFrame(keyFrame, video);
-	addAviChunk(subspan<4>("00dc"), buffer, keyFrame ? 0x10 : 0x0);
-
-	if (!audio.empty()) {
-		assert((audio.size() % channels) == 0);
-		assert(audioRate != 0);
-		if constexpr (Endian::BIG) {
-			small_buffer<Endian::L16, 4096> buf(audio);
-			addAviChunk(subspan<4>("01wb"), as_byte_span(std::span{buf}), 0);
+	auto job = std::make_shared<Job>();
+	{
+		std::scoped_lock lock(mutex);
+		if (!error.empty()) {
+			throw MSXException("Error while writing video: ", error);
+		}
+		if (!freeFrames.empty()) {
+			job->frame = std::move(freeFrames.back());
+			freeFrames.pop_back();
+		}
+	}
+	if (job->frame.empty() && (allocatedFrames < MAX_PENDING_FRAMES)) {
+		job->frame = codec.allocateFrame();
+		++allocatedFrames;
+	}
+	bool captured = !job->frame.empty();
+	if (captured) {
+		codec.captureFrame(video, job->frame);
+	} else {
+		++droppedFrames;
+	}
+	job->audio.assign(audio.begin(), audio.end());
+
+	// std::function requires a copyable functor, hence the shared_ptr
+	encoderThread->enqueue([this, job] { writeJob(*job); });
+	return captured;
+}
+
+void AviWriter::writeJob(Job& job)
+{
+	try {
+		++frames;
+		if (!job.frame.empty()) {
+			bool keyFrame = (encodedFrames++ % 300 == 0);
+			auto buffer = codec.compressFrame(keyFrame, job.frame);
+			addAviChunk(subspan<4>("00dc"), buffer, keyFrame ? 0x10 : 0x0);
+			std::scoped_lock lock(mutex);
+			freeFrames.push_back(std::move(job.frame));
 		} else {
-			addAviChunk(subspan<4>("01wb"), as_byte_span(audio), 0);
+			// an empty chunk repeats the previous frame
+			addAviChunk(subspan<4>("00dc"), {}, 0x0);
+		}
+
+		if (!job.audio.empty()) {
+			std::span<const int16_t> audio = job.audio;
+			assert((audio.size() % channels) == 0);
+			assert(audioRate != 0);
+			if constexpr (Endian::BIG) {
+				small_buffer<Endian::L16, 4096> buf(audio);
+				addAviChunk(subspan<4>("01wb"), as_byte_span(std::span{buf}), 0);
+			} else {
+				addAviChunk(subspan<4>("01wb"), as_byte_span(audio), 0);
+			}
+			audioWritten += narrow<uint32_t>(audio.size());
 		}
-		audioWritten += narrow<uint32_t>(audio.size());
+	} catch (MSXException& e) {
+		std::scoped_lock lock(mutex);
+		if (error.empty()) error = e.getMessage();
 	}
 }
 
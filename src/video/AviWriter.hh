@@ -10,6 +10,8 @@
 #include "endian.hh"
 
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <span>
 #include <string>
 #include <vector>
@@ -17,17 +19,45 @@
 namespace openmsx {
 
 class FrameSource;
+class ThreadPool;
 
+/** Writes an AVI file with ZMBV compressed video and (optionally) PCM audio.
+  *
+  * addFrame() only captures the frame (into one of a small pool of buffers),
+  * the compression and the file writes happen on a background thread. When
+  * that thread falls behind and all buffers are in use, the frame is dropped:
+  * it's written as an empty chunk, which means 'repeat the previous frame'.
+  * So the emulation never has to wait for the encoder, and the audio stays in
+  * sync.
+  */
 class AviWriter
 {
 public:
+	/** Maximum number of captured frames waiting to be encoded. */
+	static constexpr unsigned MAX_PENDING_FRAMES = 8;
+
+	/** @param searchThreads See ZMBVEncoder. */
 	AviWriter(const std::string& filename, unsigned width, unsigned height,
-	          unsigned channels, unsigned freq);
+	          unsigned channels, unsigned freq, unsigned searchThreads = 0);
+	/** Waits till all pending frames are written. */
 	~AviWriter();
-	void addFrame(const FrameSource* video, std::span<const int16_t> audio);
+
+	/** Capture the frame, and queue it (and the audio) to be written.
+	  * @result false iff the frame was dropped.
+	  * @throw MSXException When writing a previous frame failed.
+	  */
+	bool addFrame(const FrameSource* video, std::span<const int16_t> audio);
 	void setFps(float fps_) { fps = fps_; }
 
+	/** Number of frames that were dropped because the encoder was behind. */
+	[[nodiscard]] unsigned getDroppedFrames() const { return droppedFrames; }
+
 private:
+	struct Job {
+		ZMBVEncoder::FrameBuffer frame; // empty when dropped
+		std::vector<int16_t> audio;
+	};
+	void writeJob(Job& job);
 	void addAviChunk(std::span<const char, 4> tag, std::span<const uint8_t> data, unsigned flags);
 
 private:
@@ -36,6 +66,15 @@ private:
 	ZMBVEncoder codec;
 	std::vector<Endian::L32> index;
 
+	// Shared between the main thread and the encoder thread.
+	std::mutex mutex;
+	std::vector<ZMBVEncoder::FrameBuffer> freeFrames;
+	std::string error; // first write error, reported on the main thread
+
+	unsigned allocatedFrames = 0;
+	unsigned droppedFrames = 0;
+	uint32_t encodedFrames = 0; // only used by the encoder thread
+
 	float fps = 0.0f; // will be filled in later
 	const uint32_t width;
 	const uint32_t height;
@@ -45,6 +84,10 @@ private:
 	uint32_t frames = 0;
 	uint32_t audioWritten = 0;
 	uint32_t written = 0;
+
+	// Must be the last member: it's destroyed (and waits for the pending
+	// jobs) before the members used by those jobs.
+	std::unique_ptr<ThreadPool> encoderThread;
 };
 
 } // namespace openmsx
@@ -8,23 +8,62 @@
 
 #include <algorithm>
 #include <bit>
+#include <cassert>
+#include <cstring>
 #include <tuple>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BITMAP_CONVERTER_AVX2
+#endif
+
 namespace openmsx {
 
+using Pixel = BitmapConverter::Pixel;
+
+bool BitmapConverter::isSupported(Impl impl)
+{
+	switch (impl) {
+	case Impl::PORTABLE:
+		return true;
+	case Impl::AVX2:
+#ifdef BITMAP_CONVERTER_AVX2
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	default:
+		UNREACHABLE;
+	}
+}
+
+BitmapConverter::Impl BitmapConverter::getBest()
+{
+	return isSupported(Impl::AVX2) ? Impl::AVX2 : Impl::PORTABLE;
+}
+
 BitmapConverter::BitmapConverter(
 		std::span<const Pixel, 16 * 2> palette16_,
 		std::span<const Pixel, 256>    palette256_,
-		std::span<const Pixel, 32768>  palette32768_)
+		std::span<const Pixel, 32768>  palette32768_,
+		Impl impl_)
 	: palette16(palette16_)
 	, palette256(palette256_)
 	, palette32768(palette32768_)
+	, impl(impl_)
 {
+	assert(isSupported(impl));
 }
 
 void BitmapConverter::calcDPalette()
 {
 	dPaletteValid = true;
+	for (auto n : xrange(4)) {
+		for (auto i : xrange(16)) {
+			planes16[n][i] = uint8_t(palette16[i] >> (8 * n));
+			planes5[n][i] = uint8_t(palette16[(i & 3) | ((i & 4) << 2)] >> (8 * n));
+		}
+	}
 	unsigned bits = sizeof(Pixel) * 8;
 	for (auto i : xrange(16)) {
 		DPixel p0 = palette16[i];
@@ -37,8 +76,217 @@ void BitmapConverter::calcDPalette()
 	}
 }
 
+#ifdef BITMAP_CONVERTER_AVX2
+
+using Planes = std::array<std::array<uint8_t, 16>, 4>;
+
+// Note: lambdas don't inherit the 'target' attribute, so these are all
+// separate functions.
+
+// Look up byte 'n' of 32 pixels at once.
+[[gnu::target("avx2")]] static inline __m256i lookupPlane(
+	const Planes& planes, int n, __m256i idx)
+{
+	auto tab = _mm_loadu_si128(std::bit_cast<const __m128i*>(planes[n].data()));
+	return _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(tab), idx);
+}
+
+// Convert 32 palette indices [0..15] to pixels. The low 128-bit lane of
+// 'idx' contains the indices for out[0..15], the high lane for out[16..31].
+// Each byte of the result is looked up separately (byte-plane 'n' of all
+// palette entries fits in a single register), and then the bytes are
+// interleaved again.
+[[gnu::target("avx2")]] static inline void lookup32(
+	__m256i idx, const Planes& planes, Pixel* out)
+{
+	__m256i b0 = lookupPlane(planes, 0, idx);
+	__m256i b1 = lookupPlane(planes, 1, idx);
+	__m256i b2 = lookupPlane(planes, 2, idx);
+	__m256i b3 = lookupPlane(planes, 3, idx);
+	__m256i b01L = _mm256_unpacklo_epi8(b0, b1);
+	__m256i b01H = _mm256_unpackhi_epi8(b0, b1);
+	__m256i b23L = _mm256_unpacklo_epi8(b2, b3);
+	__m256i b23H = _mm256_unpackhi_epi8(b2, b3);
+	__m256i p0 = _mm256_unpacklo_epi16(b01L, b23L); // out[ 0.. 3] and out[16..19]
+	__m256i p1 = _mm256_unpackhi_epi16(b01L, b23L); // out[ 4.. 7] and out[20..23]
+	__m256i p2 = _mm256_unpacklo_epi16(b01H, b23H); // out[ 8..11] and out[24..27]
+	__m256i p3 = _mm256_unpackhi_epi16(b01H, b23H); // out[12..15] and out[28..31]
+	auto* o = std::bit_cast<__m256i*>(out);
+	_mm256_storeu_si256(o + 0, _mm256_permute2x128_si256(p0, p1, 0x20));
+	_mm256_storeu_si256(o + 1, _mm256_permute2x128_si256(p2, p3, 0x20));
+	_mm256_storeu_si256(o + 2, _mm256_permute2x128_si256(p0, p1, 0x31));
+	_mm256_storeu_si256(o + 3, _mm256_permute2x128_si256(p2, p3, 0x31));
+}
+
+// 16 bytes, each containing two 4-bit pixels (high nibble first), to 32 pixels.
+[[gnu::target("avx2")]] static inline void nibblesToPixels(
+	__m128i data, const Planes& planes, Pixel* out)
+{
+	const __m128i m0F = _mm_set1_epi8(0x0F);
+	__m128i hi = _mm_and_si128(_mm_srli_epi16(data, 4), m0F);
+	__m128i lo = _mm_and_si128(data, m0F);
+	__m256i idx = _mm256_setr_m128i(_mm_unpacklo_epi8(hi, lo),
+	                                _mm_unpackhi_epi8(hi, lo));
+	lookup32(idx, planes, out);
+}
+
+[[gnu::target("avx2")]] static void renderGraphic4Avx2(
+	Pixel* out, const uint8_t* in, const Planes& planes)
+{
+	for (auto i : xrange(128 / 16)) {
+		auto data = _mm_loadu_si128(std::bit_cast<const __m128i*>(in + 16 * i));
+		nibblesToPixels(data, planes, out + 32 * i);
+	}
+}
+
+[[gnu::target("avx2")]] static void renderGraphic5Avx2(
+	Pixel* out, const uint8_t* in, const Planes& planes5)
+{
+	// Each byte contains four 2-bit pixels, the 2nd and 4th pixel use the
+	// odd palette (entries [4..7] in 'planes5').
+	const __m128i m03 = _mm_set1_epi8(0x03);
+	const __m128i m04 = _mm_set1_epi8(0x04);
+	for (auto i : xrange(128 / 16)) {
+		auto data = _mm_loadu_si128(std::bit_cast<const __m128i*>(in + 16 * i));
+		__m128i a6 =               _mm_and_si128(_mm_srli_epi16(data, 6), m03);
+		__m128i a4 = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(data, 4), m03), m04);
+		__m128i a2 =               _mm_and_si128(_mm_srli_epi16(data, 2), m03);
+		__m128i a0 = _mm_or_si128(_mm_and_si128(data, m03), m04);
+		__m128i a64L = _mm_unpacklo_epi8(a6, a4);
+		__m128i a64H = _mm_unpackhi_epi8(a6, a4);
+		__m128i a20L = _mm_unpacklo_epi8(a2, a0);
+		__m128i a20H = _mm_unpackhi_epi8(a2, a0);
+		lookup32(_mm256_setr_m128i(_mm_unpacklo_epi16(a64L, a20L),
+		                           _mm_unpackhi_epi16(a64L, a20L)),
+		         planes5, out + 64 * i + 0);
+		lookup32(_mm256_setr_m128i(_mm_unpacklo_epi16(a64H, a20H),
+		                           _mm_unpackhi_epi16(a64H, a20H)),
+		         planes5, out + 64 * i + 32);
+	}
+}
+
+[[gnu::target("avx2")]] static void renderGraphic6Avx2(
+	Pixel* out, const uint8_t* in0, const uint8_t* in1, const Planes& planes)
+{
+	// Same as Graphic4, after interleaving the bytes of both planes.
+	for (auto i : xrange(128 / 16)) {
+		auto data0 = _mm_loadu_si128(std::bit_cast<const __m128i*>(in0 + 16 * i));
+		auto data1 = _mm_loadu_si128(std::bit_cast<const __m128i*>(in1 + 16 * i));
+		nibblesToPixels(_mm_unpacklo_epi8(data0, data1), planes, out + 64 * i + 0);
+		nibblesToPixels(_mm_unpackhi_epi8(data0, data1), planes, out + 64 * i + 32);
+	}
+}
+
+// Look up 8 pixels, the indices are the lower 8 bytes of 'idx8'.
+[[gnu::target("avx2")]] static inline __m256i gather8(const int* palette, __m128i idx8)
+{
+	return _mm256_i32gather_epi32(palette, _mm256_cvtepu8_epi32(idx8), 4);
+}
+
+[[gnu::target("avx2")]] static void renderGraphic7Avx2(
+	Pixel* out, const uint8_t* in0, const uint8_t* in1, const Pixel* palette256)
+{
+	// A 256-entry palette doesn't fit in registers, use gather instructions.
+	auto* pal = std::bit_cast<const int*>(palette256);
+	auto* o = std::bit_cast<__m256i*>(out);
+	for (auto i : xrange(128 / 16)) {
+		auto data0 = _mm_loadu_si128(std::bit_cast<const __m128i*>(in0 + 16 * i));
+		auto data1 = _mm_loadu_si128(std::bit_cast<const __m128i*>(in1 + 16 * i));
+		__m128i lo = _mm_unpacklo_epi8(data0, data1);
+		__m128i hi = _mm_unpackhi_epi8(data0, data1);
+		_mm256_storeu_si256(o + 4 * i + 0, gather8(pal, lo));
+		_mm256_storeu_si256(o + 4 * i + 1, gather8(pal, _mm_srli_si128(lo, 8)));
+		_mm256_storeu_si256(o + 4 * i + 2, gather8(pal, hi));
+		_mm256_storeu_si256(o + 4 * i + 3, gather8(pal, _mm_srli_si128(hi, 8)));
+	}
+}
+
+// Clamp to [0..31].
+[[gnu::target("avx2")]] static inline __m256i clamp31(__m256i x)
+{
+	return _mm256_min_epi32(_mm256_max_epi32(x, _mm256_setzero_si256()),
+	                        _mm256_set1_epi32(31));
+}
+
+// Vectorized version of renderYJK() (YAE == false) or renderYAE() (true).
+// Converts two groups of 4 pixels at a time, one group per 128-bit lane.
+template<bool YAE>
+[[gnu::target("avx2")]] static void renderYJKAvx2(
+	Pixel* out, const uint8_t* in0, const uint8_t* in1,
+	const Pixel* palette16, const Pixel* palette32768)
+{
+	auto* pal16    = std::bit_cast<const int*>(palette16);
+	auto* pal32768 = std::bit_cast<const int*>(palette32768);
+	auto* o = std::bit_cast<__m256i*>(out);
+	const __m256i m3 = _mm256_set1_epi32(3);
+	const __m256i m4 = _mm256_set1_epi32(4);
+	const __m256i m7 = _mm256_set1_epi32(7);
+	const __m256i m8 = _mm256_set1_epi32(8);
+	for (auto i : xrange(128 / 4)) {
+		uint32_t d0, d1;
+		memcpy(&d0, in0 + 4 * i, sizeof(d0));
+		memcpy(&d1, in1 + 4 * i, sizeof(d1));
+		__m128i d = _mm_unpacklo_epi8(_mm_cvtsi32_si128(int(d0)),
+		                              _mm_cvtsi32_si128(int(d1)));
+		__m256i p = _mm256_cvtepu8_epi32(d); // p[0..3] of 2 groups
+
+		// per lane: [k, k, j, j]
+		__m256i p02 = _mm256_shuffle_epi32(p, 0xA0); // [p0, p0, p2, p2]
+		__m256i p13 = _mm256_shuffle_epi32(p, 0xF5); // [p1, p1, p3, p3]
+		__m256i kj = _mm256_sub_epi32(
+			_mm256_add_epi32(_mm256_and_si256(p02, m7),
+			                 _mm256_slli_epi32(_mm256_and_si256(p13, m3), 3)),
+			_mm256_slli_epi32(_mm256_and_si256(p13, m4), 3));
+		__m256i k = _mm256_shuffle_epi32(kj, 0x00);
+		__m256i j = _mm256_shuffle_epi32(kj, 0xAA);
+
+		__m256i y = _mm256_srli_epi32(p, 3);
+		__m256i r = clamp31(_mm256_add_epi32(y, j));
+		__m256i g = clamp31(_mm256_add_epi32(y, k));
+		// (5y - 2j - k + 2) / 4: the division rounds towards zero, an
+		// arithmetic shift rounds down, but that only makes a difference
+		// for negative values, and those are clamped to zero anyway.
+		__m256i b5 = _mm256_add_epi32(_mm256_slli_epi32(y, 2), y);
+		__m256i b = clamp31(_mm256_srai_epi32(
+			_mm256_sub_epi32(_mm256_add_epi32(b5, _mm256_set1_epi32(2)),
+			                 _mm256_add_epi32(_mm256_add_epi32(j, j), k)),
+			2));
+		__m256i col = _mm256_or_si256(
+			_mm256_or_si256(_mm256_slli_epi32(r, 10), _mm256_slli_epi32(g, 5)),
+			b);
+		__m256i pix = _mm256_i32gather_epi32(pal32768, col, 4);
+		if constexpr (YAE) {
+			__m256i isYae = _mm256_cmpeq_epi32(_mm256_and_si256(p, m8), m8);
+			__m256i yae = _mm256_i32gather_epi32(pal16, _mm256_srli_epi32(p, 4), 4);
+			pix = _mm256_blendv_epi8(pix, yae, isYae);
+		}
+		_mm256_storeu_si256(o + i, pix);
+	}
+}
+
+#endif
+
 void BitmapConverter::convertLine(std::span<Pixel> buf, std::span<const uint8_t, 128> vramPtr)
 {
+#ifdef BITMAP_CONVERTER_AVX2
+	if (impl == Impl::AVX2) {
+		if (!dPaletteValid) [[unlikely]] {
+			calcDPalette();
+		}
+		switch (mode.getByte()) {
+		case DisplayMode::GRAPHIC4:
+		case DisplayMode::GRAPHIC4 | DisplayMode::YAE:
+			renderGraphic4Avx2(subspan<256>(buf).data(), vramPtr.data(), planes16);
+			return;
+		case DisplayMode::GRAPHIC5:
+		case DisplayMode::GRAPHIC5 | DisplayMode::YAE:
+			renderGraphic5Avx2(subspan<512>(buf).data(), vramPtr.data(), planes5);
+			return;
+		default:
+			break; // handled below
+		}
+	}
+#endif
 	switch (mode.getByte()) {
 	case DisplayMode::GRAPHIC4: // screen 5
 	case DisplayMode::GRAPHIC4 | DisplayMode::YAE:
@@ -72,6 +320,35 @@ void BitmapConverter::convertLine(std::span<Pixel> buf, std::span<const uint8_t,
 void BitmapConverter::convertLinePlanar(
 	std::span<Pixel> buf, std::span<const uint8_t, 128> vramPtr0, std::span<const uint8_t, 128> vramPtr1)
 {
+#ifdef BITMAP_CONVERTER_AVX2
+	if (impl == Impl::AVX2) {
+		if (!dPaletteValid) [[unlikely]] {
+			calcDPalette();
+		}
+		switch (mode.getByte()) {
+		case DisplayMode::GRAPHIC6:
+		case DisplayMode::GRAPHIC6 | DisplayMode::YAE:
+			renderGraphic6Avx2(subspan<512>(buf).data(), vramPtr0.data(), vramPtr1.data(), planes16);
+			return;
+		case DisplayMode::GRAPHIC7:
+		case DisplayMode::GRAPHIC7 | DisplayMode::YAE:
+			renderGraphic7Avx2(subspan<256>(buf).data(), vramPtr0.data(), vramPtr1.data(), palette256.data());
+			return;
+		case DisplayMode::GRAPHIC6 | DisplayMode::YJK:
+		case DisplayMode::GRAPHIC7 | DisplayMode::YJK:
+			renderYJKAvx2<false>(subspan<256>(buf).data(), vramPtr0.data(), vramPtr1.data(),
+			                     palette16.data(), palette32768.data());
+			return;
+		case DisplayMode::GRAPHIC6 | DisplayMode::YJK | DisplayMode::YAE:
+		case DisplayMode::GRAPHIC7 | DisplayMode::YJK | DisplayMode::YAE:
+			renderYJKAvx2<true>(subspan<256>(buf).data(), vramPtr0.data(), vramPtr1.data(),
+			                    palette16.data(), palette32768.data());
+			return;
+		default:
+			break; // handled below
+		}
+	}
+#endif
 	switch (mode.getByte()) {
 	case DisplayMode::GRAPHIC6: // screen 7
 	case DisplayMode::GRAPHIC6 | DisplayMode::YAE:
@@ -17,6 +17,15 @@ public:
 	using Pixel = uint32_t;
 	using DPixel = uint64_t;
 
+	/** The portable implementation is plain C++ (a lookup per pixel, or
+	  * per pair of pixels). The AVX2 implementation converts 32 pixels
+	  * at once, it's only used when the host CPU supports it. Both give
+	  * exactly the same result.
+	  */
+	enum class Impl : uint8_t { PORTABLE, AVX2 };
+	[[nodiscard]] static bool isSupported(Impl impl);
+	[[nodiscard]] static Impl getBest();
+
 	/** Create a new bitmap scanline converter.
 	  * @param palette16 Pointer to 2*16-entries array that specifies
 	  *   VDP color index to host pixel mapping.
@@ -37,10 +46,13 @@ public:
 	  *   This is kept as a pointer, so any changes to the palette
 	  *   are immediately picked up by convertLine.
 	  *   Used when YJK filter is active.
+	  * @param impl Which implementation to use, normally only overridden
+	  *   in tests and benchmarks.
 	  */
 	BitmapConverter(std::span<const Pixel, 16 * 2> palette16,
 	                std::span<const Pixel, 256>    palette256,
-	                std::span<const Pixel, 32768>  palette32768);
+	                std::span<const Pixel, 32768>  palette32768,
+	                Impl impl = getBest());
 
 	/** Convert a line of V9938 VRAM to 256 or 512 host pixels.
 	  * Call this method in non-planar display modes (Graphic4 and Graphic5).
@@ -80,6 +92,16 @@ public:
 		dPaletteValid = false;
 	}
 
+	/** Make sure the lazily calculated internal tables are up-to-date.
+	  * Afterwards convertLine() and convertLinePlanar() don't modify this
+	  * object, so (until the next palette16Changed() call) they can be
+	  * called from several threads at the same time.
+	  */
+	void prepareConcurrentUse()
+	{
+		if (!dPaletteValid) calcDPalette();
+	}
+
 private:
 	void calcDPalette();
 
@@ -107,7 +129,14 @@ private:
 	std::span<const Pixel, 32768>  palette32768;
 
 	std::array<DPixel, 16 * 16> dPalette;
+	/** The 16 palette entries for Graphic4/6, split in 4 byte-planes
+	  * (byte 'n' of each pixel in planes[n]), used by the AVX2 code. */
+	std::array<std::array<uint8_t, 16>, 4> planes16;
+	/** Same for the 8 distinct colors in Graphic5: entries [0..3] and
+	  * [16..19] of palette16, the remaining entries are unused. */
+	std::array<std::array<uint8_t, 16>, 4> planes5;
 	DisplayMode mode;
+	const Impl impl;
 	bool dPaletteValid = false;
 };
 
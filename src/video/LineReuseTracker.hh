@@ -0,0 +1,95 @@
+#ifndef LINEREUSETRACKER_HH
+#define LINEREUSETRACKER_HH
+
+#include "xrange.hh"
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+
+namespace openmsx {
+
+/** Dirty line tracking, used by PixelRenderer to decide which lines can be
+  * copied from the previous frame instead of drawing them again.
+  *
+  * Each change that can affect the output gets a sequence number. The last
+  * change per display line [0..256) is stored in 'dirtyStamp', changes that
+  * affect all lines (e.g. a palette change) in 'allDirtyStamp'. For each
+  * (absolute) line [0..NUM_LINES) of the previous and of the current frame we
+  * store the sequence number at the time it was drawn, and the display line
+  * it showed. A line can be copied from the previous frame when it shows the
+  * same display line, and there were no changes to that display line since
+  * it was drawn.
+  */
+template<int NUM_LINES>
+class LineReuseTracker
+{
+public:
+	/** Mark all display lines as changed. */
+	void markAllDirty()
+	{
+		allDirtyStamp = ++changeCount;
+	}
+
+	/** Mark the display lines [displayY, displayY + num) as changed. This
+	  * range wraps around at 256.
+	  */
+	void markDirty(int displayY, int num)
+	{
+		++changeCount;
+		for (auto i : xrange(num)) {
+			dirtyStamp[(displayY + i) & 255] = changeCount;
+		}
+	}
+
+	/** Can the content of absolute line 'y', which shows display line
+	  * 'displayY', be copied from the previous frame?
+	  */
+	[[nodiscard]] bool canReuse(int y, int displayY) const
+	{
+		assert(0 <= y && y < NUM_LINES);
+		const auto& last = lastLines[y];
+		return (last.displayY == displayY) &&
+		       (last.stamp >= allDirtyStamp) &&
+		       (last.stamp >= dirtyStamp[displayY & 255]);
+	}
+
+	/** Remember that absolute line 'y' was fully drawn in this frame, and
+	  * shows display line 'displayY' (or -1 when it can't be reused).
+	  */
+	void setDrawn(int y, int displayY)
+	{
+		assert(0 <= y && y < NUM_LINES);
+		currLines[y] = LineInfo{changeCount, displayY};
+	}
+
+	/** The current frame becomes the previous frame. */
+	void nextFrame()
+	{
+		lastLines = currLines;
+		currLines.fill({});
+	}
+
+	/** Forget about all drawn lines, nothing can be reused afterwards. */
+	void reset()
+	{
+		lastLines.fill({});
+		currLines.fill({});
+		markAllDirty();
+	}
+
+private:
+	struct LineInfo {
+		uint64_t stamp = 0;
+		int displayY = -1; // -1: not fully drawn as a display line
+	};
+	std::array<LineInfo, NUM_LINES> lastLines;
+	std::array<LineInfo, NUM_LINES> currLines;
+	std::array<uint64_t, 256> dirtyStamp = {};
+	uint64_t allDirtyStamp = 0;
+	uint64_t changeCount = 0;
+};
+
+} // namespace openmsx
+
+#endif
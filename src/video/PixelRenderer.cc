@@ -18,17 +18,22 @@ TODO:
 #include "Event.hh"
 #include "EventDistributor.hh"
 #include "GlobalSettings.hh"
+#include "HostProfiler.hh"
 #include "IntegerSetting.hh"
 #include "MSXMotherBoard.hh"
 #include "Reactor.hh"
 #include "RealTime.hh"
 #include "SpeedManager.hh"
+#include "TclObject.hh"
 #include "ThrottleManager.hh"
 #include "Timer.hh"
 
 #include "narrow.hh"
 #include "one_of.hh"
+#include "outer.hh"
+#include "strCat.hh"
 #include "unreachable.hh"
+#include "xrange.hh"
 
 #include <algorithm>
 #include <cassert>
@@ -37,7 +42,8 @@ TODO:
 namespace openmsx {
 
 void PixelRenderer::draw(
-	int startX, int startY, int endX, int endY, DrawType drawType, bool atEnd)
+	int startX, int startY, int endX, int endY, DrawType drawType,
+	bool atEnd, bool fullLines)
 {
 	if (drawType == DRAW_BORDER) {
 		rasterizer->drawBorder(startX, startY, endX, endY);
@@ -63,21 +69,55 @@ void PixelRenderer::draw(
 
 		displayY &= 255; // Page wrap.
 		int displayWidth = (endX - (startX & ~1)) / 2;
-		int displayHeight = endY - startY;
 
 		assert(0 <= displayX);
 		assert(displayX + displayWidth <= 512);
 
-		rasterizer->drawDisplay(
-			startX, startY,
-			displayX - vdp.getHorizontalScrollLow() * 2, displayY,
-			displayWidth, displayHeight
-			);
-		if (vdp.spritesEnabled() && !renderSettings.getDisableSprites()) {
-			rasterizer->drawSprites(
-				startX, startY,
-				displayX / 2, displayY,
-				(displayWidth + 1) / 2, displayHeight);
+		bool drawSprites = vdp.spritesEnabled() && !renderSettings.getDisableSprites();
+		auto drawLines = [&](int fromY, int limitY) {
+			int fromDisplayY = (displayY + fromY - startY) & 255;
+			rasterizer->drawDisplay(
+				startX, fromY,
+				displayX - vdp.getHorizontalScrollLow() * 2, fromDisplayY,
+				displayWidth, limitY - fromY
+				);
+			if (drawSprites) {
+				rasterizer->drawSprites(
+					startX, fromY,
+					displayX / 2, fromDisplayY,
+					(displayWidth + 1) / 2, limitY - fromY);
+			}
+		};
+
+		// In interlace or even/odd mode consecutive frames show different
+		// pages. And with fast blink the page can change per line.
+		if (!fullLines || vdp.isInterlaced() || vdp.isEvenOddEnabled() ||
+		    vdp.isFastBlinkEnabled()) {
+			drawLines(startY, endY);
+			for (auto y : xrange(startY, endY)) lineTracker.setDrawn(y, -1);
+			if (atEnd) currStats.drawn += endY - startY;
+			return;
+		}
+
+		// Split in runs of lines that can be copied from the previous
+		// frame, and runs of lines that must be drawn.
+		auto lineDisplayY = [&](int y) { return (displayY + y - startY) & 255; };
+		int y = startY;
+		while (y < endY) {
+			bool reuse = lineTracker.canReuse(y, lineDisplayY(y));
+			int runEnd = y + 1;
+			while ((runEnd < endY) &&
+			       (lineTracker.canReuse(runEnd, lineDisplayY(runEnd)) == reuse)) {
+				++runEnd;
+			}
+			if (reuse && rasterizer->copyFromLastFrame(y, runEnd)) {
+				currStats.reused += runEnd - y;
+			} else {
+				drawLines(y, runEnd);
+				currStats.drawn += runEnd - y;
+			}
+			for (auto i : xrange(y, runEnd)) lineTracker.setDrawn(i, lineDisplayY(i));
+			y = runEnd;
 		}
 	}
 }
@@ -91,7 +131,7 @@ void PixelRenderer::subdivide(
 		bool atEnd = (startY != endY) || (endX >= clipR);
 		if (startX < clipR) {
 			draw(startX, startY, (atEnd ? clipR : endX),
-			     startY + 1, drawType, atEnd);
+			     startY + 1, drawType, atEnd, false);
 		}
 		if (startY == endY) return;
 		startY++;
@@ -105,13 +145,13 @@ void PixelRenderer::subdivide(
 	}
 	// Full middle lines.
 	if (startY < endY) {
-		draw(clipL, startY, clipR, endY, drawType, true);
+		draw(clipL, startY, clipR, endY, drawType, true, true);
 	}
 	// Actually draw last line if necessary.
 	// The point of keeping top-to-bottom draw order is that it increases
 	// the locality of memory references, which generally improves cache
 	// hit rates.
-	if (drawLast) draw(clipL, endY, endX, endY + 1, drawType, false);
+	if (drawLast) draw(clipL, endY, endX, endY + 1, drawType, false, false);
 }
 
 PixelRenderer::PixelRenderer(VDP& vdp_, Display& display)
@@ -126,6 +166,8 @@ PixelRenderer::PixelRenderer(VDP& vdp_, Display& display)
 	, videoSourceSetting(vdp.getMotherBoard().getVideoSource())
 	, spriteChecker(vdp.getSpriteChecker())
 	, rasterizer(display.getVideoSystem().createRasterizer(vdp))
+	, lineStatsInfo(vdp.getMotherBoard().getMachineInfoCommand(),
+	                strCat(vdp.getName(), "_line_stats"))
 {
 	// In case of loadstate we can't yet query any state from the VDP
 	// (because that object is not yet fully deserialized). But
@@ -135,10 +177,23 @@ PixelRenderer::PixelRenderer(VDP& vdp_, Display& display)
 
 	renderSettings.getMaxFrameSkipSetting().attach(*this);
 	renderSettings.getMinFrameSkipSetting().attach(*this);
+	// These change the content of the rendered frames.
+	renderSettings.getGammaSetting()         .attach(*this);
+	renderSettings.getBrightnessSetting()    .attach(*this);
+	renderSettings.getContrastSetting()      .attach(*this);
+	renderSettings.getColorMatrixSetting()   .attach(*this);
+	renderSettings.getLimitSpritesSetting()  .attach(*this);
+	renderSettings.getDisableSpritesSetting().attach(*this);
 }
 
 PixelRenderer::~PixelRenderer()
 {
+	renderSettings.getDisableSpritesSetting().detach(*this);
+	renderSettings.getLimitSpritesSetting()  .detach(*this);
+	renderSettings.getColorMatrixSetting()   .detach(*this);
+	renderSettings.getContrastSetting()      .detach(*this);
+	renderSettings.getBrightnessSetting()    .detach(*this);
+	renderSettings.getGammaSetting()         .detach(*this);
 	renderSettings.getMinFrameSkipSetting().detach(*this);
 	renderSettings.getMaxFrameSkipSetting().detach(*this);
 }
@@ -169,6 +224,9 @@ void PixelRenderer::reInit()
 
 	rasterizer->reset();
 	displayEnabled = vdp.isDisplayEnabled();
+
+	// Don't reuse anything from before.
+	lineTracker.reset();
 }
 
 void PixelRenderer::updateDisplayEnabled(bool enabled, EmuTime time)
@@ -220,6 +278,9 @@ void PixelRenderer::frameStart(EmuTime time)
 	}
 	renderFrame = true;
 
+	lineTracker.nextFrame();
+	currStats = {};
+
 	rasterizer->frameStart(time);
 
 	accuracy = renderSettings.getAccuracy();
@@ -239,7 +300,9 @@ void PixelRenderer::frameEnd(EmuTime time)
 
 		// Let underlying graphics system finish rendering this frame.
 		auto time1 = Timer::getTime();
-		rasterizer->frameEnd();
+		HostProfiler::profile(HostProfiler::Category::RENDER, "frame end", [&] {
+			rasterizer->frameEnd();
+		});
 		auto time2 = Timer::getTime();
 		auto current = narrow_cast<float>(time2 - time1);
 		const float ALPHA = 0.2f;
@@ -255,6 +318,7 @@ void PixelRenderer::frameEnd(EmuTime time)
 		if (paintFrame) {
 			lastPaintTime = time2;
 		}
+		lastStats = currStats;
 	}
 	if (vdp.getMotherBoard().isActive() &&
 	    !vdp.getMotherBoard().isFastForwarding()) {
@@ -270,12 +334,14 @@ void PixelRenderer::updateHorizontalScrollLow(
 {
 	if (displayEnabled) sync(time);
 	rasterizer->setHorizontalScrollLow(scroll);
+	lineTracker.markAllDirty();
 }
 
 void PixelRenderer::updateHorizontalScrollHigh(
 	uint8_t /*scroll*/, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineTracker.markAllDirty();
 }
 
 void PixelRenderer::updateBorderMask(
@@ -283,12 +349,14 @@ void PixelRenderer::updateBorderMask(
 {
 	if (displayEnabled) sync(time);
 	rasterizer->setBorderMask(masked);
+	lineTracker.markAllDirty();
 }
 
 void PixelRenderer::updateMultiPage(
 	bool /*multiPage*/, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineTracker.markAllDirty();
 }
 
 void PixelRenderer::updateTransparency(
@@ -296,6 +364,7 @@ void PixelRenderer::updateTransparency(
 {
 	if (displayEnabled) sync(time);
 	rasterizer->setTransparency(enabled);
+	lineTracker.markAllDirty();
 }
 
 void PixelRenderer::updateSuperimposing(
@@ -303,12 +372,14 @@ void PixelRenderer::updateSuperimposing(
 {
 	if (displayEnabled) sync(time);
 	rasterizer->setSuperimposeVideoFrame(videoSource);
+	lineTracker.markAllDirty();
 }
 
 void PixelRenderer::updateForegroundColor(
 	uint8_t /*color*/, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineTracker.markAllDirty();
 }
 
 void PixelRenderer::updateBackgroundColor(
@@ -316,18 +387,21 @@ void PixelRenderer::updateBackgroundColor(
 {
 	sync(time);
 	rasterizer->setBackgroundColor(color);
+	lineTracker.markAllDirty();
 }
 
 void PixelRenderer::updateBlinkForegroundColor(
 	uint8_t /*color*/, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineTracker.markAllDirty();
 }
 
 void PixelRenderer::updateBlinkBackgroundColor(
 	uint8_t /*color*/, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineTracker.markAllDirty();
 }
 
 void PixelRenderer::updateBlinkState(
@@ -338,6 +412,7 @@ void PixelRenderer::updateBlinkState(
 	//       I don't know why exactly, but it's probably related to
 	//       being called at frame start.
 	//sync(time);
+	lineTracker.markAllDirty();
 }
 
 void PixelRenderer::updatePalette(
@@ -360,12 +435,14 @@ void PixelRenderer::updatePalette(
 		}
 	}
 	rasterizer->setPalette(index, grb);
+	lineTracker.markAllDirty();
 }
 
 void PixelRenderer::updateVerticalScroll(
 	int /*scroll*/, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineTracker.markAllDirty();
 }
 
 void PixelRenderer::updateHorizontalAdjust(
@@ -373,6 +450,7 @@ void PixelRenderer::updateHorizontalAdjust(
 {
 	if (displayEnabled) sync(time);
 	rasterizer->setHorizontalAdjust(adjust);
+	lineTracker.markAllDirty();
 }
 
 void PixelRenderer::updateDisplayMode(
@@ -388,30 +466,56 @@ void PixelRenderer::updateDisplayMode(
 		sync(time, true);
 	}
 	rasterizer->setDisplayMode(mode);
+	lineTracker.markAllDirty();
 }
 
 void PixelRenderer::updateNameBase(
 	unsigned /*addr*/, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineTracker.markAllDirty();
 }
 
 void PixelRenderer::updatePatternBase(
 	unsigned /*addr*/, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineTracker.markAllDirty();
 }
 
 void PixelRenderer::updateColorBase(
 	unsigned /*addr*/, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineTracker.markAllDirty();
 }
 
 void PixelRenderer::updateSpritesEnabled(
 	bool /*enabled*/, EmuTime time
 ) {
 	if (displayEnabled) sync(time);
+	lineTracker.markAllDirty();
+}
+
+void PixelRenderer::updateSpriteSizeMag(
+	uint8_t /*sizeMag*/, EmuTime time)
+{
+	if (displayEnabled) sync(time);
+	lineTracker.markAllDirty();
+}
+
+void PixelRenderer::updateSpriteAttributeBase(
+	unsigned /*addr*/, EmuTime time)
+{
+	if (displayEnabled) sync(time);
+	lineTracker.markAllDirty();
+}
+
+void PixelRenderer::updateSpritePatternBase(
+	unsigned /*addr*/, EmuTime time)
+{
+	if (displayEnabled) sync(time);
+	lineTracker.markAllDirty();
 }
 
 static constexpr bool overlap(
@@ -522,6 +626,64 @@ bool PixelRenderer::checkSync(unsigned offset, EmuTime time) const
 	}
 }
 
+void PixelRenderer::markVRAMDirty(unsigned offset)
+{
+	// This is called for every VRAM write, so it must be fast. When in
+	// doubt, mark too much, not too little.
+	if (vdp.spritesEnabled() &&
+	    (vram.spriteAttribTable.isInside(offset) ||
+	     vram.spritePatternTable.isInside(offset))) {
+		// sprites can be anywhere
+		lineTracker.markAllDirty();
+		return;
+	}
+
+	DisplayMode mode = vdp.getDisplayMode();
+	if (mode.isBitmapMode()) {
+		// In all bitmap modes a display line is stored in a block of
+		// 256 bytes (128 in non-planar modes, but then there are twice
+		// as many blocks per page). We don't check which page(s) is/are
+		// visible.
+		lineTracker.markDirty(narrow<int>((offset >> 7) & 255), 1);
+		return;
+	}
+
+	switch (mode.getBase()) {
+	case DisplayMode::GRAPHIC2:
+	case DisplayMode::GRAPHIC3: {
+		// Same as in checkSync(): each quarter of the pattern and color
+		// table is used by 64 display lines.
+		auto markQuarters = [&](const VRAMWindow& table) {
+			unsigned vramQuarter = (offset & 0x1800) >> 11;
+			unsigned mask = (table.getMask() & 0x1800) >> 11;
+			for (auto i : xrange(4)) {
+				if ((i & mask) == vramQuarter) lineTracker.markDirty(i * 64, 64);
+			}
+		};
+		if (vram.colorTable.isInside(offset)) markQuarters(vram.colorTable);
+		if (vram.patternTable.isInside(offset)) markQuarters(vram.patternTable);
+		[[fallthrough]];
+	}
+	case DisplayMode::GRAPHIC1:
+	case DisplayMode::MULTICOLOR:
+		if (vram.nameTable.isInside(offset)) {
+			// 32 characters per row of 8 display lines
+			lineTracker.markDirty(narrow<int>(((offset & 0x3FF) / 32) * 8), 8);
+		}
+		if ((mode.getBase() == one_of(DisplayMode::GRAPHIC1, DisplayMode::MULTICOLOR)) &&
+		    (vram.colorTable.isInside(offset) || vram.patternTable.isInside(offset))) {
+			lineTracker.markAllDirty();
+		}
+		break;
+	default:
+		if (vram.nameTable.isInside(offset) ||
+		    vram.colorTable.isInside(offset) ||
+		    vram.patternTable.isInside(offset)) {
+			lineTracker.markAllDirty();
+		}
+	}
+}
+
 void PixelRenderer::updateVRAM(unsigned offset, EmuTime time)
 {
 	// Note: No need to sync if display is disabled, because then the
@@ -529,6 +691,7 @@ void PixelRenderer::updateVRAM(unsigned offset, EmuTime time)
 	if (renderFrame && displayEnabled && checkSync(offset, time)) {
 		renderUntil(time);
 	}
+	markVRAMDirty(offset);
 }
 
 void PixelRenderer::updateWindow(bool /*enabled*/, EmuTime /*time*/)
@@ -563,6 +726,18 @@ void PixelRenderer::sync(EmuTime time, bool force)
 
 void PixelRenderer::renderUntil(EmuTime time)
 {
+	HostProfiler::profile(HostProfiler::Category::RENDER, "draw", [&] {
+		renderUntilImpl(time);
+	});
+}
+
+void PixelRenderer::renderUntilImpl(EmuTime time)
+{
+	if (auto count = vram.getBulkChangeCount(); count != lastBulkChangeCount) {
+		lastBulkChangeCount = count;
+		lineTracker.markAllDirty();
+	}
+
 	// Translate from time to pixel position.
 	int limitTicks = vdp.getTicksThisFrame(time);
 	assert(limitTicks <= vdp.getTicksPerFrame());
@@ -631,11 +806,37 @@ void PixelRenderer::renderUntil(EmuTime time)
 
 void PixelRenderer::update(const Setting& setting) noexcept
 {
-	assert(&setting == one_of(&renderSettings.getMinFrameSkipSetting(),
-	                          &renderSettings.getMaxFrameSkipSetting()));
-	(void)setting;
-	// Force drawing of frame.
-	frameSkipCounter = 999;
+	if (&setting == one_of(&renderSettings.getMinFrameSkipSetting(),
+	                       &renderSettings.getMaxFrameSkipSetting())) {
+		// Force drawing of frame.
+		frameSkipCounter = 999;
+	} else {
+		// the rendered pixels change
+		lineTracker.markAllDirty();
+	}
+}
+
+
+// class LineStatsInfo
+
+PixelRenderer::LineStatsInfo::LineStatsInfo(
+		InfoCommand& machineInfoCommand, const std::string& name)
+	: InfoTopic(machineInfoCommand, name)
+{
+}
+
+void PixelRenderer::LineStatsInfo::execute(
+	std::span<const TclObject> /*tokens*/, TclObject& result) const
+{
+	const auto& renderer = OUTER(PixelRenderer, lineStatsInfo);
+	result.addDictKeyValues("drawn",  renderer.lastStats.drawn,
+	                        "reused", renderer.lastStats.reused);
+}
+
+std::string PixelRenderer::LineStatsInfo::help(std::span<const TclObject> /*tokens*/) const
+{
+	return "Number of display lines in the last rendered frame that were "
+	       "drawn, and that were copied unchanged from the frame before.";
 }
 
 } // namespace openmsx
@@ -1,11 +1,15 @@
 #ifndef PIXELRENDERER_HH
 #define PIXELRENDERER_HH
 
+#include "LineReuseTracker.hh"
 #include "RenderSettings.hh"
 #include "Renderer.hh"
+#include "VDP.hh"
 
+#include "InfoTopic.hh"
 #include "Observer.hh"
 
+#include <array>
 #include <cstdint>
 #include <memory>
 
@@ -17,7 +21,6 @@ class SpeedManager;
 class ThrottleManager;
 class Display;
 class Rasterizer;
-class VDP;
 class VDPVRAM;
 class SpriteChecker;
 class DisplayMode;
@@ -60,6 +63,9 @@ public:
 	void updatePatternBase(unsigned addr, EmuTime time) override;
 	void updateColorBase(unsigned addr, EmuTime time) override;
 	void updateSpritesEnabled(bool enabled, EmuTime time) override;
+	void updateSpriteSizeMag(uint8_t sizeMag, EmuTime time) override;
+	void updateSpriteAttributeBase(unsigned addr, EmuTime time) override;
+	void updateSpritePatternBase(unsigned addr, EmuTime time) override;
 	void updateVRAM(unsigned offset, EmuTime time) override;
 	void updateWindow(bool enabled, EmuTime time) override;
 
@@ -75,7 +81,7 @@ private:
 	  */
 	void draw(
 		int startX, int startY, int endX, int endY, DrawType drawType,
-		bool atEnd);
+		bool atEnd, bool fullLines);
 
 	/** Subdivide an area specified by two scan positions into a series of
 	  * rectangles.
@@ -90,6 +96,9 @@ private:
 
 	[[nodiscard]] bool checkSync(unsigned offset, EmuTime time) const;
 
+	/** Mark the display lines that (may) show the given VRAM address. */
+	void markVRAMDirty(unsigned offset);
+
 	/** Update renderer state to specified moment in time.
 	  * @param time Moment in emulated time to update to.
 	  * @param force When screen accuracy is used,
@@ -104,6 +113,7 @@ private:
 	  * @param time Moment in emulated time to render lines until.
 	  */
 	void renderUntil(EmuTime time);
+	void renderUntilImpl(EmuTime time);
 
 private:
 	/** The VDP of which the video output is being rendered.
@@ -169,6 +179,27 @@ private:
 	  * Used to force a minimal paint rate when throttle is off.
 	  */
 	uint64_t lastPaintTime = 0;
+
+	/** Which lines can be copied from the previous frame. */
+	LineReuseTracker<VDP::PAL_LINES> lineTracker;
+	unsigned lastBulkChangeCount = 0;
+
+	/** Number of display lines that were drawn or copied, in the current
+	  * and in the last completed frame.
+	  */
+	struct LineStats {
+		unsigned drawn = 0;
+		unsigned reused = 0;
+	};
+	LineStats currStats;
+	LineStats lastStats;
+
+	struct LineStatsInfo final : InfoTopic {
+		LineStatsInfo(InfoCommand& machineInfoCommand, const std::string& name);
+		void execute(std::span<const TclObject> tokens,
+		             TclObject& result) const override;
+		[[nodiscard]] std::string help(std::span<const TclObject> tokens) const override;
+	} lineStatsInfo;
 };
 
 } // namespace openmsx
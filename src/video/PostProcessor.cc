@@ -13,6 +13,7 @@
 #include "GLContext.hh"
 #include "GLScaler.hh"
 #include "GLScalerFactory.hh"
+#include "HostProfiler.hh"
 #include "MSXMotherBoard.hh"
 #include "OutputSurface.hh"
 #include "PNG.hh"
@@ -221,6 +222,13 @@ void PostProcessor::createRegions()
 }
 
 void PostProcessor::paint(OutputSurface& /*output*/)
+{
+	HostProfiler::profile(HostProfiler::Category::POST_PROCESS, "paint", [&] {
+		paintImpl();
+	});
+}
+
+void PostProcessor::paintImpl()
 {
 	if (renderSettings.getInterleaveBlackFrame()) {
 		interleaveCount ^= 1;
@@ -481,6 +489,13 @@ void PostProcessor::update(const Setting& setting) noexcept
 }
 
 void PostProcessor::uploadFrame()
+{
+	HostProfiler::profile(HostProfiler::Category::POST_PROCESS, "upload", [&] {
+		uploadFrameImpl();
+	});
+}
+
+void PostProcessor::uploadFrameImpl()
 {
 	createRegions();
 
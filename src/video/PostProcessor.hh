@@ -117,7 +117,9 @@ private:
 
 	void initBuffers();
 	void createRegions();
+	void paintImpl();
 	void uploadFrame();
+	void uploadFrameImpl();
 	void uploadBlock(unsigned srcStartY, unsigned srcEndY,
 	                 unsigned lineWidth);
 
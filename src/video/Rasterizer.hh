@@ -105,6 +105,17 @@ public:
 		int displayX, int displayY,
 		int displayWidth, int displayHeight) = 0;
 
+	/** Copy lines from the previously rendered frame to the working
+	  * frame, instead of drawing them again. The caller guarantees that
+	  * nothing that affects these lines changed since they were drawn
+	  * in that frame.
+	  * @param fromY Y coordinate of the first line in absolute lines.
+	  * @param limitY Y coordinate of the end (exclusive).
+	  * @return False if the lines can't be copied (e.g. there is no
+	  *         previous frame), then the caller must draw them normally.
+	  */
+	[[nodiscard]] virtual bool copyFromLastFrame(int fromY, int limitY) = 0;
+
 	/** Is video recording active?
 	  */
 	[[nodiscard]] virtual bool isRecording() const = 0;
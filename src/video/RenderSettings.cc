@@ -178,6 +178,12 @@ RenderSettings::RenderSettings(CommandController& commandController)
 		"Useful on (100Hz+) lightboost enabled monitors to reduce "
 		"motion blur and double frame artifacts.",
 		false)
+
+	, renderWorkersSetting(commandController,
+		"render_workers",
+		"number of extra threads used to render the lines of the MSX "
+		"display, 0 means all lines are rendered on the main thread",
+		0, 0, 16)
 {
 	brightnessSetting.attach(*this);
 	contrastSetting  .attach(*this);
@@ -187,6 +187,11 @@ public:
 		return interleaveBlackFrameSetting.getBoolean();
 	}
 
+	/** Number of extra threads used to render the lines of the MSX
+	  * display (SDL renderers), 0 means single threaded. */
+	[[nodiscard]] IntegerSetting& getRenderWorkersSetting() { return renderWorkersSetting; }
+	[[nodiscard]] unsigned getRenderWorkers() const { return unsigned(renderWorkersSetting.getInt()); }
+
 	/** Apply brightness, contrast and gamma transformation on the input
 	  * color component. The component is expected to be in the range
 	  * [0.0 .. 1.0] but it's not an error if it lays outside of this range.
@@ -246,6 +251,7 @@ private:
 	FloatSetting horizontalStretchSetting;
 	FloatSetting pointerHideDelaySetting;
 	BooleanSetting interleaveBlackFrameSetting;
+	IntegerSetting renderWorkersSetting;
 
 	float brightness;
 	float contrast;
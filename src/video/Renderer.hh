@@ -182,6 +182,26 @@ public:
 	  */
 	virtual void updateSpritesEnabled(bool enabled, EmuTime time) = 0;
 
+	/** Informs the renderer of a sprite size or magnification change.
+	  * @param sizeMag The new size and magnification state.
+	  *   Bit 0 is magnification: 0 = normal, 1 = doubled.
+	  *   Bit 1 is size: 0 = 8x8, 1 = 16x16.
+	  * @param time The moment in emulated time this change occurs.
+	  */
+	virtual void updateSpriteSizeMag(uint8_t sizeMag, EmuTime time) = 0;
+
+	/** Informs the renderer of a sprite attribute table base address change.
+	  * @param addr The new base address.
+	  * @param time The moment in emulated time this change occurs.
+	  */
+	virtual void updateSpriteAttributeBase(unsigned addr, EmuTime time) = 0;
+
+	/** Informs the renderer of a sprite pattern table base address change.
+	  * @param addr The new base address.
+	  * @param time The moment in emulated time this change occurs.
+	  */
+	virtual void updateSpritePatternBase(unsigned addr, EmuTime time) = 0;
+
 	/** Sprite palette in Graphic 7 mode.
           * See page 98 of the V9938 data book.
 	  * Each palette entry is a word in GRB format:
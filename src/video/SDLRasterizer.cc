@@ -6,6 +6,7 @@
 #include "RawFrame.hh"
 #include "RenderSettings.hh"
 #include "Renderer.hh"
+#include "ThreadPool.hh"
 #include "VDP.hh"
 #include "VDPVRAM.hh"
 
@@ -118,10 +119,12 @@ SDLRasterizer::SDLRasterizer(
 	renderSettings.getBrightnessSetting() .attach(*this);
 	renderSettings.getContrastSetting()   .attach(*this);
 	renderSettings.getColorMatrixSetting().attach(*this);
+	renderSettings.getRenderWorkersSetting().attach(*this);
 }
 
 SDLRasterizer::~SDLRasterizer()
 {
+	renderSettings.getRenderWorkersSetting().detach(*this);
 	renderSettings.getColorMatrixSetting().detach(*this);
 	renderSettings.getGammaSetting()      .detach(*this);
 	renderSettings.getBrightnessSetting() .detach(*this);
@@ -189,6 +192,7 @@ void SDLRasterizer::frameStart(EmuTime time)
 	// 240 - 212 = 28 lines available for top/bottom border; 14 each.
 	// NTSC: display at [32..244),
 	// PAL:  display at [59..271).
+	lastLineRenderTop = lineRenderTop;
 	lineRenderTop = vdp.isPalTiming() ? 59 - 14 : 32 - 14;
 }
 
@@ -445,6 +449,50 @@ void SDLRasterizer::drawBorder(
 	}
 }
 
+ThreadPool* SDLRasterizer::getRenderWorkers()
+{
+	auto num = renderSettings.getRenderWorkers();
+	if (num == 0) return nullptr;
+	if (!renderWorkers) {
+		renderWorkers = std::make_unique<ThreadPool>(num);
+	}
+	return renderWorkers.get();
+}
+
+template<typename RenderLines>
+void SDLRasterizer::renderLinesParallel(int begin, int end, RenderLines renderLines)
+{
+	// Below this many lines per thread, the overhead of handing over the
+	// work is larger than the gain. This is typically only reached when the
+	// VDP registers don't change during the frame (so when the whole
+	// display area is drawn in one go).
+	static constexpr int MIN_LINES = 16;
+
+	auto* workers = getRenderWorkers();
+	int numLines = end - begin;
+	int numChunks = workers
+		? std::min(narrow<int>(workers->getNumThreads() + 1), numLines / MIN_LINES)
+		: 1;
+	if (numChunks <= 1) {
+		renderLines(begin, end);
+		return;
+	}
+
+	// The VDP and VRAM state doesn't change while the lines are rendered
+	// (the emulation is halted until all chunks are done) and each line of
+	// the work frame is written by exactly one chunk. So the result is
+	// identical to rendering all lines on the main thread.
+	auto chunkBegin = [&](int i) { return begin + (numLines * i) / numChunks; };
+	renderTasks.clear();
+	for (auto i : xrange(1, numChunks)) {
+		renderTasks.push_back(workers->enqueue([&, i] {
+			renderLines(chunkBegin(i), chunkBegin(i + 1));
+		}));
+	}
+	renderLines(begin, chunkBegin(1)); // the main thread takes part as well
+	for (auto& task : renderTasks) task.get();
+}
+
 void SDLRasterizer::drawDisplay(
 	int /*fromX*/, int fromY,
 	int displayX, int displayY,
@@ -504,71 +552,79 @@ void SDLRasterizer::drawDisplay(
 	pageBorder = std::min(pageBorder, pageSplit);
 
 	if (mode.isBitmapMode()) {
-		for (auto y : xrange(screenY, screenLimitY)) {
-			// Which bits in the name mask determine the page?
-			// TODO optimize this?
-			//   Calculating pageMaskOdd/Even is a non-trivial amount
-			//   of work. We used to do this per frame (more or less)
-			//   but now do it per line. Per-line is actually only
-			//   needed when vdp.isFastBlinkEnabled() is true.
-			//   Idea: can be cheaply calculated incrementally.
-			unsigned pageMaskOdd = (mode.isPlanar() ? 0x000 : 0x200) |
-				vdp.getEvenOddMask(y);
-			unsigned pageMaskEven = vdp.isMultiPageScrolling()
-				? (pageMaskOdd & ~0x100)
-				: pageMaskOdd;
-			const std::array<unsigned, 2> vramLine = {
-				(vram.nameTable.getMask() >> 7) & (pageMaskEven | displayY),
-				(vram.nameTable.getMask() >> 7) & (pageMaskOdd  | displayY)
-			};
-
-			std::array<Pixel, 512> buf;
-			auto lineInBuf = unsigned(-1); // buffer data not valid
-			auto dst = workFrame->getLineDirect(y).subspan(leftBackground + displayX);
-			int firstPageWidth = pageBorder - displayX;
-			if (firstPageWidth > 0) {
-				if (((displayX + hScroll) == 0) &&
-				    (firstPageWidth == narrow<int>(lineWidth))) {
-					// fast-path, directly render to destination
-					renderBitmapLine(dst, vramLine[scrollPage1]);
+		// calcDPalette() must not run concurrently on the render workers
+		bitmapConverter.prepareConcurrentUse();
+		renderLinesParallel(screenY, screenLimitY, [&](int first, int last) {
+			int lineY = (displayY + first - screenY) & 255;
+			for (auto y : xrange(first, last)) {
+				// Which bits in the name mask determine the page?
+				// TODO optimize this?
+				//   Calculating pageMaskOdd/Even is a non-trivial amount
+				//   of work. We used to do this per frame (more or less)
+				//   but now do it per line. Per-line is actually only
+				//   needed when vdp.isFastBlinkEnabled() is true.
+				//   Idea: can be cheaply calculated incrementally.
+				unsigned pageMaskOdd = (mode.isPlanar() ? 0x000 : 0x200) |
+					vdp.getEvenOddMask(y);
+				unsigned pageMaskEven = vdp.isMultiPageScrolling()
+					? (pageMaskOdd & ~0x100)
+					: pageMaskOdd;
+				const std::array<unsigned, 2> vramLine = {
+					(vram.nameTable.getMask() >> 7) & (pageMaskEven | lineY),
+					(vram.nameTable.getMask() >> 7) & (pageMaskOdd  | lineY)
+				};
+
+				std::array<Pixel, 512> buf;
+				auto lineInBuf = unsigned(-1); // buffer data not valid
+				auto dst = workFrame->getLineDirect(y).subspan(leftBackground + displayX);
+				int firstPageWidth = pageBorder - displayX;
+				if (firstPageWidth > 0) {
+					if (((displayX + hScroll) == 0) &&
+					    (firstPageWidth == narrow<int>(lineWidth))) {
+						// fast-path, directly render to destination
+						renderBitmapLine(dst, vramLine[scrollPage1]);
+					} else {
+						lineInBuf = vramLine[scrollPage1];
+						renderBitmapLine(buf, vramLine[scrollPage1]);
+						auto src = subspan(buf, displayX + hScroll, firstPageWidth);
+						copy_to_range(src, dst);
+					}
 				} else {
-					lineInBuf = vramLine[scrollPage1];
-					renderBitmapLine(buf, vramLine[scrollPage1]);
-					auto src = subspan(buf, displayX + hScroll, firstPageWidth);
-					copy_to_range(src, dst);
+					firstPageWidth = 0;
 				}
-			} else {
-				firstPageWidth = 0;
-			}
-			if (firstPageWidth < displayWidth) {
-				if (lineInBuf != vramLine[scrollPage2]) {
-					renderBitmapLine(buf, vramLine[scrollPage2]);
+				if (firstPageWidth < displayWidth) {
+					if (lineInBuf != vramLine[scrollPage2]) {
+						renderBitmapLine(buf, vramLine[scrollPage2]);
+					}
+					unsigned x = displayX < pageBorder
+						   ? 0 : displayX + hScroll - lineWidth;
+					copy_to_range(subspan(buf, x, displayWidth - firstPageWidth),
+					              subspan(dst, firstPageWidth));
 				}
-				unsigned x = displayX < pageBorder
-					   ? 0 : displayX + hScroll - lineWidth;
-				copy_to_range(subspan(buf, x, displayWidth - firstPageWidth),
-				              subspan(dst, firstPageWidth));
-			}
 
-			displayY = (displayY + 1) & 255;
-		}
+				lineY = (lineY + 1) & 255;
+			}
+		});
 	} else {
 		// horizontal scroll (high) is implemented in CharacterConverter
-		for (auto y : xrange(screenY, screenLimitY)) {
-			assert(!vdp.isMSX1VDP() || displayY < 192);
+		renderLinesParallel(screenY, screenLimitY, [&](int first, int last) {
+			int lineY = (displayY + first - screenY) & 255;
+			for (auto y : xrange(first, last)) {
+				assert(!vdp.isMSX1VDP() || lineY < 192);
+
+				auto dst = workFrame->getLineDirect(y).subspan(leftBackground + displayX);
+				if ((displayX == 0) && (displayWidth == narrow<int>(lineWidth))){
+					characterConverter.convertLine(dst, lineY);
+				} else {
+					std::array<Pixel, 512> buf;
+					characterConverter.convertLine(buf, lineY);
+					auto src = subspan(buf, displayX, displayWidth);
+					copy_to_range(src, dst);
+				}
 
-			auto dst = workFrame->getLineDirect(y).subspan(leftBackground + displayX);
-			if ((displayX == 0) && (displayWidth == narrow<int>(lineWidth))){
-				characterConverter.convertLine(dst, displayY);
-			} else {
-				std::array<Pixel, 512> buf;
-				characterConverter.convertLine(buf, displayY);
-				auto src = subspan(buf, displayX, displayWidth);
-				copy_to_range(src, dst);
+				lineY = (lineY + 1) & 255;
 			}
-
-			displayY = (displayY + 1) & 255;
-		}
+		});
 	}
 }
 
@@ -595,39 +651,67 @@ void SDLRasterizer::drawSprites(
 	//       pixels in this display mode?
 	int spriteMode = vdp.getDisplayMode().getSpriteMode(vdp.isMSX1VDP());
 	int displayLimitX = displayX + displayWidth;
-	int limitY = fromY + displayHeight;
 	int screenX = translateX(
 		vdp.getLeftSprites(),
 		vdp.getDisplayMode().getLineWidth() == 512);
+	auto drawLines = [&](auto drawLine) {
+		renderLinesParallel(screenY, screenLimitY, [&](int first, int last) {
+			for (auto sy : xrange(first, last)) {
+				auto dst = workFrame->getLineDirect(sy).subspan(screenX);
+				drawLine(fromY + (sy - screenY), dst);
+			}
+		});
+	};
 	if (spriteMode == 1) {
-		for (int y = fromY; y < limitY; y++, screenY++) {
-			auto dst = workFrame->getLineDirect(screenY).subspan(screenX);
+		drawLines([&](int y, std::span<Pixel> dst) {
 			spriteConverter.drawMode1(y, displayX, displayLimitX, dst);
-		}
+		});
 	} else {
 		uint8_t mode = vdp.getDisplayMode().getByte();
 		if (mode == DisplayMode::GRAPHIC5) {
-			for (int y = fromY; y < limitY; y++, screenY++) {
-				auto dst = workFrame->getLineDirect(screenY).subspan(screenX);
+			drawLines([&](int y, std::span<Pixel> dst) {
 				spriteConverter.template drawMode2<DisplayMode::GRAPHIC5>(
 					y, displayX, displayLimitX, dst);
-			}
+			});
 		} else if (mode == DisplayMode::GRAPHIC6) {
-			for (int y = fromY; y < limitY; y++, screenY++) {
-				auto dst = workFrame->getLineDirect(screenY).subspan(screenX);
+			drawLines([&](int y, std::span<Pixel> dst) {
 				spriteConverter.template drawMode2<DisplayMode::GRAPHIC6>(
 					y, displayX, displayLimitX, dst);
-			}
+			});
 		} else {
-			for (int y = fromY; y < limitY; y++, screenY++) {
-				auto dst = workFrame->getLineDirect(screenY).subspan(screenX);
+			drawLines([&](int y, std::span<Pixel> dst) {
 				spriteConverter.template drawMode2<DisplayMode::GRAPHIC4>(
 					y, displayX, displayLimitX, dst);
-			}
+			});
 		}
 	}
 }
 
+bool SDLRasterizer::copyFromLastFrame(int fromY, int limitY)
+{
+	// The last frame must have the display area at the same position, and
+	// it must be a full frame (with interlacing, consecutive frames show
+	// different fields).
+	const RawFrame* lastFrame = postProcessor->getLastRawFrame();
+	if (!lastFrame || (lineRenderTop != lastLineRenderTop) ||
+	    (lastFrame->getField() != FrameSource::FieldType::NONINTERLACED) ||
+	    (workFrame->getField() != FrameSource::FieldType::NONINTERLACED)) {
+		return false;
+	}
+
+	// Clip to screen area. The complete line is copied, that includes the
+	// (unchanged) left and right border.
+	int screenY = std::max(fromY - lineRenderTop, 0);
+	int screenLimitY = std::min(limitY - lineRenderTop, 240);
+	for (auto y : xrange(screenY, screenLimitY)) {
+		auto width = lastFrame->getLineWidthDirect(y);
+		copy_to_range(lastFrame->getLineDirect(y).first(width),
+		              workFrame->getLineDirect(y));
+		workFrame->setLineWidth(y, width);
+	}
+	return true;
+}
+
 bool SDLRasterizer::isRecording() const
 {
 	return postProcessor->isRecording();
@@ -641,6 +725,9 @@ void SDLRasterizer::update(const Setting& setting) noexcept
 	                       &renderSettings.getColorMatrixSetting())) {
 		precalcPalette();
 		resetPalette();
+	} else if (&setting == &renderSettings.getRenderWorkersSetting()) {
+		// (re)created with the new number of threads on next use
+		renderWorkers.reset();
 	}
 }
 
@@ -10,7 +10,9 @@
 
 #include <array>
 #include <cstdint>
+#include <future>
 #include <memory>
+#include <vector>
 
 namespace openmsx {
 
@@ -22,6 +24,7 @@ class RawFrame;
 class RenderSettings;
 class Setting;
 class PostProcessor;
+class ThreadPool;
 
 /** Rasterizer using a frame buffer approach: it writes pixels to a single
   * rectangular pixel buffer.
@@ -66,11 +69,25 @@ public:
 		int fromX, int fromY,
 		int displayX, int displayY,
 		int displayWidth, int displayHeight) override;
+	[[nodiscard]] bool copyFromLastFrame(int fromY, int limitY) override;
 	[[nodiscard]] bool isRecording() const override;
 
 private:
 	inline void renderBitmapLine(std::span<Pixel> buf, unsigned vramLine);
 
+	/** Calls 'renderLines(first, last)' for consecutive sub-ranges that
+	  * together cover the screen lines [begin, end). When the
+	  * 'render_workers' setting is non-zero (and there are enough lines)
+	  * these sub-ranges are rendered in parallel, see drawDisplay().
+	  */
+	template<typename RenderLines>
+	void renderLinesParallel(int begin, int end, RenderLines renderLines);
+
+	/** The threads used by renderLinesParallel(), or nullptr when all
+	  * lines must be rendered on the main thread.
+	  */
+	[[nodiscard]] ThreadPool* getRenderWorkers();
+
 	/** Reload entire palette from VDP.
 	  */
 	void resetPalette();
@@ -135,7 +152,10 @@ private:
 	/** Line to render at top of display.
 	  * After all, our screen is 240 lines while display is 262 or 313.
 	  */
-	int lineRenderTop;
+	int lineRenderTop = 0;
+
+	/** Value of lineRenderTop in the previous frame. */
+	int lastLineRenderTop = -1;
 
 	/** Host colors corresponding to each VDP palette entry.
 	  * palFg has entry 0 set to the current background color.
@@ -164,6 +184,10 @@ private:
 	/** Host colors corresponding to each possible V9958 color.
 	  */
 	std::array<Pixel, 32768> V9958_COLORS;
+
+	/** Created on demand, see getRenderWorkers(). */
+	std::unique_ptr<ThreadPool> renderWorkers;
+	std::vector<std::future<void>> renderTasks;
 };
 
 } // namespace openmsx
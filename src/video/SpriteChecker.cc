@@ -15,6 +15,9 @@ TODO:
 #include "BooleanSetting.hh"
 #include "serialize.hh"
 
+#include "narrow.hh"
+#include "xrange.hh"
+
 #include <algorithm>
 #include <bit>
 #include <cassert>
@@ -40,6 +43,36 @@ void SpriteChecker::reset(EmuTime time)
 	frameStart(time);
 
 	updateSpritesMethod = &SpriteChecker::updateSprites1;
+	spriteLinesDirty = true;
+}
+
+unsigned SpriteChecker::updateSpriteLines(int spriteMode, int magSize)
+{
+	if (!spriteLinesDirty &&
+	    (bulkChangeCount == vram.getBulkChangeCount()) &&
+	    (unsigned(magSize) == spriteLines.getMagSize())) {
+		return spriteLinesCount;
+	}
+	spriteLinesDirty = false;
+	bulkChangeCount = vram.getBulkChangeCount();
+
+	std::array<uint8_t, 32> ys;
+	uint8_t terminator = 216;
+	if (spriteMode == 1) {
+		auto attributePtr = vram.spriteAttribTable.getReadArea<32 * 4>(0);
+		for (auto sprite : xrange(32)) ys[sprite] = attributePtr[4 * sprite];
+		terminator = 208;
+	} else if (planar) {
+		auto [attributePtr0, attributePtr1] =
+			vram.spriteAttribTable.getReadAreaPlanar<32 * 4>(512);
+		for (auto sprite : xrange(32)) ys[sprite] = attributePtr0[2 * sprite];
+	} else {
+		auto attributePtr0 = vram.spriteAttribTable.getReadArea<32 * 4>(512);
+		for (auto sprite : xrange(32)) ys[sprite] = attributePtr0[4 * sprite];
+	}
+	spriteLinesCount = narrow<unsigned>(std::ranges::find(ys, terminator) - ys.begin());
+	spriteLines.update(ys, spriteLinesCount, magSize);
+	return spriteLinesCount;
 }
 
 inline SpriteChecker::SpritePattern SpriteChecker::calculatePatternNP(
@@ -86,21 +119,19 @@ void SpriteChecker::updateSprites1(int limit)
 
 inline void SpriteChecker::checkSprites1(int minLine, int maxLine)
 {
-	// This implementation contains a double for-loop. The outer loop goes
-	// over the sprites, the inner loop over the to-be-checked lines. This
-	// is not the order in which the real VDP performs this operation: the
-	// real VDP renders line-per-line and for each line checks all 32
-	// sprites.
-	//
-	// Though this 'reverse' order allows to skip over very large regions
-	// of the inner loop: we only have to process the lines were a
-	// particular sprite is actually visible. I measured this makes this
-	// routine 4x-5x faster!
+	// Like the real VDP we go line-per-line, and for each line over the
+	// sprites in order. But instead of checking all 32 sprites we only
+	// visit the sprites that are visible on that line, see
+	// SpriteLineMasks. Those masks only need to be recalculated when the
+	// sprite attribute table changes, and then only for the sprites that
+	// actually moved. This matters because this routine is often called
+	// for only one or a few lines (e.g. on each VRAM write or status
+	// register read).
 	//
 	// This routine also needs to detect the sprite number of the 'first'
 	// 5th-sprite-condition. With 'first' meaning the first line where this
-	// condition occurs. Because our loops are swapped compared to the real
-	// VDP, we need some extra fixup logic to correctly detect this.
+	// condition occurs. Because we go line-per-line, that's simply the
+	// first time we encounter it.
 
 	// Calculate display line.
 	// This is the line sprites are checked at; the line they are displayed
@@ -115,39 +146,28 @@ inline void SpriteChecker::checkSprites1(int minLine, int maxLine)
 	auto attributePtr = vram.spriteAttribTable.getReadArea<32 * 4>(0);
 	uint8_t patternIndexMask = size == 16 ? 0xFC : 0xFF;
 	int fifthSpriteNum  = -1;  // no 5th sprite detected yet
-	int fifthSpriteLine = 999; // larger than any possible valid line
-
-	int sprite = 0;
-	for (/**/; sprite < 32; ++sprite) {
-		int y = attributePtr[4 * sprite + 0];
-		if (y == 208) break;
 
-		for (int line = minLine; line < maxLine; ++line) { // 'line' changes in loop
+	int sprite = narrow<int>(updateSpriteLines(1, magSize));
+	for (auto line : xrange(minLine, maxLine)) {
+		int displayLine = line + displayDelta;
+		for (uint32_t mask = spriteLines.getMask(displayLine); mask; mask &= mask - 1) {
+			int s = std::countr_zero(mask);
 			// Calculate line number within the sprite.
-			int displayLine = line + displayDelta;
-			int spriteLine = (displayLine - y) & 0xFF;
-			if (spriteLine >= magSize) {
-				// Skip ahead till sprite becomes visible.
-				line += 256 - spriteLine - 1; // -1 because of for-loop
-				continue;
-			}
+			int spriteLine = (displayLine - spriteLines.getY(s)) & 0xFF;
+			assert(spriteLine < magSize);
 
 			auto visibleIndex = spriteCount[line];
 			if (visibleIndex == 4) {
-				// Find earliest line where this condition occurs.
-				if (line < fifthSpriteLine) {
-					fifthSpriteLine = line;
-					fifthSpriteNum = sprite;
-				}
-				if (limitSprites) continue;
+				if (fifthSpriteNum == -1) fifthSpriteNum = s;
+				if (limitSprites) break;
 			}
 
 			SpriteInfo& sip = spriteBuffer[line][visibleIndex];
-			int patternIndex = attributePtr[4 * sprite + 2] & patternIndexMask;
+			int patternIndex = attributePtr[4 * s + 2] & patternIndexMask;
 			if (mag) spriteLine /= 2;
 			sip.pattern = calculatePatternNP(patternIndex, spriteLine);
-			sip.x = attributePtr[4 * sprite + 1];
-			uint8_t colorAttrib = attributePtr[4 * sprite + 3];
+			sip.x = attributePtr[4 * s + 1];
+			uint8_t colorAttrib = attributePtr[4 * s + 3];
 			if (colorAttrib & 0x80) sip.x -= 32;
 			sip.colorAttrib = colorAttrib;
 
@@ -276,48 +296,37 @@ inline void SpriteChecker::checkSprites2(int minLine, int maxLine)
 	int magSize = (mag + 1) * size;
 	int patternIndexMask = (size == 16) ? 0xFC : 0xFF;
 	int ninthSpriteNum  = -1;  // no 9th sprite detected yet
-	int ninthSpriteLine = 999; // larger than any possible valid line
 
 	// Because it gave a measurable performance boost, we duplicated the
 	// code for planar and non-planar modes.
-	int sprite = 0;
+	int sprite = narrow<int>(updateSpriteLines(2, magSize));
 	if (planar) {
 		auto [attributePtr0, attributePtr1] =
 			vram.spriteAttribTable.getReadAreaPlanar<32 * 4>(512);
 		// TODO: Verify CC implementation.
-		for (/**/; sprite < 32; ++sprite) {
-			int y = attributePtr0[2 * sprite + 0];
-			if (y == 216) break;
-
-			for (int line = minLine; line < maxLine; ++line) { // 'line' changes in loop
+		for (auto line : xrange(minLine, maxLine)) {
+			int displayLine = line + displayDelta;
+			for (uint32_t mask = spriteLines.getMask(displayLine); mask; mask &= mask - 1) {
+				int s = std::countr_zero(mask);
 				// Calculate line number within the sprite.
-				int displayLine = line + displayDelta;
-				int spriteLine = (displayLine - y) & 0xFF;
-				if (spriteLine >= magSize) {
-					// Skip ahead till sprite is visible.
-					line += 256 - spriteLine - 1;
-					continue;
-				}
+				int spriteLine = (displayLine - spriteLines.getY(s)) & 0xFF;
+				assert(spriteLine < magSize);
 
 				auto visibleIndex = spriteCount[line];
 				if (visibleIndex == 8) {
-					// Find earliest line where this condition occurs.
-					if (line < ninthSpriteLine) {
-						ninthSpriteLine = line;
-						ninthSpriteNum = sprite;
-					}
-					if (limitSprites) continue;
+					if (ninthSpriteNum == -1) ninthSpriteNum = s;
+					if (limitSprites) break;
 				}
 
 				if (mag) spriteLine /= 2;
-				unsigned colorIndex = (~0u << 10) | (sprite * 16 + spriteLine);
+				unsigned colorIndex = (~0u << 10) | (s * 16 + spriteLine);
 				uint8_t colorAttrib =
 					vram.spriteAttribTable.readPlanar(colorIndex);
 
 				SpriteInfo& sip = spriteBuffer[line][visibleIndex];
-				int patternIndex = attributePtr0[2 * sprite + 1] & patternIndexMask;
+				int patternIndex = attributePtr0[2 * s + 1] & patternIndexMask;
 				sip.pattern = calculatePatternPlanar(patternIndex, spriteLine);
-				sip.x = attributePtr1[2 * sprite + 0];
+				sip.x = attributePtr1[2 * s + 0];
 				if (colorAttrib & 0x80) sip.x -= 32;
 				sip.colorAttrib = colorAttrib;
 
@@ -330,32 +339,22 @@ inline void SpriteChecker::checkSprites2(int minLine, int maxLine)
 		auto attributePtr0 =
 			vram.spriteAttribTable.getReadArea<32 * 4>(512);
 		// TODO: Verify CC implementation.
-		for (/**/; sprite < 32; ++sprite) {
-			int y = attributePtr0[4 * sprite + 0];
-			if (y == 216) break;
-
-			for (int line = minLine; line < maxLine; ++line) { // 'line' changes in loop
+		for (auto line : xrange(minLine, maxLine)) {
+			int displayLine = line + displayDelta;
+			for (uint32_t mask = spriteLines.getMask(displayLine); mask; mask &= mask - 1) {
+				int s = std::countr_zero(mask);
 				// Calculate line number within the sprite.
-				int displayLine = line + displayDelta;
-				int spriteLine = (displayLine - y) & 0xFF;
-				if (spriteLine >= magSize) {
-					// Skip ahead till sprite is visible.
-					line += 256 - spriteLine - 1;
-					continue;
-				}
+				int spriteLine = (displayLine - spriteLines.getY(s)) & 0xFF;
+				assert(spriteLine < magSize);
 
 				auto visibleIndex = spriteCount[line];
 				if (visibleIndex == 8) {
-					// Find earliest line where this condition occurs.
-					if (line < ninthSpriteLine) {
-						ninthSpriteLine = line;
-						ninthSpriteNum = sprite;
-					}
-					if (limitSprites) continue;
+					if (ninthSpriteNum == -1) ninthSpriteNum = s;
+					if (limitSprites) break;
 				}
 
 				if (mag) spriteLine /= 2;
-				unsigned colorIndex = (~0u << 10) | (sprite * 16 + spriteLine);
+				unsigned colorIndex = (~0u << 10) | (s * 16 + spriteLine);
 				uint8_t colorAttrib =
 					vram.spriteAttribTable.readNP(colorIndex);
 				// Sprites with CC=1 are only visible if preceded by
@@ -365,9 +364,9 @@ inline void SpriteChecker::checkSprites2(int minLine, int maxLine)
 				//    https://github.com/openMSX/openMSX/issues/497
 
 				SpriteInfo& sip = spriteBuffer[line][visibleIndex];
-				int patternIndex = attributePtr0[4 * sprite + 2] & patternIndexMask;
+				int patternIndex = attributePtr0[4 * s + 2] & patternIndexMask;
 				sip.pattern = calculatePatternNP(patternIndex, spriteLine);
-				sip.x = attributePtr0[4 * sprite + 1];
+				sip.x = attributePtr0[4 * s + 1];
 				if (colorAttrib & 0x80) sip.x -= 32;
 				sip.colorAttrib = colorAttrib;
 
@@ -499,6 +498,7 @@ void SpriteChecker::serialize(Archive& ar, unsigned version)
 		// first (partial) frame after loadstate.
 		std::ranges::fill(spriteCount, 0);
 		// content of spriteBuffer[] doesn't matter if spriteCount[] is 0
+		spriteLinesDirty = true;
 	}
 	ar.serialize("collisionX", collisionX,
 	             "collisionY", collisionY);
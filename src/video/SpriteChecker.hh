@@ -2,6 +2,7 @@
 #define SPRITECHECKER_HH
 
 #include "DisplayMode.hh"
+#include "SpriteLineMasks.hh"
 #include "VDP.hh"
 #include "VDPVRAM.hh"
 #include "VRAMObserver.hh"
@@ -115,6 +116,7 @@ public:
 	void updateDisplayMode(DisplayMode mode, EmuTime time) {
 		sync(time);
 		setDisplayMode(mode);
+		spriteLinesDirty = true; // attribute table layout may change
 
 		// The following is only required when switching from sprite
 		// mode0 to some other mode (in other case it has no effect).
@@ -267,10 +269,13 @@ public:
 
 	void updateVRAM(unsigned /*offset*/, EmuTime time) override {
 		checkUntil(time);
+		// Could also be a write to the pattern table, we can't tell.
+		spriteLinesDirty = true;
 	}
 
 	void updateWindow(bool /*enabled*/, EmuTime time) override {
 		sync(time);
+		spriteLinesDirty = true;
 	}
 
 	template<typename Archive>
@@ -317,6 +322,15 @@ private:
 	[[nodiscard]] SpritePattern calculatePatternNP(unsigned patternNr, unsigned y) const;
 	[[nodiscard]] SpritePattern calculatePatternPlanar(unsigned patternNr, unsigned y) const;
 
+	/** Bring 'spriteLines' up-to-date with the sprite attribute table,
+	  * but only re-read the attribute table when it (possibly) changed.
+	  * @param spriteMode 1 or 2.
+	  * @param magSize Height of the sprites in lines.
+	  * @return The number of active sprites (the index of the first
+	  *         sprite with the terminating Y-coordinate, or 32).
+	  */
+	unsigned updateSpriteLines(int spriteMode, int magSize);
+
 	/** Check sprite collision and number of sprites per line.
 	  * This routine implements sprite mode 1 (MSX1).
 	  * Separated from display code to make MSX behaviour consistent
@@ -393,6 +407,15 @@ private:
 	  */
 	std::array<uint8_t, VDP::NUM_LINES_MAX> spriteCount;
 
+	/** The sprites that are visible on each display line. Only updated
+	  * when 'spriteLinesDirty' is set, or when the whole VRAM changed
+	  * (see VDPVRAM::getBulkChangeCount()).
+	  */
+	SpriteLineMasks spriteLines;
+	unsigned spriteLinesCount = 0;
+	unsigned bulkChangeCount = 0;
+	bool spriteLinesDirty = true;
+
 	/** Is current display mode planar or not?
 	  * TODO: Introduce separate update methods for planar/non-planar modes.
 	  */
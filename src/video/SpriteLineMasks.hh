@@ -0,0 +1,93 @@
+#ifndef SPRITELINEMASKS_HH
+#define SPRITELINEMASKS_HH
+
+#include "xrange.hh"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <span>
+
+namespace openmsx {
+
+/** For each of the 256 display lines, the set of sprites that are (vertically)
+  * visible on that line. Bit 'n' of a mask corresponds to sprite number 'n'.
+  *
+  * A sprite with Y-coordinate 'y' and (magnified) height 'magSize' covers the
+  * display lines 'displayLine' for which ((displayLine - y) & 255) < magSize.
+  * Only the sprites before the first sprite with the terminating Y-coordinate
+  * (208 or 216) are active.
+  *
+  * This is used by SpriteChecker, so that it doesn't have to scan the whole
+  * sprite attribute table each time it checks a (small) range of lines. The
+  * masks are updated incrementally: only the lines covered by the sprites that
+  * actually changed (or became (in)active) are recalculated.
+  */
+class SpriteLineMasks
+{
+public:
+	/** Update the masks for the new sprite attributes.
+	  * @param ys The Y-coordinates of all 32 sprites.
+	  * @param count The number of active sprites [0..32].
+	  * @param magSize Height of the sprites in lines: 8, 16 or 32.
+	  */
+	void update(std::span<const uint8_t, 32> ys, unsigned count, unsigned magSize)
+	{
+		assert(count <= 32);
+		if (magSize != cachedMagSize) {
+			// All lines change, start over.
+			std::ranges::fill(masks, 0);
+			cachedMagSize = magSize;
+			cachedCount = 0;
+		}
+		for (auto sprite : xrange(std::max(count, cachedCount))) {
+			bool wasActive = sprite < cachedCount;
+			bool isActive  = sprite < count;
+			bool moved = ys[sprite] != cachedY[sprite];
+			if (wasActive && (!isActive || moved)) {
+				toggleLines(sprite, cachedY[sprite]);
+			}
+			if (isActive && (!wasActive || moved)) {
+				toggleLines(sprite, ys[sprite]);
+			}
+		}
+		std::ranges::copy(ys, cachedY.begin());
+		cachedCount = count;
+	}
+
+	/** The sprites visible on the given display line (taken modulo 256). */
+	[[nodiscard]] uint32_t getMask(int displayLine) const {
+		return masks[displayLine & 255];
+	}
+
+	/** The Y-coordinate of the given sprite, as passed to the last update(). */
+	[[nodiscard]] uint8_t getY(unsigned sprite) const {
+		return cachedY[sprite];
+	}
+
+	/** The sprite height, as passed to the last update(), or 0 if there
+	  * was no update yet.
+	  */
+	[[nodiscard]] unsigned getMagSize() const {
+		return cachedMagSize;
+	}
+
+private:
+	void toggleLines(unsigned sprite, uint8_t y) {
+		uint32_t bit = uint32_t(1) << sprite;
+		for (auto i : xrange(cachedMagSize)) {
+			masks[(y + i) & 255] ^= bit;
+		}
+	}
+
+private:
+	std::array<uint32_t, 256> masks = {};
+	std::array<uint8_t, 32> cachedY = {};
+	unsigned cachedCount = 0;
+	unsigned cachedMagSize = 0;
+};
+
+} // namespace openmsx
+
+#endif
@@ -1072,6 +1072,7 @@ void VDP::changeRegister(uint8_t reg, uint8_t val, EmuTime time)
 		if (change & 0x03) {
 			// Update sprites on size and mag changes.
 			spriteChecker->updateSpriteSizeMag(val, time);
+			renderer->updateSpriteSizeMag(val, time);
 		}
 		// TODO: Reset vertical IRQ if IE0 is reset?
 		if (change & DisplayMode::REG1_MASK) {
@@ -1356,12 +1357,13 @@ void VDP::updatePatternBase(EmuTime time)
 
 void VDP::updateSpriteAttributeBase(EmuTime time)
 {
+	unsigned baseMask = (controlRegs[11] << 15) | (controlRegs[5] << 7) | ~(~0u << 7);
+	renderer->updateSpriteAttributeBase(baseMask, time);
 	int mode = displayMode.getSpriteMode(isMSX1VDP());
 	if (mode == 0) {
 		vram->spriteAttribTable.disable(time);
 		return;
 	}
-	unsigned baseMask = (controlRegs[11] << 15) | (controlRegs[5] << 7) | ~(~0u << 7);
 	unsigned indexMask = mode == 1 ? ~0u << 7 : ~0u << 10;
 	if (displayMode.isPlanar()) {
 		baseMask = ((baseMask << 16) | (baseMask >> 1)) & 0x1FFFF;
@@ -1372,11 +1374,12 @@ void VDP::updateSpriteAttributeBase(EmuTime time)
 
 void VDP::updateSpritePatternBase(EmuTime time)
 {
+	unsigned baseMask = (controlRegs[6] << 11) | ~(~0u << 11);
+	renderer->updateSpritePatternBase(baseMask, time);
 	if (displayMode.getSpriteMode(isMSX1VDP()) == 0) {
 		vram->spritePatternTable.disable(time);
 		return;
 	}
-	unsigned baseMask = (controlRegs[6] << 11) | ~(~0u << 11);
 	unsigned indexMask = ~0u << 11;
 	if (displayMode.isPlanar()) {
 		baseMask = ((baseMask << 16) | (baseMask >> 1)) & 0x1FFFF;
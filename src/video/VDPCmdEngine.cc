@@ -1950,6 +1950,7 @@ void VDPCmdEngine::executeCommand(EmuTime time)
 	lastCOL = COL; lastARG = ARG; lastCMD = CMD;
 
 	// Start command.
+	++numCommands;
 	status |= CE;
 	executingProbe = true;
 	cmdProbe.signal(); // must be after executingProbe
@@ -176,6 +176,11 @@ public:
 		                     : std::tuple{-1, -1, -1, -1};
 	}
 
+	/** The number of commands that were started (since this object was
+	  * created, it's not serialized). Used to report emulation speed.
+	  */
+	[[nodiscard]] uint64_t getNumCommands() const { return numCommands; }
+
 	/** Interface for logical operations.
 	  */
 	template<typename Archive>
@@ -266,6 +271,9 @@ private:
 	  */
 	EmuTime statusChangeTime{EmuTime::infinity()};
 
+	/** See getNumCommands(). */
+	uint64_t numCommands{0};
+
 	/** Some commands execute multiple VRAM accesses per pixel
 	  * (e.g. LMMM does two reads and a write). This variable keeps
 	  * track of where in the (sub)command we are. */
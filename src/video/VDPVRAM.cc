@@ -110,6 +110,7 @@ VDPVRAM::VDPVRAM(VDP& vdp_, unsigned size, EmuTime time)
 	, physicalVRAMDebug(vdp, size)
 	, actualSize(size)
 	, vrMode(vdp.getVRMode())
+	, dirtyPages(size)
 	, cmdReadWindow(data)
 	, cmdWriteWindow(data)
 	, nameTable(data)
@@ -139,6 +140,8 @@ void VDPVRAM::clear()
 		// give the same value.
 		std::ranges::fill(subspan(data, actualSize), 0xFF);
 	}
+	dirtyPages.markAllDirty();
+	++bulkChangeCount;
 }
 
 void VDPVRAM::updateDisplayMode(DisplayMode mode, bool cmdBit, EmuTime time)
@@ -216,6 +219,8 @@ void VDPVRAM::updateVRMode(bool newVRmode, EmuTime time)
 			std::swap(data[i], data[swapAddr(i)]);
 		}
 	}
+	dirtyPages.markAllDirty();
+	++bulkChangeCount;
 }
 
 void VDPVRAM::setRenderer(Renderer* newRenderer, EmuTime time)
@@ -296,6 +301,8 @@ void VDPVRAM::change4k8kMapping(bool mapping8k)
 		}
 	}
 	copy_to_range(tmp, std::span{data});
+	dirtyPages.markAllDirty();
+	++bulkChangeCount;
 }
 
 
@@ -320,7 +327,7 @@ void VDPVRAM::serialize(Archive& ar, unsigned /*version*/)
 		setSizeMask(static_cast<MSXDevice&>(vdp).getCurrentTime());
 	}
 
-	ar.serialize_blob("data", std::span{data.data(), actualSize});
+	ar.serialize_blob("data", std::span{data.data(), actualSize}, dirtyPages);
 	ar.serialize("cmdReadWindow",       cmdReadWindow,
 	             "cmdWriteWindow",      cmdWriteWindow,
 	             "nameTable",           nameTable,
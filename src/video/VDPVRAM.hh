@@ -5,6 +5,7 @@
 #include "VDPCmdEngine.hh"
 #include "VRAMObserver.hh"
 
+#include "DirtyPages.hh"
 #include "Ram.hh"
 #include "SimpleDebuggable.hh"
 
@@ -562,6 +563,14 @@ public:
 	  */
 	void change4k8kMapping(bool mapping8k);
 
+	/** Incremented on every change that (potentially) modifies the whole
+	  * VRAM at once, without notifying the observers per address, see
+	  * clear(), updateVRMode() and change4k8kMapping().
+	  */
+	[[nodiscard]] unsigned getBulkChangeCount() const {
+		return bulkChangeCount;
+	}
+
 	/** Only used by debugger
 	 */
 	[[nodiscard]] std::span<const uint8_t> getData() const {
@@ -593,6 +602,7 @@ private:
 		spritePatternTable.notify(address, time);
 
 		data[address] = value;
+		dirtyPages.markDirty(address);
 
 		// Cache dirty marking should happen after the commit,
 		// otherwise the cache could be re-validated based on old state.
@@ -686,6 +696,12 @@ private:
 	  */
 	bool vrMode;
 
+	/** Pages of VRAM written since the last reverse snapshot.
+	  */
+	DirtyPages dirtyPages;
+
+	unsigned bulkChangeCount = 0;
+
 public:
 	VRAMWindow cmdReadWindow;
 	VRAMWindow cmdWriteWindow;
@@ -4,6 +4,7 @@
 
 #include "FrameSource.hh"
 #include "PixelOperations.hh"
+#include "ThreadPool.hh"
 
 #include "cstd.hh"
 #include "endian.hh"
@@ -18,6 +19,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <future>
 #include <tuple>
 
 namespace openmsx {
@@ -116,11 +118,14 @@ static inline void writePixel(
 }
 
 
-ZMBVEncoder::ZMBVEncoder(unsigned width_, unsigned height_)
+ZMBVEncoder::ZMBVEncoder(unsigned width_, unsigned height_, unsigned searchThreads)
 	: width(width_)
 	, height(height_)
 {
 	setupBuffers();
+	if (searchThreads) {
+		searchPool = std::make_unique<ThreadPool>(searchThreads);
+	}
 	memset(&zstream, 0, sizeof(zstream));
 	deflateInit(&zstream, 6); // compression level
 
@@ -143,6 +148,11 @@ ZMBVEncoder::ZMBVEncoder(unsigned width_, unsigned height_)
 	// Level 6 seems a good compromise between size/speed for THIS test.
 }
 
+ZMBVEncoder::~ZMBVEncoder()
+{
+	deflateEnd(&zstream);
+}
+
 void ZMBVEncoder::setupBuffers()
 {
 	static constexpr size_t pixelSize = sizeof(Pixel);
@@ -150,10 +160,8 @@ void ZMBVEncoder::setupBuffers()
 	pitch = width + 2 * MAX_VECTOR;
 	auto bufSize = (height + 2 * MAX_VECTOR) * pitch * pixelSize + 2048;
 
-	oldFrame.resize(bufSize);
-	newFrame.resize(bufSize);
-	std::ranges::fill(std::span{oldFrame}, 0);
-	std::ranges::fill(std::span{newFrame}, 0);
+	oldFrame = allocateFrame();
+	newFrame = allocateFrame();
 	work.resize(bufSize);
 	outputSize = neededSize();
 	output.resize(outputSize);
@@ -163,6 +171,7 @@ void ZMBVEncoder::setupBuffers()
 	size_t xBlocks = width / BLOCK_WIDTH;
 	size_t yBlocks = height / BLOCK_HEIGHT;
 	blockOffsets.resize(xBlocks * yBlocks);
+	blockVectors.resize(xBlocks * yBlocks);
 	for (auto y : xrange(yBlocks)) {
 		for (auto x : xrange(xBlocks)) {
 			blockOffsets[y * xBlocks + x] =
@@ -172,6 +181,15 @@ void ZMBVEncoder::setupBuffers()
 	}
 }
 
+ZMBVEncoder::FrameBuffer ZMBVEncoder::allocateFrame() const
+{
+	static constexpr size_t pixelSize = sizeof(Pixel);
+	FrameBuffer result((height + 2 * MAX_VECTOR) * pitch * pixelSize + 2048);
+	// the border is never written, so it remains black
+	std::ranges::fill(std::span{result}, 0);
+	return result;
+}
+
 unsigned ZMBVEncoder::neededSize() const
 {
 	static constexpr unsigned pixelSize = sizeof(Pixel);
@@ -179,7 +197,7 @@ unsigned ZMBVEncoder::neededSize() const
 	return f + f / 1000;
 }
 
-unsigned ZMBVEncoder::possibleBlock(int vx, int vy, size_t offset)
+unsigned ZMBVEncoder::possibleBlock(int vx, int vy, size_t offset) const
 {
 	int ret = 0;
 	const auto* pOld = &(std::bit_cast<const Pixel*>(oldFrame.data()))[offset + (vy * pitch) + vx];
@@ -194,7 +212,7 @@ unsigned ZMBVEncoder::possibleBlock(int vx, int vy, size_t offset)
 	return ret;
 }
 
-unsigned ZMBVEncoder::compareBlock(int vx, int vy, size_t offset)
+unsigned ZMBVEncoder::compareBlock(int vx, int vy, size_t offset) const
 {
 	int ret = 0;
 	const auto* pOld = &(std::bit_cast<const Pixel*>(oldFrame.data()))[offset + (vy * pitch) + vx];
@@ -226,20 +244,10 @@ void ZMBVEncoder::addXorBlock(int vx, int vy, size_t offset, unsigned& workUsed)
 	});
 }
 
-void ZMBVEncoder::addXorFrame(unsigned& workUsed)
+void ZMBVEncoder::searchRow(unsigned row, int& bestVx, int& bestVy)
 {
-	auto* vectors = std::bit_cast<int8_t*>(&work[workUsed]);
-
 	unsigned xBlocks = width / BLOCK_WIDTH;
-	unsigned yBlocks = height / BLOCK_HEIGHT;
-	unsigned blockCount = xBlocks * yBlocks;
-
-	// Align the following xor data on 4 byte boundary
-	workUsed = (workUsed + blockCount * 2 + 3) & ~3;
-
-	int bestVx = 0;
-	int bestVy = 0;
-	for (auto b : xrange(blockCount)) {
+	for (auto b : xrange(row * xBlocks, (row + 1) * xBlocks)) {
 		auto offset = blockOffsets[b];
 		// first try best vector of previous block
 		unsigned bestChange = compareBlock(bestVx, bestVy, offset);
@@ -259,11 +267,53 @@ void ZMBVEncoder::addXorFrame(unsigned& workUsed)
 				}
 			}
 		}
-		vectors[b * 2 + 0] = narrow<int8_t>(bestVx << 1);
-		vectors[b * 2 + 1] = narrow<int8_t>(bestVy << 1);
-		if (bestChange) {
+		blockVectors[b] = BlockVector{.x = narrow<int8_t>(bestVx),
+		                              .y = narrow<int8_t>(bestVy),
+		                              .changed = bestChange != 0};
+	}
+}
+
+void ZMBVEncoder::addXorFrame(unsigned& workUsed)
+{
+	auto* vectors = std::bit_cast<int8_t*>(&work[workUsed]);
+
+	unsigned xBlocks = width / BLOCK_WIDTH;
+	unsigned yBlocks = height / BLOCK_HEIGHT;
+	unsigned blockCount = xBlocks * yBlocks;
+
+	// Align the following xor data on 4 byte boundary
+	workUsed = (workUsed + blockCount * 2 + 3) & ~3;
+
+	// Motion search. Each block first tries the vector of the previous
+	// block. When the rows are searched in parallel, each row starts
+	// again from vector (0, 0). That (slightly) changes the result, but
+	// it's still a valid stream.
+	if (searchPool) {
+		std::vector<std::future<void>> rows;
+		rows.reserve(yBlocks);
+		for (auto row : xrange(yBlocks)) {
+			rows.push_back(searchPool->enqueue([this, row] {
+				int bestVx = 0;
+				int bestVy = 0;
+				searchRow(row, bestVx, bestVy);
+			}));
+		}
+		for (auto& r : rows) r.get();
+	} else {
+		int bestVx = 0;
+		int bestVy = 0;
+		for (auto row : xrange(yBlocks)) {
+			searchRow(row, bestVx, bestVy);
+		}
+	}
+
+	for (auto b : xrange(blockCount)) {
+		const auto& v = blockVectors[b];
+		vectors[b * 2 + 0] = narrow<int8_t>(v.x << 1);
+		vectors[b * 2 + 1] = narrow<int8_t>(v.y << 1);
+		if (v.changed) {
 			vectors[b * 2 + 0] |= 1;
-			addXorBlock(bestVx, bestVy, offset, workUsed);
+			addXorBlock(v.x, v.y, blockOffsets[b], workUsed);
 		}
 	}
 }
@@ -300,9 +350,28 @@ const ZMBVEncoder::Pixel* ZMBVEncoder::getScaledLine(const FrameSource* frame, u
 	}
 }
 
-std::span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame, const FrameSource* frame)
+void ZMBVEncoder::captureFrame(const FrameSource* frame, FrameBuffer& buffer) const
+{
+	// Copy lines to the inner area, the border remains black. Often the
+	// scaled line is directly produced in the destination buffer.
+	static constexpr size_t pixelSize = sizeof(Pixel);
+	auto linePitch = pitch * pixelSize;
+	auto lineWidth = size_t(width) * pixelSize;
+	uint8_t* dest =
+		&buffer[pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch)];
+	for (auto i : xrange(height)) {
+		const auto* scaled = std::bit_cast<const uint8_t*>(
+			getScaledLine(frame, i, std::bit_cast<Pixel*>(dest)));
+		if (scaled != dest) memcpy(dest, scaled, lineWidth);
+		dest += linePitch;
+	}
+}
+
+std::span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame, FrameBuffer& frame)
 {
+	assert(frame.size() == newFrame.size());
 	std::swap(newFrame, oldFrame); // replace oldFrame with newFrame
+	std::swap(newFrame, frame);    // hand out the frame before that for reuse
 
 	// Reset the work buffer
 	unsigned workUsed = 0;
@@ -326,19 +395,6 @@ std::span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame, const FrameSo
 		deflateReset(&zstream); // restart deflate
 	}
 
-	// copy lines (to add black border)
-	static constexpr size_t pixelSize = sizeof(Pixel);
-	auto linePitch = pitch * pixelSize;
-	auto lineWidth = size_t(width) * pixelSize;
-	uint8_t* dest =
-		&newFrame[pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch)];
-	for (auto i : xrange(height)) {
-		const auto* scaled = std::bit_cast<const uint8_t*>(
-			getScaledLine(frame, i, std::bit_cast<Pixel*>(dest)));
-		if (scaled != dest) memcpy(dest, scaled, lineWidth);
-		dest += linePitch;
-	}
-
 	// Add the frame data.
 	if (keyFrame) {
 		// Key frame: full frame data.
@@ -7,14 +7,17 @@
 #include "aligned.hh"
 
 #include <cstdint>
+#include <memory>
 #include <span>
 #include <string_view>
+#include <vector>
 
 #include <zlib.h>
 
 namespace openmsx {
 
 class FrameSource;
+class ThreadPool;
 
 class ZMBVEncoder
 {
@@ -22,31 +25,59 @@ public:
 	static constexpr std::string_view CODEC_4CC = "ZMBV";
 	using Pixel = uint32_t;
 
-	ZMBVEncoder(unsigned width, unsigned height);
+	/** A captured frame, in the layout the encoder works on directly
+	  * (surrounded by a black border for the motion search). Create it
+	  * with allocateFrame() and fill it with captureFrame().
+	  */
+	using FrameBuffer = MemBuffer<uint8_t, SSE_ALIGNMENT>;
+
+	/** @param searchThreads When non-zero, the motion search of each
+	  *        frame is split per row of blocks over this many threads.
+	  */
+	ZMBVEncoder(unsigned width, unsigned height, unsigned searchThreads = 0);
 	ZMBVEncoder(const ZMBVEncoder&) = delete;
 	ZMBVEncoder(ZMBVEncoder&&) = delete;
 	ZMBVEncoder& operator=(const ZMBVEncoder&) = delete;
 	ZMBVEncoder& operator=(ZMBVEncoder&&) = delete;
-	~ZMBVEncoder() = default;
+	~ZMBVEncoder();
+
+	/** These two only depend on the frame size, so they can be used from
+	  * another thread than the one that calls compressFrame().
+	  */
+	[[nodiscard]] FrameBuffer allocateFrame() const;
+	void captureFrame(const FrameSource* frame, FrameBuffer& buffer) const;
 
-	[[nodiscard]] std::span<const uint8_t> compressFrame(bool keyFrame, const FrameSource* frame);
+	/** Compress a frame that was captured with captureFrame().
+	  * The encoder keeps (the content of) 'frame' as reference for the next
+	  * frame, in return 'frame' gets another buffer (with unspecified
+	  * content), that can be reused for a next capture.
+	  */
+	[[nodiscard]] std::span<const uint8_t> compressFrame(bool keyFrame, FrameBuffer& frame);
 
 private:
+	struct BlockVector {
+		int8_t x, y;
+		bool changed;
+	};
+
 	void setupBuffers();
 	[[nodiscard]] unsigned neededSize() const;
 	void addFullFrame(unsigned& workUsed);
 	void addXorFrame (unsigned& workUsed);
-	[[nodiscard]] unsigned possibleBlock(int vx, int vy, size_t offset);
-	[[nodiscard]] unsigned compareBlock(int vx, int vy, size_t offset);
+	void searchRow(unsigned row, int& bestVx, int& bestVy);
+	[[nodiscard]] unsigned possibleBlock(int vx, int vy, size_t offset) const;
+	[[nodiscard]] unsigned compareBlock(int vx, int vy, size_t offset) const;
 	void addXorBlock(int vx, int vy, size_t offset, unsigned& workUsed);
 	[[nodiscard]] const Pixel* getScaledLine(const FrameSource* frame, unsigned y, Pixel* workBuf) const;
 
 private:
-	MemBuffer<uint8_t, SSE_ALIGNMENT> oldFrame;
-	MemBuffer<uint8_t, SSE_ALIGNMENT> newFrame;
+	FrameBuffer oldFrame;
+	FrameBuffer newFrame;
 	MemBuffer<uint8_t, SSE_ALIGNMENT> work;
 	MemBuffer<uint8_t> output;
 	MemBuffer<size_t> blockOffsets;
+	std::vector<BlockVector> blockVectors;
+	std::unique_ptr<ThreadPool> searchPool; // can be nullptr
 	unsigned outputSize;
 
 	z_stream zstream;